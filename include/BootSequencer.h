@@ -0,0 +1,51 @@
+#ifndef BOOT_SEQUENCER_H
+#define BOOT_SEQUENCER_H
+
+#pragma once
+#include <Arduino.h>
+
+struct BootPhase
+{
+    const char *name;
+    // micros() since reset
+    uint32_t startUs;
+    uint32_t durationUs;
+};
+
+/**
+ * @brief Timestamps the phases of a boot so the time to the first sample can be measured.
+ *
+ * setup() calls phase() at the start of every step, which closes the previous one. Work that
+ * finishes after setup() has returned, such as the WiFi connection, is added with record().
+ */
+class BootSequencer
+{
+public:
+    static constexpr uint8_t kMaxPhases = 16;
+
+    // Close the open phase, if any, and open a new one
+    void phase(const char *name);
+    // Close the open phase, setup() is done
+    void finish();
+    // Add a phase that started at startUs and ends now
+    void record(const char *name, uint32_t startUs);
+    // First complete sample generation, only the first call counts
+    void markFirstSample();
+
+    uint8_t count() const;
+    const BootPhase &at(uint8_t index) const;
+    uint32_t setupUs() const;
+    // 0 until the event happened
+    uint32_t firstSampleUs() const;
+
+private:
+    BootPhase phases[kMaxPhases];
+    uint8_t phaseCount = 0;
+    bool open = false;
+    uint32_t setupDoneUs = 0;
+    uint32_t firstSampleAtUs = 0;
+
+    void close(uint32_t now);
+};
+
+#endif
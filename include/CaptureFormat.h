@@ -0,0 +1,46 @@
+#ifndef CAPTURE_FORMAT_H
+#define CAPTURE_FORMAT_H
+
+#pragma once
+#include <stdint.h>
+
+// Shared by the firmware and tools/replay, keep it free of Arduino types.
+// All fields are little-endian, which is the native order of both the ESP8266 and x86/ARM hosts.
+
+constexpr uint32_t kCaptureMagic = 0x43523353; // "S3RC"
+constexpr uint8_t kCaptureVersion = 1;
+constexpr uint8_t kCaptureRegisterCount = 9;
+// CaptureRecord::result of a port whose chip did not answer the probe, otherwise SW35xx::result_t
+constexpr uint8_t kCapturePortAbsent = 0xFF;
+
+// SW35xx register of each CaptureRecord::registers byte, SW35xx::rawRegister_t order
+constexpr uint8_t kCaptureRegisters[kCaptureRegisterCount] = {0x32, 0x30, 0x31, 0x35, 0x33, 0x34, 0x06, 0x37, 0x38};
+
+struct __attribute__((packed)) CaptureHeader
+{
+    uint32_t magic;
+    uint8_t version;
+    uint8_t recordSize;
+    uint8_t portCount;
+    uint8_t reserved;
+    uint32_t chipId;
+    // Sample period while recording, energy is integrated with it
+    uint32_t sampleIntervalMs;
+    // millis() when the capture started, record times are relative to it
+    uint32_t startMs;
+};
+
+// One port read as samplePort() saw it
+struct __attribute__((packed)) CaptureRecord
+{
+    uint32_t timeMs;
+    uint8_t port;
+    uint8_t result;
+    // Raw register bytes, only meaningful when result is 0
+    uint8_t registers[kCaptureRegisterCount];
+};
+
+static_assert(sizeof(CaptureHeader) == 20, "CaptureHeader layout changed");
+static_assert(sizeof(CaptureRecord) == 15, "CaptureRecord layout changed");
+
+#endif
@@ -5,6 +5,7 @@
 #include <Arduino.h>
 #include <OneButton.h>
 #include "defines.h"
+#include "Parameters.h"
 
 class Config
 {
@@ -17,12 +18,32 @@ public:
     float totalEnergy3 = 0;
     float totalEnergy4 = 0;
 
+    // MQTT telemetry, disabled until a broker is configured
+    bool mqttEnabled = false;
+    String mqttHost = "";
+    uint16_t mqttPort = 1883;
+    String mqttUser = "";
+    String mqttPassword = "";
+    uint32_t mqttInterval = kMqttPublishInterval;
+
+    // UDP fleet telemetry, empty address means LAN broadcast
+    bool udpEnabled = false;
+    String udpAddress = "";
+
+    // File listing and I2C scan on the next boots, off for a fast boot
+    bool bootDiagnostics = false;
+
+    // Sampling, fan and NTC tunables, replaced as a whole by PATCH /config
+    Parameters parameters;
+
     OneButton *button = nullptr;
     callbackFunction buttonClickedCallback = NULL;
     callbackFunction buttonDoubleClickedCallback = NULL;
     callbackFunction buttonLongPressedCallback = NULL;
 
     void saveConfig();
+    // Write the config only if energy counters changed since the last save
+    void saveConfigIfNeeded();
     bool loadConfig();
     // Port 0 -> 1
     void updateTotalEnergy(float energy, int port);
@@ -41,6 +62,7 @@ public:
 
 private:
     bool state = true;
+    bool dirty = false;
     String serverName = kServerName;
 };
 
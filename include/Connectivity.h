@@ -0,0 +1,72 @@
+#ifndef CONNECTIVITY_H
+#define CONNECTIVITY_H
+
+#pragma once
+#include <Arduino.h>
+#include "defines.h"
+#include "Scheduler.h"
+
+class AsyncWiFiManager;
+
+enum LinkState : uint8_t
+{
+    LINK_OFFLINE = 0, // waiting for the next attempt
+    LINK_CONNECTING,  // WiFi.begin() issued, waiting for an address
+    LINK_ONLINE,
+    LINK_PORTAL       // no saved network, the setup portal is open next to the station
+};
+
+struct ConnectivityStats
+{
+    uint32_t attempts = 0;
+    uint32_t connects = 0;
+    uint32_t drops = 0;
+    // millis() of the last link change
+    uint32_t changedAt = 0;
+    uint32_t offlineMs = 0;
+};
+
+/**
+ * @brief Keeps the station connected without ever blocking loop().
+ *
+ * Driven from a scheduler task. A failed attempt or a dropped link schedules the next
+ * WiFi.begin() after a delay that doubles from kWifiBackoffMin up to kWifiBackoffMax, and
+ * the SDK auto reconnect is turned off so it does not fight that schedule. Without saved
+ * credentials the WiFi manager portal runs modeless, so sampling continues while it is open.
+ * After kWifiPortalAfterFailures failed attempts in a row the portal opens as well, and the
+ * saved network is still retried on the same schedule until either of them connects.
+ */
+class Connectivity
+{
+public:
+    // onLinkUp runs from loop() after every successful connection
+    void begin(AsyncWiFiManager *manager, const String &portalName, TaskCallback onLinkUp);
+    void loop();
+
+    LinkState state() const;
+    bool isOnline() const;
+    uint32_t backoff() const;
+    bool portalOpen() const;
+    const ConnectivityStats &stats() const;
+
+private:
+    AsyncWiFiManager *manager = nullptr;
+    String portalName;
+    TaskCallback onLinkUp = nullptr;
+
+    LinkState linkState = LINK_OFFLINE;
+    uint32_t attemptStart = 0;
+    uint32_t nextAttempt = 0;
+    uint32_t backoffMs = kWifiBackoffMin;
+    uint8_t failures = 0;
+    bool portal = false;
+    ConnectivityStats linkStats;
+
+    void attempt(uint32_t now);
+    void openPortal();
+    void linkUp(uint32_t now);
+    void linkDown(uint32_t now);
+    void setState(LinkState state, uint32_t now);
+};
+
+#endif
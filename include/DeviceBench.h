@@ -0,0 +1,118 @@
+#ifndef DEVICE_BENCH_H
+#define DEVICE_BENCH_H
+
+#pragma once
+#include <Arduino.h>
+#include <FS.h>
+#include "defines.h"
+#include "I2CQueue.h"
+#include "PortSnapshot.h"
+#include "Scheduler.h"
+
+enum DeviceBenchState : uint8_t
+{
+    BENCH_IDLE = 0,
+    BENCH_I2C,
+    BENCH_DISPLAY,
+    BENCH_FS_WRITE,
+    BENCH_FS_READ,
+    BENCH_JSON,
+    BENCH_DONE
+};
+
+struct BenchLatency
+{
+    uint32_t count = 0;
+    uint32_t minUs = 0;
+    uint32_t maxUs = 0;
+    uint64_t totalUs = 0;
+
+    void add(uint32_t us);
+    uint32_t averageUs() const;
+};
+
+struct DeviceBenchResults
+{
+    // Mux channel 0 is the display, timed with a command write, 1 to 4 the chargers with a read
+    BenchLatency i2c[kBenchChannels];
+    uint16_t i2cFailures[kBenchChannels] = {0};
+    BenchLatency displayPage;
+    // Bus time of the eight page jobs of a pass added up, the queue waits between them excluded
+    BenchLatency displayPagesSum;
+    uint32_t fsWriteBytesPerSecond = 0;
+    uint32_t fsReadBytesPerSecond = 0;
+    BenchLatency json;
+    BenchLatency loop;
+    // Phases that gave up after kBenchPhaseTimeout, bit per DeviceBenchState
+    uint8_t timedOut = 0;
+    // Overruns of the watched task while the suite ran
+    uint32_t overruns = 0;
+    uint32_t durationMs = 0;
+};
+
+/**
+ * @brief Bounded self benchmark, advanced one small step per step() call.
+ *
+ * Bus work is queued on I2CQueue at display priority, so charger samples still run first, and
+ * flash work is cut into kBenchStepBytes pieces, so no single step holds loop() long enough
+ * for the sample task to miss its deadline. The display is flushed from its current buffer.
+ */
+class DeviceBench
+{
+public:
+    DeviceBench(I2CQueue &queue);
+
+    /**
+     * @param displayPage Writes one display page, run as an I2CQueue job on channel 0
+     * @param watched Stats whose overruns are reported, normally the sample generations that run
+     *                through the queue
+     */
+    void begin(I2CJobCallback displayPage, const SnapshotBuffer<MonitorSnapshot> &snapshot, const TaskStats *watched);
+    // False if a run is already in progress
+    bool start();
+    // Run from a low priority scheduler task
+    void step();
+    // Call once per loop() to time loop iterations while a run is in progress
+    void loopTick();
+
+    DeviceBenchState state() const;
+    bool isRunning() const;
+    const DeviceBenchResults &results() const;
+
+private:
+    I2CQueue &queue;
+    I2CJobCallback displayPage = nullptr;
+    const SnapshotBuffer<MonitorSnapshot> *snapshot = nullptr;
+    const TaskStats *watched = nullptr;
+
+    DeviceBenchState benchState = BENCH_IDLE;
+    DeviceBenchResults benchResults;
+    uint32_t startedAt = 0;
+    uint32_t phaseStartedAt = 0;
+    uint32_t overrunsAtStart = 0;
+    uint32_t lastLoopUs = 0;
+
+    // Jobs submitted and finished in the current bus phase
+    uint8_t submitted = 0;
+    uint8_t completed = 0;
+    uint8_t pass = 0;
+    uint32_t passUs = 0;
+
+    File file;
+    uint32_t fileOffset = 0;
+    uint32_t fileUs = 0;
+
+    static DeviceBench *active;
+    static void readChannel(uint8_t channel, bool selected);
+    static void flushPage(uint8_t page, bool selected);
+
+    void enter(DeviceBenchState state);
+    bool timedOut();
+    void stepI2C();
+    void stepDisplay();
+    void stepWrite();
+    void stepRead();
+    void stepJson();
+};
+
+#endif
@@ -10,6 +10,7 @@
 #endif
 
 #include <ESPAsyncWebServer.h>
+#include "UploadSink.h"
 
 class Emoticons {
 
@@ -17,10 +18,11 @@ public:
     Emoticons();
     ~Emoticons();
 
+    // Draws a random emoticon into the frame buffer only, the caller queues the flush
     bool draw(SCREEN_CLASS *display, int screen_width, int screen_height, int px_color_white, int px_color_black);
     void addListener(AsyncWebServer *server);
 
-    File uploadFile;
+    UploadSink uploadSink;
 private : std::vector<String> emoticons;
     void loadEmoticons();
 };
\ No newline at end of file
@@ -0,0 +1,113 @@
+#ifndef HISTORY_QUERY_H
+#define HISTORY_QUERY_H
+
+#pragma once
+#include <Arduino.h>
+#include "HistoryStore.h"
+
+enum HistoryQueryMode : uint8_t
+{
+    HISTORY_QUERY_MINMAX = 0, // min/avg/max of voltage and current per time bucket
+    HISTORY_QUERY_LTTB        // one representative point per bucket for a single series
+};
+
+enum HistorySeries : uint8_t
+{
+    HISTORY_SERIES_VOLTAGE = 0, // mV
+    HISTORY_SERIES_CURRENT,     // mA
+    HISTORY_SERIES_POWER        // mW
+};
+
+struct HistoryRow
+{
+    uint32_t time;
+    uint16_t count;
+    uint16_t voltageMin;
+    uint16_t voltageAvg;
+    uint16_t voltageMax;
+    uint16_t currentMin;
+    uint16_t currentAvg;
+    uint16_t currentMax;
+    // Average power in mW for HISTORY_QUERY_MINMAX, the selected value for HISTORY_QUERY_LTTB
+    uint32_t value;
+};
+
+/**
+ * @brief Reduces one port of a history range to about `points` rows in a single pass.
+ *
+ * The range is split into equal time buckets. HISTORY_QUERY_MINMAX emits the min/avg/max of
+ * each bucket. HISTORY_QUERY_LTTB runs Largest-Triangle-Three-Buckets over MinMax
+ * preselected candidates (the min and max of kSubBuckets slices per bucket), which only needs
+ * the candidates of one bucket and the running average of the next, so memory stays fixed
+ * however many points a bucket covers.
+ */
+class HistoryQuery
+{
+public:
+    void begin(uint8_t port, uint32_t from, uint32_t to, uint16_t points, HistoryQueryMode mode, HistorySeries series);
+
+    void add(const HistoryPoint &point);
+    // Flush the buckets still open once the cursor is exhausted
+    void finish();
+    // Next output row, false when none is ready yet
+    bool pop(HistoryRow &row);
+
+    uint32_t bucketSeconds() const;
+
+private:
+    static constexpr uint8_t kSubBuckets = 4;
+    static constexpr uint8_t kOutputSize = 4;
+
+    struct Candidate
+    {
+        uint32_t time;
+        uint32_t value;
+    };
+
+    struct Bucket
+    {
+        uint32_t index;
+        uint16_t count;
+        uint16_t voltageMin;
+        uint16_t voltageMax;
+        uint16_t currentMin;
+        uint16_t currentMax;
+        uint32_t voltageSum;
+        uint32_t currentSum;
+        uint64_t powerSum;
+        uint64_t timeSum;
+        uint64_t valueSum;
+        Candidate low[kSubBuckets];
+        Candidate high[kSubBuckets];
+        bool used[kSubBuckets];
+    };
+
+    uint8_t port = 0;
+    uint32_t from = 0;
+    uint32_t bucketLength = kHistoryInterval;
+    HistoryQueryMode mode = HISTORY_QUERY_MINMAX;
+    HistorySeries series = HISTORY_SERIES_POWER;
+
+    Bucket current;
+    Bucket previous;
+    bool hasCurrent = false;
+    bool hasPrevious = false;
+
+    // Last selected LTTB point, the first vertex of the next triangle
+    Candidate anchor;
+    bool hasAnchor = false;
+    Candidate last;
+
+    HistoryRow output[kOutputSize];
+    uint8_t outputHead = 0;
+    uint8_t outputCount = 0;
+
+    void startBucket(uint32_t index);
+    void closeBucket();
+    void select(const Bucket &bucket, uint64_t nextTime, uint64_t nextValue);
+    void push(const HistoryRow &row);
+    void pushPoint(const Candidate &candidate);
+    uint32_t valueOf(const HistoryPoint &point) const;
+};
+
+#endif
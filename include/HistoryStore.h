@@ -0,0 +1,174 @@
+#ifndef HISTORY_STORE_H
+#define HISTORY_STORE_H
+
+#pragma once
+#include <Arduino.h>
+#include <FS.h>
+#include <vector>
+#include "defines.h"
+#include "SeriesCodec.h"
+
+constexpr uint8_t kHistoryPorts = 4;
+// Voltages of all ports, then currents
+constexpr uint8_t kHistoryChannels = kHistoryPorts * 2;
+
+// One kHistoryInterval bucket, values are averaged over the samples that fell into it
+struct HistoryPoint
+{
+    // Unix time of the bucket start
+    uint32_t time;
+    uint16_t voltage_mV[kHistoryPorts];
+    uint16_t current_mA[kHistoryPorts];
+};
+
+enum HistoryEncoding : uint8_t
+{
+    // 0 is left unused, it never describes a block this firmware can read
+    HISTORY_SERIES = 1, // SeriesEncoder stream of kHistoryChannels channels
+};
+
+// Precedes every block in a segment file
+struct __attribute__((packed)) HistoryBlockHeader
+{
+    uint32_t firstTime;
+    uint32_t lastTime;
+    uint16_t count;
+    uint16_t length;
+    uint8_t encoding;
+    uint8_t reserved;
+    // Fletcher-16 of the payload, a torn append fails this check
+    uint16_t checksum;
+};
+
+// Sparse index entry, one per block
+struct __attribute__((packed)) HistoryIndexEntry
+{
+    uint32_t firstTime;
+    uint32_t offset;
+};
+
+// Encoded points, the same bytes are kept in RAM and appended to flash
+struct HistoryBlock
+{
+    uint8_t data[kHistoryBlockBytes];
+    uint16_t length = 0;
+    uint16_t count = 0;
+    uint32_t firstTime = 0;
+    uint32_t lastTime = 0;
+};
+
+struct HistoryStats
+{
+    uint32_t pointsWritten = 0;
+    uint32_t blocksWritten = 0;
+    uint32_t blocksDropped = 0;
+    uint32_t unsyncedSamples = 0;
+    uint32_t segmentsDropped = 0;
+    uint32_t lastFlushUs = 0;
+    uint32_t maxFlushUs = 0;
+};
+
+/**
+ * @brief Persistent per-port history in /history.
+ *
+ * Samples are averaged into kHistoryInterval points and encoded with SeriesEncoder into RAM
+ * blocks of up to kHistoryBlockPoints points or kHistoryBlockBytes bytes; flush() appends
+ * sealed blocks from a low priority task, so the sampling path never waits on flash.
+ * Each kHistorySegmentSeconds window has its own append-only "<window>.seg" file plus a
+ * "<window>.idx" file holding one (firstTime, offset) entry per block, which is binary searched
+ * to start a range read. The oldest segments are removed past kHistoryRetentionDays or when
+ * the filesystem runs low.
+ */
+class HistoryStore
+{
+public:
+    void begin();
+
+    // Feed one sample generation, points are only kept once NTP has set the clock
+    void record(const uint16_t voltage_mV[kHistoryPorts], const uint16_t current_mA[kHistoryPorts]);
+    // Write sealed blocks to flash
+    void flush();
+
+    const std::vector<uint32_t> &segments() const;
+    const HistoryStats &stats() const;
+    uint8_t sealedCount() const;
+    const HistoryBlock &sealed(uint8_t index) const;
+    const HistoryBlock &current() const;
+
+    static String segmentPath(uint32_t window);
+    static String indexPath(uint32_t window);
+
+private:
+    // Sealed blocks waiting for flush(), the oldest is dropped when flash falls behind
+    static constexpr uint8_t kSealedSize = 2;
+
+    std::vector<uint32_t> windows;
+    HistoryBlock blocks[kSealedSize];
+    uint8_t sealedHead = 0;
+    uint8_t sealedBlocks = 0;
+    HistoryBlock open;
+    SeriesEncoder encoder;
+
+    uint32_t bucket = 0;
+    uint32_t sums[kHistoryChannels] = {0};
+    uint16_t samples = 0;
+
+    HistoryStats historyStats;
+
+    void closeBucket();
+    bool append(const HistoryPoint &point);
+    void seal();
+    bool write(const HistoryBlock &block);
+    void recover(uint32_t window);
+    void enforceRetention(uint32_t now);
+    void dropOldest();
+};
+
+/**
+ * @brief Reads the points of [from, to] in time order, from flash first and then from RAM.
+ *
+ * Only one decoded block is held at a time, so memory use does not depend on the range.
+ * Between two next() calls the store may flush, seal or drop segments, so the cursor keeps
+ * no positions into it: segments are found again by window, files are reopened at a byte
+ * offset, and RAM blocks are picked by time.
+ */
+class HistoryCursor
+{
+public:
+    HistoryCursor(const HistoryStore &store, uint32_t from, uint32_t to);
+
+    bool next(HistoryPoint &point);
+
+private:
+    const HistoryStore &store;
+    uint32_t from;
+    uint32_t to;
+    // Last point returned, RAM blocks may have been flushed meanwhile and must not repeat
+    uint32_t lastTime = 0;
+    bool hasLast = false;
+
+    // Segment being read and the offset of its next block header
+    uint32_t window = 0;
+    uint32_t offset = 0;
+    bool inSegment = false;
+    // lastTime of the RAM block decoded last, the next one has to end after it
+    uint32_t ramLast = 0;
+    bool ramLoaded = false;
+
+    HistoryBlock block;
+    SeriesDecoder decoder;
+
+    uint32_t resumeTime() const;
+    bool nextInBlock(HistoryPoint &point);
+    void startBlock();
+    bool openSegment();
+    bool readBlock();
+    bool loadRamBlock();
+    static uint32_t seekIndex(const String &path, uint32_t time);
+};
+
+uint16_t historyChecksum(const uint8_t *data, size_t length);
+void historyToChannels(const HistoryPoint &point, uint16_t *values);
+void historyFromChannels(uint32_t time, const uint16_t *values, HistoryPoint &point);
+
+#endif
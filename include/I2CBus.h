@@ -0,0 +1,97 @@
+#ifndef I2C_BUS_H
+#define I2C_BUS_H
+
+#pragma once
+#include <Arduino.h>
+#include <Wire.h>
+#include "defines.h"
+
+enum I2CTarget : uint8_t
+{
+    I2C_TARGET_DISPLAY = 0,
+    I2C_TARGET_CHARGER,
+    I2C_TARGET_COUNT
+};
+
+struct I2CChannelStats
+{
+    uint32_t transactions = 0;
+    uint32_t naks = 0;
+    uint32_t timeouts = 0;
+    uint32_t recoveries = 0;
+};
+
+struct I2CBenchResult
+{
+    uint32_t clock = 0;
+    uint16_t attempts = 0;
+    uint16_t failures = 0;
+    uint32_t elapsedUs = 0;
+    uint32_t transactionsPerSecond = 0;
+};
+
+/**
+ * @brief Owns the TCA9548 mux and the bus clock for the display and the SW35xx chargers.
+ *
+ * Every transaction goes through select() so the clock matches the device behind the channel,
+ * and its result is reported back with record() so errors are counted per mux channel. A
+ * timeout on a bus whose SDA is held low triggers a recovery by clocking SCL.
+ */
+class I2CBus
+{
+public:
+    static constexpr uint8_t kChannels = 8;
+    static constexpr uint8_t kBenchSpeeds = 3;
+
+    I2CBus(TwoWire &wire, uint8_t muxAddress, uint8_t sdaPin = SDA, uint8_t sclPin = SCL);
+
+    void begin();
+    void setClock(I2CTarget target, uint32_t clock);
+    uint32_t clockOf(I2CTarget target) const;
+
+    /**
+     * @brief Switch the mux to a channel and apply the clock of the target behind it
+     */
+    bool select(uint8_t channel, I2CTarget target);
+    uint8_t channel() const;
+
+    /**
+     * @brief Account the result of endTransmission() on the current channel
+     * @return true if the transaction succeeded
+     */
+    bool record(uint8_t error);
+    // Address-only transaction on the current channel
+    bool probe(uint8_t address);
+
+    bool isStuck() const;
+    // Free a slave that holds SDA low by clocking SCL and issuing a STOP
+    bool recover();
+
+    const I2CChannelStats &stats(uint8_t channel) const;
+
+    // Clear the results before the first batch of a new benchmark
+    void beginBenchmark();
+    /**
+     * @brief Time a batch of register reads on the selected channel at one of the bench speeds
+     *
+     * Meant to run as an I2CQueue job, the batches of one speed add up in benchResult(speed).
+     * The clock of target is applied again afterwards.
+     */
+    void benchmarkBatch(uint8_t speed, I2CTarget target, uint8_t address, uint8_t reg, uint16_t count);
+    const I2CBenchResult &benchResult(uint8_t index) const;
+
+private:
+    TwoWire &wire;
+    uint8_t muxAddress;
+    uint8_t sdaPin;
+    uint8_t sclPin;
+    uint8_t currentChannel = 0xFF;
+    uint32_t currentClock = 0;
+    uint32_t clocks[I2C_TARGET_COUNT] = {kI2CChargerClock, kI2CChargerClock};
+    I2CChannelStats channelStats[kChannels];
+    I2CBenchResult benchResults[kBenchSpeeds];
+
+    void applyClock(uint32_t clock);
+};
+
+#endif
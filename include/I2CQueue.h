@@ -0,0 +1,75 @@
+#ifndef I2C_QUEUE_H
+#define I2C_QUEUE_H
+
+#pragma once
+#include <Arduino.h>
+#include "I2CBus.h"
+
+enum I2CPriority : uint8_t
+{
+    I2C_PRIORITY_CHARGER = 0,
+    I2C_PRIORITY_DISPLAY,
+    I2C_PRIORITY_COUNT
+};
+
+// selected is false when the mux could not be switched to the job's channel; the callback must
+// not touch the bus then, but still runs so its owner can account the failure
+typedef void (*I2CJobCallback)(uint8_t arg, bool selected);
+
+struct I2CQueueStats
+{
+    uint32_t jobs = 0;
+    uint32_t dropped = 0;
+    // Jobs run without the bus because the mux did not switch
+    uint32_t unselected = 0;
+    uint32_t lastDelayUs = 0;
+    uint32_t maxDelayUs = 0;
+    uint64_t totalDelayUs = 0;
+};
+
+/**
+ * @brief Arbitrates the shared bus between the charger reads and the display.
+ *
+ * Jobs are short transactions bound to a mux channel; the queue selects the channel (and with
+ * it the clock) right before each job, so no caller touches the mux directly. Charger jobs
+ * always run before display jobs, and display flushes are queued one page per job, so a full
+ * flush can be preempted between pages by a sample.
+ */
+class I2CQueue
+{
+public:
+    static constexpr uint8_t kCapacity = 16;
+
+    I2CQueue(I2CBus &bus);
+
+    bool submit(I2CPriority priority, uint8_t channel, I2CTarget target, I2CJobCallback callback, uint8_t arg = 0);
+    /**
+     * @brief Run queued jobs, highest priority first, until the queue is empty or the budget is spent
+     */
+    void pump(uint32_t budgetUs);
+    uint8_t pending(I2CPriority priority) const;
+    const I2CQueueStats &stats(I2CPriority priority) const;
+
+private:
+    struct Job
+    {
+        I2CJobCallback callback;
+        uint32_t enqueuedUs;
+        uint8_t channel;
+        I2CTarget target;
+        uint8_t arg;
+    };
+
+    struct Ring
+    {
+        Job jobs[kCapacity];
+        uint8_t head = 0;
+        uint8_t count = 0;
+    };
+
+    I2CBus &bus;
+    Ring rings[I2C_PRIORITY_COUNT];
+    I2CQueueStats queueStats[I2C_PRIORITY_COUNT];
+};
+
+#endif
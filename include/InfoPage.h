@@ -0,0 +1,37 @@
+#ifndef INFO_PAGE_H
+#define INFO_PAGE_H
+
+#pragma once
+#include <Arduino.h>
+#include "PortItem.h"
+#include "TextLayer.h"
+
+/**
+ * @brief The port information page: scrolling header, module temperature and one line per
+ * port that alternates between power and protocol. Shared by displayInfo() and the host
+ * benchmarks, so both time and draw the same frame.
+ */
+class InfoPage
+{
+public:
+    void begin();
+    // Re-render the header marquee, only needed when its text changed
+    void setHeader(const String &text);
+    bool hasHeader() const;
+    // Header marquee, temperature and the separator line under them
+    void drawHeader(const FrameBuffer &frame, float temperature);
+    // Line of port `index`, every active port drawn advances the page cycle
+    void drawPort(const FrameBuffer &frame, uint8_t index, const PortItem &port);
+
+private:
+    GlyphAtlas glyphs;
+    TextStrip headerStrip;
+    TextStrip protocolStrips[4];
+    // Unpadded text of each protocol strip, what the port's protocol is compared against
+    String protocolTexts[4];
+    uint16_t headerOffset = 0;
+    uint16_t protocolOffsets[4] = {0};
+    uint8_t pageTime = 0;
+};
+
+#endif
@@ -0,0 +1,11 @@
+#ifndef MONITOR_JSON_H
+#define MONITOR_JSON_H
+
+#pragma once
+#include <Arduino.h>
+#include "PortSnapshot.h"
+
+// Body of GET /monitor, also timed by tools/bench
+void writeMonitorJson(const MonitorSnapshot &snapshot, String &output);
+
+#endif
@@ -0,0 +1,101 @@
+#ifndef MQTT_EXPORTER_H
+#define MQTT_EXPORTER_H
+
+#pragma once
+#include <Arduino.h>
+#include <AsyncMqttClient.h>
+#include "defines.h"
+
+class Config;
+
+struct MqttPortState
+{
+    uint32_t time;
+    uint16_t voltage_mV;
+    uint16_t current_mA;
+    float energy;
+    uint8_t port;
+    bool active;
+    char protocol[16];
+};
+
+struct MqttStats
+{
+    uint32_t published = 0;
+    uint32_t dropped = 0;
+    uint32_t connects = 0;
+    uint32_t lastLatencyUs = 0;
+    uint32_t maxLatencyUs = 0;
+    int32_t heapCost = 0;
+};
+
+/**
+ * @brief Optional Home Assistant exporter.
+ *
+ * Discovery configs are published (retained) once per boot after the first connection, then
+ * per-port state goes out when the interval elapses or a value moves past its threshold.
+ * States are queued in a bounded ring so short broker outages lose nothing. When the ring fills
+ * while the broker is away, every other state of each port is dropped and from then on only
+ * every second state of a port is queued, doubling up to kMqttStrideMax; past that the oldest
+ * state is dropped. Long outages are covered end to end at a coarser step.
+ */
+class MqttExporter
+{
+public:
+    MqttExporter();
+
+    void begin(Config *config);
+    // Re-read the broker settings from Config and reconnect on the next loop()
+    void reconfigure();
+    // Record a fresh sample of one port, queued only if it should be published
+    void record(uint8_t port, bool active, uint16_t voltage_mV, uint16_t current_mA, const String &protocol, float energy);
+    // Reconnect, publish discovery and flush queued states; run from the scheduler
+    void loop();
+
+    bool isConnected();
+    uint8_t queued() const;
+    const MqttStats &stats() const;
+
+private:
+    static constexpr uint8_t kPorts = 4;
+    static constexpr uint8_t kDiscoveryFields = 5;
+
+    AsyncMqttClient client;
+    Config *config = nullptr;
+    String deviceId;
+    String baseTopic;
+    String host;
+    String user;
+    String password;
+    String willTopic;
+
+    MqttPortState queue[kMqttQueueSize];
+    uint8_t queueHead = 0;
+    uint8_t queueCount = 0;
+    // Only every queueStride-th state of a port is queued while the broker is away
+    uint8_t queueStride = 1;
+    uint8_t strideSkipped[kPorts] = {0};
+
+    MqttPortState lastPublished[kPorts];
+    bool hasPublished[kPorts] = {false};
+
+    uint8_t discoveryIndex = 0;
+    bool discoveryDone = false;
+    bool needOnline = false;
+    bool needReconfigure = true;
+    uint32_t nextConnectAttempt = 0;
+    uint32_t reconnectDelay = 1000;
+    uint16_t pendingPacketId = 0;
+    uint32_t pendingSince = 0;
+    uint32_t heapBeforeConnect = 0;
+    MqttStats exporterStats;
+
+    void applySettings();
+    bool shouldPublish(const MqttPortState &state) const;
+    void push(const MqttPortState &state);
+    void thin();
+    bool publishDiscovery(uint8_t index);
+    bool publishState(const MqttPortState &state);
+};
+
+#endif
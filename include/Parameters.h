@@ -0,0 +1,69 @@
+#ifndef PARAMETERS_H
+#define PARAMETERS_H
+
+#pragma once
+#include <Arduino.h>
+#include "defines.h"
+
+enum ParameterId : uint8_t
+{
+    PARAM_SAMPLE_INTERVAL = 0,
+    PARAM_TEMPERATURE_INTERVAL,
+    PARAM_FAN_INTERVAL,
+    PARAM_MAX_TEMPERATURE,
+    PARAM_MIN_TEMPERATURE,
+    PARAM_MAX_POWER,
+    PARAM_MIN_POWER,
+    PARAM_THERMISTOR_RS,
+    PARAM_THERMISTOR_VCC,
+    PARAM_COUNT
+};
+
+#define PARAM_BIT(id) (1UL << (id))
+#define PARAM_ALL (PARAM_BIT(PARAM_COUNT) - 1)
+
+enum ParameterType : uint8_t
+{
+    PARAM_TYPE_UINT = 0, // whole number, fractions are rejected
+    PARAM_TYPE_FLOAT
+};
+
+struct ParameterInfo
+{
+    const char *name;
+    ParameterType type;
+    float minValue;
+    float maxValue;
+    float defaultValue;
+    const char *unit;
+};
+
+/**
+ * @brief Runtime tunables that used to be compile-time constants, persisted with Config.
+ *
+ * Every value is range checked against its ParameterInfo on set(), and validate() checks the
+ * rules that span parameters, so a copy can be staged, checked as a whole and then applied in
+ * one assignment. The defines.h constants are only the defaults.
+ */
+struct Parameters
+{
+    float values[PARAM_COUNT];
+
+    Parameters();
+    void reset();
+
+    float get(ParameterId id) const;
+    uint32_t getUint(ParameterId id) const;
+    // False if the value is out of range or not a whole number for a uint parameter
+    bool set(ParameterId id, float value);
+    // Name of the first parameter breaking a cross-parameter rule, nullptr if all hold
+    const char *validate() const;
+    // PARAM_BIT mask of the parameters whose value differs
+    uint32_t diff(const Parameters &other) const;
+
+    static const ParameterInfo &info(ParameterId id);
+    // PARAM_COUNT if no parameter has this name
+    static ParameterId find(const char *name);
+};
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef PORT_HEALTH_H
+#define PORT_HEALTH_H
+
+#pragma once
+#include <Arduino.h>
+#include "defines.h"
+
+enum BreakerState : uint8_t
+{
+    BREAKER_CLOSED = 0, // sampled every generation
+    BREAKER_OPEN,       // skipped until the next probe is due
+    BREAKER_PROBING     // one sample let through, its result closes or reopens the breaker
+};
+
+struct PortHealthStats
+{
+    uint32_t samples = 0;
+    uint32_t failures = 0;
+    // Samples not taken because the breaker was open
+    uint32_t skipped = 0;
+    uint32_t trips = 0;
+    // SW35xx::result_t of the last failure
+    uint8_t lastError = 0;
+    uint32_t lastFailureAt = 0;
+};
+
+/**
+ * @brief Circuit breaker and health score of one charger port.
+ *
+ * kPortBreakerThreshold failed samples in a row open the breaker, after which the port is left
+ * alone except for a single probe sample whose delay doubles from kPortBreakerBackoffMin up to
+ * kPortBreakerBackoffMax. The score is a moving average of sample outcomes, 100 when every
+ * recent sample succeeded.
+ */
+class PortHealth
+{
+public:
+    // False while the breaker is open and no probe is due, the sample is skipped
+    bool allow(uint32_t now);
+    void success();
+    void failure(uint8_t error, uint32_t now);
+
+    BreakerState state() const;
+    uint8_t consecutiveFailures() const;
+    uint8_t score() const;
+    // ms until the next probe, 0 unless the breaker is open
+    uint32_t retryIn(uint32_t now) const;
+    const PortHealthStats &stats() const;
+
+private:
+    BreakerState breakerState = BREAKER_CLOSED;
+    uint8_t consecutive = 0;
+    // Score in 1/256 percent, so small steps are not lost to rounding
+    uint16_t scoreFixed = 100 << 8;
+    uint32_t nextProbe = 0;
+    uint32_t backoffMs = kPortBreakerBackoffMin;
+    PortHealthStats healthStats;
+
+    void updateScore(uint8_t outcome);
+};
+
+#endif
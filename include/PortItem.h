@@ -3,8 +3,19 @@
 #include <h1_SW35xx.h>
 #include <Wire.h>
 #include "log.h"
+#include "PortHealth.h"
 
 using namespace h1_SW35xx;
+
+// What one sample did to a port, see PortItem::applySample()
+enum SampleOutcome : uint8_t {
+    SAMPLE_SKIPPED = 0, // the breaker held the port open, nothing was read
+    SAMPLE_ABSENT,      // nothing attached, counts as a healthy read
+    SAMPLE_OK,          // values updated
+    SAMPLE_FAILED,      // read failed, the last good values are kept
+    SAMPLE_TRIPPED      // read failed and the breaker took the port down
+};
+
 class PortItem {
 public:
     float inputVoltage = 0.0;    // Input Voltage in V
@@ -13,6 +24,9 @@ public:
     float temperature = 0.0; // Temperature in °C
     String protocol = ""; 
     bool isActive = true;  // Port status
+    // False when the last read failed, the values above are then from the last good read
+    bool valid = false;
+    PortHealth health;
     SW35xx *sw;
 
     // Constructor
@@ -24,6 +38,13 @@ public:
     // Reset all values
     void reset();
     
-    // Update all values
-    void update();
+    // Update all values, nothing changes unless the result is RESULT_OK
+    SW35xx::result_t update();
+
+    // Breaker check before a sample, false leaves the port alone and marks it invalid
+    bool sampleAllowed(uint32_t now);
+    // Books a sample the breaker allowed: `present` is false when nothing is attached,
+    // otherwise `result` is the outcome of update(). `energy` gets the Wh drawn over `hours`.
+    // Shared by the sampling task and tools/replay, so a replay takes the same decisions.
+    SampleOutcome applySample(bool present, SW35xx::result_t result, uint32_t now, float hours, float &energy);
 }; 
\ No newline at end of file
@@ -0,0 +1,93 @@
+#ifndef PORT_SNAPSHOT_H
+#define PORT_SNAPSHOT_H
+
+#pragma once
+#include <stdint.h>
+#include <string.h>
+
+// Shared by the firmware and host tools, keep it free of Arduino types.
+
+constexpr uint8_t kSnapshotPorts = 4;
+
+// Fixed-layout copy of one PortItem, no String so a copy never touches the heap
+struct PortSnapshot
+{
+    float voltage;
+    float current;
+    float inputVoltage;
+    float temperature;
+    float power;
+    // Lifetime energy in Wh
+    float energy;
+    uint8_t fastChargeType;
+    uint8_t pdVersion;
+    bool active;
+    // False when the last read failed, the values are then from the last good read
+    bool valid;
+    // BreakerState and 0-100 score of PortHealth
+    uint8_t breaker;
+    uint8_t health;
+    char protocol[16];
+};
+
+// Everything /monitor reports, captured once per sample generation
+struct MonitorSnapshot
+{
+    uint32_t generation;
+    uint32_t uptimeMs;
+    PortSnapshot ports[kSnapshotPorts];
+    float moduleTemperature;
+    float inputVoltage;
+    int fanSpeed;
+    bool state;
+};
+
+/**
+ * @brief Single writer, many readers publication of a POD value without locks.
+ *
+ * The writer fills the slot readers are not pointed at and then bumps the generation, whose
+ * low bit selects the live slot. A reader copies the live slot and accepts the copy only if
+ * the generation did not move meanwhile; the writer never waits, and a reader that interrupts
+ * a publish still copies the previous, complete slot instead of spinning on the writer.
+ */
+template <typename T>
+class SnapshotBuffer
+{
+public:
+    void publish(const T &value)
+    {
+        uint32_t next = generation + 1;
+        memcpy(&slots[next & 1], &value, sizeof(T));
+        __sync_synchronize();
+        generation = next;
+        __sync_synchronize();
+    }
+
+    // Consistent copy of the latest value, false if every attempt raced two publishes
+    bool read(T &out, uint8_t attempts = 4) const
+    {
+        while (attempts-- > 0)
+        {
+            uint32_t before = generation;
+            __sync_synchronize();
+            memcpy(&out, (const void *)&slots[before & 1], sizeof(T));
+            __sync_synchronize();
+            if (generation == before)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    uint32_t published() const
+    {
+        return generation;
+    }
+
+private:
+    T slots[2] = {};
+    volatile uint32_t generation = 0;
+};
+
+#endif
@@ -0,0 +1,59 @@
+#ifndef REGISTER_CAPTURE_H
+#define REGISTER_CAPTURE_H
+
+#pragma once
+#include <Arduino.h>
+#include "defines.h"
+#include "CaptureFormat.h"
+
+enum CaptureState : uint8_t
+{
+    CAPTURE_IDLE = 0,
+    CAPTURE_STARTING, // requested, the file is created by the next flush()
+    CAPTURE_RECORDING,
+    CAPTURE_STOPPING  // requested, buffered records are written by the next flush()
+};
+
+struct CaptureStats
+{
+    uint32_t records = 0;
+    // Records lost because the RAM buffer was full or a write failed
+    uint32_t dropped = 0;
+    uint32_t bytes = 0;
+    uint32_t durationMs = 0;
+};
+
+/**
+ * @brief Records the raw SW35xx register bytes of every port read into CAPTURE_FILE.
+ *
+ * record() runs in the sample path and only copies into a RAM buffer; flush() runs from a low
+ * priority task, creates the file on start and appends the buffered records. A capture stops
+ * by itself at kCaptureMaxBytes. The file is replayed on a host by tools/replay.
+ */
+class RegisterCapture
+{
+public:
+    // Safe from the HTTP handlers, a new capture replaces the previous file
+    void requestStart(uint32_t sampleIntervalMs);
+    void requestStop();
+
+    // One port read, raw is kCaptureRegisterCount bytes or nullptr
+    void record(uint8_t port, uint8_t result, const uint8_t *raw);
+    void flush();
+
+    CaptureState state() const;
+    const CaptureStats &stats() const;
+
+private:
+    CaptureRecord buffer[kCaptureBufferRecords];
+    uint8_t count = 0;
+    CaptureState captureState = CAPTURE_IDLE;
+    uint32_t sampleIntervalMs = 0;
+    uint32_t startMs = 0;
+    CaptureStats captureStats;
+
+    bool create();
+    void append();
+};
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef SCENE_MANAGER_H
+#define SCENE_MANAGER_H
+
+#pragma once
+#include <Arduino.h>
+
+enum class Scene : uint8_t
+{
+    PortInfo = 0,
+    Welcome,
+    Bye,
+    OtaProgress,
+    WifiSetup,
+    Emoticon
+};
+
+typedef void (*SceneCallback)();
+
+/**
+ * @brief Tracks what owns the OLED and drives timed transitions without blocking.
+ *
+ * A scene shown with a duration stays on screen until it expires; then its callback runs and
+ * the display falls back to PortInfo unless the callback switched to another scene.
+ */
+class SceneManager
+{
+public:
+    SceneManager();
+
+    /**
+     * @brief Switch to a scene
+     * @param duration Time in ms to hold the scene, 0 keeps it until another scene is shown
+     * @param onDone Called once when the duration expires
+     */
+    void show(Scene scene, unsigned long duration = 0, SceneCallback onDone = nullptr);
+    Scene current() const;
+    // True while a timed scene is holding the display
+    bool isHolding() const;
+    void loop();
+
+private:
+    Scene scene = Scene::PortInfo;
+    unsigned long startTime = 0;
+    unsigned long duration = 0;
+    SceneCallback onDone = nullptr;
+    uint32_t generation = 0;
+};
+
+#endif
@@ -0,0 +1,87 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#pragma once
+#include <Arduino.h>
+
+typedef void (*TaskCallback)();
+
+enum TaskPriority : uint8_t
+{
+    PRIORITY_HIGH = 0,
+    PRIORITY_NORMAL = 1,
+    PRIORITY_LOW = 2
+};
+
+struct TaskStats
+{
+    uint32_t runs = 0;
+    // Runs that finished after their deadline
+    uint32_t overruns = 0;
+    // Periods dropped because the task fell more than a whole period behind
+    uint32_t skipped = 0;
+    uint32_t lastRunUs = 0;
+    uint32_t maxRunUs = 0;
+    uint64_t totalRunUs = 0;
+    uint32_t lastLatenessMs = 0;
+    uint32_t maxLatenessMs = 0;
+};
+
+struct Task
+{
+    const char *name = nullptr;
+    TaskCallback callback = nullptr;
+    // 0 for one-shot tasks
+    uint32_t periodMs = 0;
+    uint32_t deadlineMs = 0;
+    uint32_t nextFire = 0;
+    uint8_t priority = PRIORITY_NORMAL;
+    bool active = false;
+    TaskStats stats;
+};
+
+/**
+ * @brief Fixed-capacity cooperative scheduler driven from loop().
+ *
+ * Periodic tasks fire on a fixed grid (next = previous + period) so intervals do not drift
+ * with loop latency. Each call to loop() runs at most one due task, the one with the highest
+ * priority and then the earliest fire time, so polling services in loop() are never starved.
+ */
+class Scheduler
+{
+public:
+    // setupTasks() registers 16, the rest is headroom for new tasks and one-shots
+    static constexpr uint8_t kMaxTasks = 20;
+
+    Scheduler();
+
+    /**
+     * @brief Register a periodic task
+     * @param deadlineMs Allowed lateness plus run time before a run counts as overrun, 0 uses the period
+     * @return Task id, -1 when the table is full
+     */
+    int every(const char *name, uint32_t periodMs, TaskCallback callback, uint8_t priority = PRIORITY_NORMAL, uint32_t deadlineMs = 0);
+    /**
+     * @brief Register a task that runs once after delayMs
+     */
+    int once(const char *name, uint32_t delayMs, TaskCallback callback, uint8_t priority = PRIORITY_NORMAL, uint32_t deadlineMs = 0);
+    void cancel(int id);
+    void setPeriod(int id, uint32_t periodMs);
+    void loop();
+
+    uint8_t size() const;
+    const Task &task(uint8_t id) const;
+    // Registrations refused because the table was full, and the name of the first one
+    uint8_t rejected() const;
+    const char *firstRejected() const;
+
+private:
+    Task tasks[kMaxTasks];
+    uint8_t rejectedCount = 0;
+    const char *rejectedName = nullptr;
+
+    int add(const char *name, uint32_t periodMs, uint32_t delayMs, TaskCallback callback, uint8_t priority, uint32_t deadlineMs);
+    void run(Task &task, uint32_t now);
+};
+
+#endif
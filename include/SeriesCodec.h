@@ -0,0 +1,70 @@
+#ifndef SERIES_CODEC_H
+#define SERIES_CODEC_H
+
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+// Shared by the firmware and tools/series_bench, keep it free of Arduino types.
+
+constexpr uint8_t kSeriesMaxChannels = 8;
+// Worst case for one point: 5 byte timestamp, change mask, 3 bytes per channel
+constexpr size_t kSeriesMaxPointBytes = 5 + 1 + 3 * kSeriesMaxChannels;
+
+/**
+ * @brief Streaming encoder for (time, uint16 channels) points into a caller owned buffer.
+ *
+ * Timestamps are stored as zigzag varint delta-of-deltas, so a steady sample rate costs one
+ * byte. A bit mask marks the channels that moved since the previous point and only those get
+ * a zigzag varint delta: an idle port or a fixed PD rail costs nothing beyond the mask bit.
+ * The first point of a block is self-contained, so every block decodes on its own.
+ */
+class SeriesEncoder
+{
+public:
+    void reset(uint8_t *buffer, size_t capacity, uint8_t channels);
+
+    // Append a point, false (and nothing written) when it does not fit in the buffer
+    bool append(uint32_t time, const uint16_t *values);
+
+    size_t length() const { return used; }
+    uint16_t count() const { return points; }
+
+private:
+    uint8_t *buffer = nullptr;
+    size_t capacity = 0;
+    size_t used = 0;
+    uint8_t channels = 0;
+    uint16_t points = 0;
+
+    uint32_t lastTime = 0;
+    int32_t lastDelta = 0;
+    uint16_t last[kSeriesMaxChannels] = {0};
+};
+
+class SeriesDecoder
+{
+public:
+    void reset(const uint8_t *data, size_t length, uint8_t channels, uint16_t count);
+
+    // Next point of the block, false at the end or on malformed input
+    bool next(uint32_t &time, uint16_t *values);
+
+    uint16_t remaining() const { return points; }
+
+private:
+    const uint8_t *data = nullptr;
+    size_t length = 0;
+    size_t position = 0;
+    uint8_t channels = 0;
+    uint16_t points = 0;
+    bool first = true;
+
+    uint32_t lastTime = 0;
+    int32_t lastDelta = 0;
+    uint16_t last[kSeriesMaxChannels] = {0};
+
+    bool readVarint(uint64_t &value);
+};
+
+#endif
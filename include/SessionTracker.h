@@ -0,0 +1,98 @@
+#ifndef SESSION_TRACKER_H
+#define SESSION_TRACKER_H
+
+#pragma once
+#include <Arduino.h>
+#include "defines.h"
+
+enum SessionEndReason : uint8_t
+{
+    SESSION_END_IDLE = 0,    // current stayed below kSessionStartCurrent for kSessionEndDelay
+    SESSION_END_UNPLUGGED,   // port stopped answering
+    SESSION_END_SWITCHED_OFF // output switched off from the button or /switch
+};
+
+// Fixed-size log entry, appended to SESSION_LOG_FILE once a session closes
+struct __attribute__((packed)) SessionRecord
+{
+    uint32_t id;
+    // Unix time, 0 if NTP had not synced when the session started
+    uint32_t startTime;
+    // Seconds since boot at the start, orders sessions without a wall clock
+    uint32_t startUptime;
+    // Seconds
+    uint32_t duration;
+    // Wh delivered during the session
+    float energy;
+    // 1/100 W
+    uint16_t peakPower;
+    uint16_t averagePower;
+    uint16_t peakCurrent_mA;
+    // One bit per SW35xx::fastChargeType_t seen during the session
+    uint16_t protocols;
+    uint8_t port;
+    uint8_t reason;
+    // Bit 2/3 set when PD 2.0/3.0 was negotiated
+    uint8_t pdVersions;
+    uint8_t reserved;
+};
+
+static_assert(sizeof(SessionRecord) == 32, "SessionRecord layout changed");
+
+struct ActiveSession
+{
+    bool open = false;
+    uint32_t startMs = 0;
+    uint32_t startTime = 0;
+    uint32_t lastChargingMs = 0;
+    uint32_t lastSampleMs = 0;
+    float energy = 0;
+    float peakPower = 0;
+    uint16_t peakCurrent_mA = 0;
+    uint16_t protocols = 0;
+    uint8_t pdVersions = 0;
+};
+
+/**
+ * @brief Splits the per-port energy into plug-in sessions.
+ *
+ * update() runs with every port sample; a session opens when the current reaches
+ * kSessionStartCurrent and closes after kSessionEndDelay below it, or when the port goes away.
+ * Closed sessions wait in RAM until flush() appends them to the log from a low priority task,
+ * so the sampling path never touches flash. The log is two files of kSessionLogRecords records;
+ * when the current one is full it replaces the older one.
+ */
+class SessionTracker
+{
+public:
+    void begin();
+
+    void update(uint8_t port, bool present, float voltage, float current, uint8_t protocol, uint8_t pdVersion);
+    // Close every open session, e.g. when the output is switched off
+    void closeAll(SessionEndReason reason);
+    // Append closed sessions to the log
+    void flush();
+
+    const ActiveSession &active(uint8_t port) const;
+    // Number of sessions that can be read back, pending ones included
+    uint32_t count() const;
+    // Newest first, index 0 is the most recent session
+    bool read(uint32_t index, SessionRecord &record);
+
+private:
+    static constexpr uint8_t kPorts = 4;
+    static constexpr uint8_t kPendingSize = 8;
+
+    ActiveSession sessions[kPorts];
+    SessionRecord pending[kPendingSize];
+    uint8_t pendingCount = 0;
+    uint32_t nextId = 1;
+    uint32_t currentRecords = 0;
+    uint32_t previousRecords = 0;
+
+    void close(uint8_t port, SessionEndReason reason, uint32_t now);
+    bool readFrom(const char *path, uint32_t position, SessionRecord &record);
+    static uint32_t recordsIn(const char *path);
+};
+
+#endif
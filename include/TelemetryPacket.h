@@ -0,0 +1,73 @@
+#ifndef TELEMETRY_PACKET_H
+#define TELEMETRY_PACKET_H
+
+#pragma once
+#include <stdint.h>
+#include <string.h>
+
+// Shared by the firmware and tools/telemetry_receiver, keep it free of Arduino types.
+// All fields are little-endian, which is the native order of both the ESP8266 and x86/ARM hosts.
+
+constexpr uint32_t kTelemetryMagic = 0x35335753; // "SW35"
+constexpr uint8_t kTelemetryVersion = 1;
+constexpr uint16_t kTelemetryPort = 35180;
+constexpr uint8_t kTelemetryPorts = 4;
+
+enum TelemetryPortFlags : uint8_t
+{
+    TELEMETRY_PORT_ACTIVE = 1 << 0,
+    // The last read failed, the values are from the last good read
+    TELEMETRY_PORT_INVALID = 1 << 1,
+};
+
+struct __attribute__((packed)) TelemetryPortSample
+{
+    uint16_t voltage_mV;
+    uint16_t current_mA;
+    uint16_t inputVoltage_mV;
+    // SW35xx::fastChargeType_t
+    uint8_t protocol;
+    uint8_t pdVersion;
+    uint8_t flags;
+    uint8_t reserved;
+    // Lifetime energy in Wh
+    float energy;
+};
+
+struct __attribute__((packed)) TelemetryPacket
+{
+    uint32_t magic;
+    uint8_t version;
+    uint8_t portCount;
+    uint16_t size;
+    uint32_t chipId;
+    // Incremented once per sample generation, gaps mean lost datagrams
+    uint32_t sequence;
+    uint32_t uptimeMs;
+    // NTC temperature in 1/100 °C
+    int16_t temperature;
+    uint8_t fanDuty;
+    uint8_t state;
+    TelemetryPortSample ports[kTelemetryPorts];
+};
+
+static_assert(sizeof(TelemetryPortSample) == 14, "TelemetryPortSample layout changed");
+static_assert(sizeof(TelemetryPacket) == 24 + kTelemetryPorts * sizeof(TelemetryPortSample), "TelemetryPacket layout changed");
+
+/**
+ * @brief Validate and copy a received datagram, false if it is not a telemetry packet we understand
+ */
+inline bool decodeTelemetryPacket(const uint8_t *data, size_t length, TelemetryPacket &packet)
+{
+    if (length < sizeof(TelemetryPacket))
+    {
+        return false;
+    }
+
+    memcpy(&packet, data, sizeof(TelemetryPacket));
+    // Newer versions may append fields, the known prefix stays compatible
+    return packet.magic == kTelemetryMagic && packet.version >= kTelemetryVersion &&
+           packet.size <= length && packet.portCount == kTelemetryPorts;
+}
+
+#endif
@@ -0,0 +1,59 @@
+#ifndef TEXT_LAYER_H
+#define TEXT_LAYER_H
+
+#pragma once
+#include <Arduino.h>
+#include <vector>
+
+constexpr uint8_t kGlyphWidth = 6; // 5x7 classic font plus one column spacing
+constexpr char kGlyphFirst = ' ';
+constexpr char kGlyphLast = '~';
+
+/**
+ * @brief Frame buffer in the SSD1306/SH1106 page layout: one byte per column per 8 rows.
+ */
+struct FrameBuffer
+{
+    uint8_t *buffer;
+    int16_t width;
+    int16_t height;
+
+    // Copy column bytes to (x, y), y does not need to be page aligned
+    void blitColumns(int16_t x, int16_t y, const uint8_t *columns, uint16_t count) const;
+};
+
+/**
+ * @brief Printable ASCII rasterized once through Adafruit_GFX into column bytes, so text can
+ * be composed by copying columns instead of drawing every pixel of every glyph.
+ */
+class GlyphAtlas
+{
+public:
+    void begin();
+    const uint8_t *glyph(char c) const;
+    void draw(const FrameBuffer &frame, int16_t x, int16_t y, const char *text) const;
+    // One decimal followed by a unit letter, e.g. "20.1V"
+    void drawValue(const FrameBuffer &frame, int16_t x, int16_t y, float value, char unit) const;
+
+private:
+    uint8_t columns[(kGlyphLast - kGlyphFirst + 1) * kGlyphWidth] = {0};
+};
+
+/**
+ * @brief Pre-rendered single line of text, used for marquees: scrolling is a column offset.
+ */
+class TextStrip
+{
+public:
+    // Re-render only when the text changed, returns true if it did
+    bool setText(const GlyphAtlas &atlas, const String &text);
+    // Draw `width` columns starting at `offset`, wrapping around the end of the strip
+    void blit(const FrameBuffer &frame, int16_t x, int16_t y, uint16_t width, uint16_t offset) const;
+    uint16_t width() const;
+
+private:
+    String text;
+    std::vector<uint8_t> columns;
+};
+
+#endif
@@ -0,0 +1,134 @@
+#ifndef THERMISTOR_H
+#define THERMISTOR_H
+
+#pragma once
+#include <Arduino.h>
+#include <memory>
+#include "defines.h"
+
+// Ref: https://esp8266tutorials.blogspot.com/2016/09/esp8266-ntc-temperature-thermistor.html
+constexpr unsigned int kThermistorRs = 157000;
+constexpr double kThermistorVcc = 3.3;
+constexpr double kSteinhartA = 0.001129148;
+constexpr double kSteinhartB = 0.000234125;
+constexpr double kSteinhartC = 0.0000000876741;
+
+// Below kThermistorFineLimit the NTC curve is steep (hot side), so the table keeps
+// one entry per ADC count there and one entry per kThermistorCoarseStep above it.
+constexpr int kThermistorFineLimit = 64;
+constexpr int kThermistorCoarseShift = 3;
+constexpr int kThermistorCoarseStep = 1 << kThermistorCoarseShift;
+// 65 fine entries (ADC 0 to 64) and 120 coarse ones (72 to 1024), 185 in all
+constexpr int kThermistorTableSize = kThermistorFineLimit + (1024 - kThermistorFineLimit) / kThermistorCoarseStep + 1;
+
+// ADC samples are kept as 1/16 count fixed point so the filter does not lose resolution
+constexpr int kThermistorFracBits = 4;
+
+namespace thermistor_detail {
+
+// Compile-time natural logarithm (range reduction + atanh series)
+constexpr double ln(double x)
+{
+    int k = 0;
+    while (x > 2.0)
+    {
+        x /= 2.0;
+        k++;
+    }
+    while (x < 1.0)
+    {
+        x *= 2.0;
+        k--;
+    }
+    double y = (x - 1.0) / (x + 1.0);
+    double y2 = y * y;
+    double term = y;
+    double sum = 0.0;
+    for (int n = 1; n < 60; n += 2)
+    {
+        sum += term / n;
+        term *= y2;
+    }
+    return 2.0 * sum + k * 0.6931471805599453;
+}
+
+// Same Steinhart-Hart evaluation the firmware used to do at runtime, for a (fractional) ADC count
+constexpr double celsius(double adc, double rs = kThermistorRs, double vcc = kThermistorVcc)
+{
+    double vNtc = adc / 1024;
+    double rNtc = ln((rs * vNtc) / (vcc - vNtc));
+    return 1 / (kSteinhartA + (kSteinhartB + (kSteinhartC * rNtc * rNtc)) * rNtc) - 273.15;
+}
+
+// Rounded table entry. Small series resistors put the first counts far past 327.67 °C, those
+// saturate instead of wrapping around to a negative temperature.
+constexpr int16_t roundCenti(double value)
+{
+    return value >= INT16_MAX ? INT16_MAX : value <= INT16_MIN ? INT16_MIN : (int16_t)(value < 0 ? value - 0.5 : value + 0.5);
+}
+
+constexpr int16_t centiCelsius(double adc, double rs = kThermistorRs, double vcc = kThermistorVcc)
+{
+    return roundCenti(celsius(adc < 1 ? 1 : adc, rs, vcc) * 100);
+}
+
+} // namespace thermistor_detail
+
+struct ThermistorTable
+{
+    int16_t centiCelsius[kThermistorTableSize];
+};
+
+constexpr ThermistorTable makeThermistorTable()
+{
+    ThermistorTable table = {};
+    for (int i = 0; i < kThermistorTableSize; i++)
+    {
+        int adc = i <= kThermistorFineLimit ? i : kThermistorFineLimit + (i - kThermistorFineLimit) * kThermistorCoarseStep;
+        table.centiCelsius[i] = thermistor_detail::centiCelsius(adc);
+    }
+    return table;
+}
+
+class Thermistor
+{
+public:
+    Thermistor();
+
+    // Oversample A0 into the median/EMA filter, called every kTimeToSampleTemperature
+    void sample();
+
+    // Filtered temperature in °C
+    float temperature() const;
+
+    /**
+     * @brief Use another divider resistor or supply voltage
+     *
+     * Builds a table for them in RAM, the defaults go back to the flash table.
+     */
+    void setCircuit(uint32_t rs, float vcc);
+
+    // Convert an ADC reading in 1/16 counts through the table of the current circuit
+    float celsiusOf(uint32_t adcFixed) const;
+
+    // Convert an ADC reading in 1/16 counts through the default lookup table
+    static float toCelsius(uint32_t adcFixed);
+
+private:
+    // Table for a non-default circuit, nullptr while the PROGMEM table applies
+    std::unique_ptr<ThermistorTable> custom;
+
+    static float interpolate(uint32_t adcFixed, const ThermistorTable *ram);
+
+    static constexpr uint8_t kMedianSize = 5;
+
+    uint16_t window[kMedianSize] = {0};
+    uint8_t windowCount = 0;
+    uint8_t windowHead = 0;
+    uint32_t filtered = 0;
+    bool hasValue = false;
+
+    uint16_t median() const;
+};
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef UDP_TELEMETRY_H
+#define UDP_TELEMETRY_H
+
+#pragma once
+#include <Arduino.h>
+#include <WiFiUdp.h>
+#include "defines.h"
+#include "TelemetryPacket.h"
+
+class Config;
+
+/**
+ * @brief Optional fleet telemetry: one fixed-layout TelemetryPacket per sample generation,
+ * broadcast on the LAN or sent to a multicast group (Config::udpAddress).
+ *
+ * Packets produced while the link is down wait in a ring of kUdpQueueSize and go out in order,
+ * at most kUdpBatchSize per send(), once it is back. When the ring fills, every other packet is
+ * dropped and from then on only every second one is queued, doubling up to kUdpStrideMax, so an
+ * outage of any length up to kUdpQueueSize * kUdpStrideMax generations is covered end to end at
+ * a coarser step. Receivers see the original sequence and uptime, so a late packet is not
+ * mistaken for a fresh one, and the sequence gaps show the thinning.
+ */
+class UdpTelemetry
+{
+public:
+    UdpTelemetry();
+
+    void begin(Config *config);
+    bool isEnabled() const;
+    /**
+     * @brief Fill in the header and queue the packet, then send what the link allows
+     * @return true when nothing is left queued
+     */
+    bool send(TelemetryPacket &packet);
+
+    uint32_t sequence() const;
+    uint32_t sent() const;
+    uint32_t failed() const;
+    uint8_t queued() const;
+    // Packets thinned out or lost because the queue was full
+    uint32_t dropped() const;
+
+private:
+    WiFiUDP udp;
+    Config *config = nullptr;
+    uint32_t nextSequence = 0;
+    uint32_t sentCount = 0;
+    uint32_t failedCount = 0;
+    uint32_t droppedCount = 0;
+
+    TelemetryPacket queue[kUdpQueueSize];
+    uint8_t queueHead = 0;
+    uint8_t queueCount = 0;
+    // Only every queueStride-th packet is queued while offline
+    uint8_t queueStride = 1;
+    uint8_t strideSkipped = 0;
+
+    void push(const TelemetryPacket &packet);
+    void thin();
+    bool transmit(const TelemetryPacket &packet);
+};
+
+#endif
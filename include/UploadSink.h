@@ -0,0 +1,79 @@
+#ifndef UPLOAD_SINK_H
+#define UPLOAD_SINK_H
+
+#pragma once
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <MD5Builder.h>
+#include <ESPAsyncWebServer.h>
+#include "defines.h"
+
+/**
+ * @brief Shared pipeline for chunked HTTP uploads into LittleFS.
+ *
+ * Incoming chunks are coalesced into flash-page-sized writes to a temp file next to the
+ * target. On finish() the optional CRC32/MD5 supplied by the client is checked and only then
+ * the temp file is renamed over the target, so a failed upload never destroys the old file.
+ * A sink serves one request at a time: an upload that starts while another one is running is
+ * ignored and answered with 409 instead of aborting it.
+ */
+class UploadSink
+{
+public:
+    UploadSink();
+    ~UploadSink();
+
+    /**
+     * @brief Start a new upload, aborting any one still in progress
+     * @param crc32 Expected CRC32 as hex, empty to skip the check
+     * @param md5 Expected MD5 as hex, empty to skip the check
+     */
+    bool begin(const String &target, const String &crc32 = "", const String &md5 = "");
+    bool write(const uint8_t *data, size_t len);
+    /**
+     * @brief Flush, verify and move the temp file over the target
+     */
+    bool finish();
+    void abort();
+
+    /**
+     * @brief Feed one ESPAsyncWebServer upload callback, the expected hashes are taken from the
+     * "crc32" and "md5" request arguments when the first chunk arrives
+     */
+    void handleChunk(AsyncWebServerRequest *request, const String &target, size_t index, uint8_t *data, size_t len, bool final);
+    /**
+     * @brief Answer the request once its body is complete, with `message` if its own upload
+     * succeeded, 409 if it was turned away and 400 if it carried no file
+     */
+    void sendResult(AsyncWebServerRequest *request, const String &message);
+
+    bool isOpen() const;
+    bool succeeded() const;
+    const String &error() const;
+    const String &target() const;
+    size_t size() const;
+
+private:
+    File file;
+    // Request whose upload the sink holds, until it is answered or disconnects
+    AsyncWebServerRequest *owner = nullptr;
+    String targetPath;
+    String tempPath;
+    String expectedCrc32;
+    String expectedMd5;
+    String lastError;
+    MD5Builder md5;
+    uint32_t crc = 0;
+    size_t totalSize = 0;
+    bool success = false;
+    unsigned long startTime = 0;
+
+    uint8_t buffer[kUploadPageSize];
+    size_t buffered = 0;
+
+    bool flushBuffer();
+    bool writeFile(const uint8_t *data, size_t len);
+    void fail(const String &message);
+};
+
+#endif
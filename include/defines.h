@@ -2,19 +2,89 @@
 #define DEFINES_H
 
 #define FWVersion "1.1"
+// kTimeToCheckTemperature, kTimeToChangeFan, kTimeToReadInformation, kMax/MinTemperature and
+// kMax/MinPower are only defaults, see Parameters
 #define kTimeToCheckTemperature 1000       // 1000ms
+#define kTimeToSampleTemperature 100       // 100ms, NTC oversampling between checks
+#define kTemperatureOversample 4
 #define kTimeToChangeFan 10000       // 10000ms
-#define kTimeToReadInformation 150        // 150ms
+#define kTimeToReadInformation 1000       // 1000ms, port sampling
+#define kSampleDeadline 200               // 200ms, from the due time until the last port is read
+#define kTimeToRender 1000                 // 1000ms
+#define kTimeToSaveConfig 60000            // 60s, energy counters are flushed to flash in batches
 #define FAN_PIN 12                           // For PWM control fan
 #define kServerName "sw351xmonitor"
 
 #define kMaxTemperature 80
 #define kMinTemperature 30
 #define CONFIG_FILE "/config.json"
+#define kConfigDocumentSize 1024
 #define SWITCH_PIN 13
 #define SWITCH_BUTTON 16
 #define LED_STATUS 14
 #define kMaxPower 100.0
 #define kMinPower 30.0
+#define kFileListDefaultLimit 100
+#define kFileListMaxLimit 500              // Entries per /list page, more takes another request
+#define kFileListMaxDepth 4
+#define kI2CDisplayClock 400000             // OLED flushes
+#define kI2CChargerClock 100000             // SW35xx register reads
+#define kI2CBenchTransactions 200          // Reads per bench speed
+#define kI2CBenchBatch 10                  // Reads per queued bench job, about 3ms at 100kHz
+#define kI2CPumpBudgetUs 4000             // Bus time per loop() before other services run again
+#define kOledChunkSize 31                  // Data bytes per OLED write, plus the control byte
+#define kMqttPublishInterval 10000         // 10s, per port unless a threshold is crossed
+#define kMqttVoltageThreshold 100          // mV change that forces a publish
+#define kMqttCurrentThreshold 100          // mA change that forces a publish
+#define kMqttQueueSize 32                  // States kept in RAM while the broker is away
+#define kMqttBatchSize 4                   // States published per exporter tick
+#define kMqttStrideMax 64                  // A full queue keeps every 2nd, 4th.. 64th state of each port
+#define kUploadPageSize 256u             // LittleFS program size on the ESP8266
+#define kSessionStartCurrent 0.05          // 50mA, below this a port is idle
+#define kSessionEndDelay 30000             // 30s idle before a session is closed
+#define kSessionMinDuration 5000           // Shorter sessions are plug-in blips, not logged
+#define kSessionLogRecords 256             // Records per log file before it rotates
+#define kSessionPageDefault 20
+#define kSessionPageMax 100
+#define SESSION_LOG_FILE "/sessions.bin"
+#define SESSION_LOG_OLD_FILE "/sessions.old"
+#define kNtpServer "pool.ntp.org"
+#define kValidEpoch 1577836800             // 2020-01-01, earlier means NTP has not set the clock yet
+#define HISTORY_DIR "/history"
+#define kHistoryInterval 10                // Seconds per stored point
+#define kHistoryBlockPoints 60             // Points per flash append, 10 minutes at kHistoryInterval
+#define kHistoryBlockBytes 256             // Encoded block size limit, a busy block seals early
+#define kHistorySegmentSeconds 86400       // One segment file per day
+#define kHistoryRetentionDays 14
+#define kHistoryMaxFsPercent 85            // Oldest segments go first when LittleFS fills past this
+#define kHistoryQueryDefaultPoints 200
+#define kHistoryQueryMaxPoints 1000
+#define kHistoryPointsPerChunk 1000        // Points decoded per /history callback, keeps it clear of the watchdog
+#define kWifiConnectTimeout 20000          // 20s per connection attempt
+#define kWifiPollInterval 250
+#define kWifiBackoffMin 1000               // First retry after a failed attempt or a dropped link
+#define kWifiBackoffMax 60000              // Retry delay doubles up to this
+#define kWifiPortalAfterFailures 5         // Failed attempts in a row before the setup portal opens
+#define kUdpQueueSize 16                   // Telemetry packets kept in RAM while offline
+#define kUdpBatchSize 4                    // Queued packets sent per sample generation
+#define kUdpStrideMax 64                   // A full queue keeps every 2nd, 4th.. 64th packet, 16 slots cover 1024 generations
+#define BENCH_FILE "/bench.tmp"
+#define kBenchChannels 5                   // Display plus the four chargers
+#define kBenchI2CReads 20                  // Timed reads per mux channel
+#define kBenchDisplayPasses 3              // Full flushes, each page is also timed on its own
+#define kBenchFileBytes 32768
+#define kBenchStepBytes 4096               // Flash work per step, keeps loop() stalls short
+#define kBenchJsonRuns 20
+#define kBenchStepInterval 20              // ms between steps
+#define kBenchPhaseTimeout 5000            // A phase that makes no progress is abandoned
+#define kSW35xxRetries 2                   // Attempts per register, the port breaker handles the rest
+#define kPortBreakerThreshold 3            // Consecutive failed samples that open a port's breaker
+#define kPortBreakerBackoffMin 1000        // First probe of an open breaker
+#define kPortBreakerBackoffMax 60000       // Probe delay doubles up to this
+#define kParametersBodyMax 512             // Largest PATCH /config body
+#define CAPTURE_FILE "/capture.bin"
+#define kCaptureBufferRecords 32           // Records kept in RAM between flushes, 8s of four ports
+#define kCaptureMaxBytes 65536             // A capture stops by itself at this size, about 18 minutes
+#define kCaptureFlushInterval 1000
 
 #endif
\ No newline at end of file
@@ -40,56 +40,100 @@
 
 namespace h1_SW35xx {
 
-SW35xx::SW35xx(TwoWire &i2c) : _i2c(i2c) {}
+SW35xx::SW35xx(TwoWire &i2c) : _i2c(i2c), _retries(I2C_RETRIES), _stats(), _raw(), _shadow(),
+  _shadowValid(0), _batch(false), _unlocked(false), _batchResult(RESULT_OK) {}
 SW35xx::~SW35xx() {}
 
-int SW35xx::i2cReadReg8(const uint8_t reg) {
-  for (int i=0; i<I2C_RETRIES; i++) {
-    _i2c.beginTransmission(SW35XX_ADDRESS);
-    if (_i2c.write(reg) != 1) {
-      continue;
-    }
-    if (_i2c.endTransmission() != 0) {
-      continue;
-    }
+void SW35xx::setRetries(const uint8_t retries) {
+  _retries = retries > 0 ? retries : 1;
+}
 
-    if (_i2c.requestFrom(SW35XX_ADDRESS, 1) != 1) {
-      continue;
-    }
+const uint8_t *SW35xx::rawRegisters() const {
+  return _raw;
+}
 
-    /* Wait until data is available if required */
-    for (int k=0; !_i2c.available() && k<I2C_RETRIES; k++) {
-      delay(10);
-    }
+const SW35xx::errorStats_t &SW35xx::errorStats() const {
+  return _stats;
+}
 
-    const int value = _i2c.read();
-    if (value < 0) {
-      continue;
+SW35xx::result_t SW35xx::account(const result_t result) {
+  _stats.transfers++;
+  if (result != RESULT_OK) {
+    _stats.failures++;
+    _stats.lastError = result;
+    /* the chip may have been reset, do not trust the cached configuration anymore */
+    _shadowValid = 0;
+  }
+  return result;
+}
+
+/* one transfer: the register value, or the negated result_t */
+inline int SW35xx::readAttempt(const uint8_t reg) {
+  _i2c.beginTransmission(SW35XX_ADDRESS);
+  if (_i2c.write(reg) != 1 || _i2c.endTransmission() != 0)
+    return -RESULT_ADDRESS_NACK;
+  if (_i2c.requestFrom(SW35XX_ADDRESS, 1) != 1)
+    return -RESULT_NO_DATA;
+  const int value = _i2c.read();
+  return value < 0 ? -RESULT_NO_DATA : value;
+}
+
+/* the remaining attempts after a failed first one, kept out of the common path */
+__attribute__((cold, noinline)) int SW35xx::retryRead(const uint8_t reg, int result) {
+  for (int i=1; i<_retries; i++) {
+    _stats.retries++;
+    result = readAttempt(reg);
+    if (result >= 0) {
+      _stats.transfers++;
+      return result;
     }
+  }
+  return -account((result_t)-result);
+}
+
+/* register value, or the negated result_t of the last attempt */
+int SW35xx::i2cReadReg8(const uint8_t reg) {
+  const int value = readAttempt(reg);
+  if (__builtin_expect(value >= 0, 1)) {
+    _stats.transfers++;
     return value;
   }
+  return retryRead(reg, value);
+}
 
-  return 0;
+SW35xx::result_t SW35xx::i2cReadReg8(const uint8_t reg, uint8_t &value) {
+  const int result = i2cReadReg8(reg);
+  if (result < 0)
+    return (result_t)-result;
+  value = result;
+  return RESULT_OK;
 }
 
-int SW35xx::i2cWriteReg8(const uint8_t reg, const uint8_t data) {
-  int error = -1;
+SW35xx::result_t SW35xx::i2cWriteReg8(const uint8_t reg, const uint8_t data) {
+  result_t result = RESULT_ADDRESS_NACK;
 
-  for (int i=0; i<I2C_RETRIES; i++) {
+  for (int i=0; i<_retries; i++) {
+    if (i > 0) {
+      _stats.retries++;
+    }
     _i2c.beginTransmission(SW35XX_ADDRESS);
     if (_i2c.write(reg) != 1) {
+      result = RESULT_ADDRESS_NACK;
       continue;
     }
     if (_i2c.write(data) != 1) {
+      result = RESULT_DATA_NACK;
       continue;
     }
-    error = _i2c.endTransmission();
+    const uint8_t error = _i2c.endTransmission();
     if (error == 0) {
-      return 0;
+      return account(RESULT_OK);
     }
+    /* 2 is a NACK on the address, 3 on the data */
+    result = error == 3 ? RESULT_DATA_NACK : RESULT_ADDRESS_NACK;
   }
 
-  return error;
+  return account(result);
 }
 
 void SW35xx::begin(){
@@ -97,44 +141,65 @@ void SW35xx::begin(){
   i2cWriteReg8(SW35XX_I2C_CTRL, 0x02);
 }
 
-uint16_t SW35xx::readADCDataBuffer(const enum ADCDataType type) {
-  i2cWriteReg8(SW35XX_ADC_DATA_TYPE, type);
-
-  uint16_t value = i2cReadReg8(SW35XX_ADC_DATA_BUF_H) << 4;
-  value |= i2cReadReg8(SW35XX_ADC_DATA_BUF_L) | 0x0f;
-
-  return value;
+SW35xx::result_t SW35xx::readADCDataBuffer(const enum ADCDataType type, uint16_t &value) {
+  uint8_t high = 0;
+  uint8_t low = 0;
+  result_t result = i2cWriteReg8(SW35XX_ADC_DATA_TYPE, type);
+  if (result == RESULT_OK)
+    result = i2cReadReg8(SW35XX_ADC_DATA_BUF_H, high);
+  if (result == RESULT_OK)
+    result = i2cReadReg8(SW35XX_ADC_DATA_BUF_L, low);
+
+  value = (high << 4) | low | 0x0f;
+  return result;
 }
 
-void SW35xx::readStatus(const bool useADCDataBuffer) {
+SW35xx::result_t SW35xx::readStatus(const bool useADCDataBuffer) {
   uint16_t vin = 0;
   uint16_t vout = 0;
   uint16_t iout_usbc = 0;
   uint16_t iout_usba = 0;
+  result_t result = RESULT_OK;
+  uint8_t raw[RAW_FCX_STATUS] = {0};
 
   if (useADCDataBuffer) {
     //读取输入电压
-    vin = readADCDataBuffer(ADC_VIN);
+    result = readADCDataBuffer(ADC_VIN, vin);
     //读取输出电压
-    vout = readADCDataBuffer(ADC_VOUT);
+    if (result == RESULT_OK)
+      result = readADCDataBuffer(ADC_VOUT, vout);
     //读取接口1输出电流
-    iout_usbc = readADCDataBuffer(ADC_IOUT_USB_C);
+    if (result == RESULT_OK)
+      result = readADCDataBuffer(ADC_IOUT_USB_C, iout_usbc);
     //读取接口2输出电流
-    iout_usba = readADCDataBuffer(ADC_IOUT_USB_A);
+    if (result == RESULT_OK)
+      result = readADCDataBuffer(ADC_IOUT_USB_A, iout_usba);
   } else {
-    const uint8_t vin_vout_low = i2cReadReg8(SW35XX_ADC_VIN_VOUT_L);
-    vin = i2cReadReg8(SW35XX_ADC_VIN_H) << 4;
-    vin |= vin_vout_low >> 4;
-    vout = i2cReadReg8(SW35XX_ADC_VOUT_H) << 4;
-    vout |= vin_vout_low & 0x0F;
-
-    const uint8_t iout_low = i2cReadReg8(SW35XX_ADC_IOUT_USBC_USBA_L);
-    iout_usbc = i2cReadReg8(SW35XX_ADC_IOUT_USBC_H) << 4;
-    iout_usbc |= iout_low >> 4;
-    iout_usba = i2cReadReg8(SW35XX_ADC_IOUT_USBA_H) << 4;
-    iout_usba |= iout_low & 0x0F;
+    /* same order as RAW_ADC_VIN_VOUT_L to RAW_ADC_IOUT_USBA_H */
+    static const uint8_t registers[] = {
+      SW35XX_ADC_VIN_VOUT_L, SW35XX_ADC_VIN_H, SW35XX_ADC_VOUT_H,
+      SW35XX_ADC_IOUT_USBC_USBA_L, SW35XX_ADC_IOUT_USBC_H, SW35XX_ADC_IOUT_USBA_H
+    };
+    for (uint8_t i=0; i<sizeof(registers); i++) {
+      const int value = i2cReadReg8(registers[i]);
+      if (value < 0)
+        return (result_t)-value;
+      raw[i] = value;
+    }
+
+    vin = (raw[1] << 4) | (raw[0] >> 4);
+    vout = (raw[2] << 4) | (raw[0] & 0x0F);
+    iout_usbc = (raw[4] << 4) | (raw[3] >> 4);
+    iout_usba = (raw[5] << 4) | (raw[3] & 0x0F);
   }
 
+  //读取pd版本和快充协议
+  if (result != RESULT_OK)
+    return result;
+  const int status = i2cReadReg8(SW35XX_FCX_STATUS);
+  if (status < 0)
+    return (result_t)-status;
+
   vin_mV = vin * 10;
   vout_mV = vout * 6;
   if (iout_usbc > 15) //在没有输出的情况下读到的数据是15
@@ -146,34 +211,112 @@ void SW35xx::readStatus(const bool useADCDataBuffer) {
     iout_usba_mA = iout_usba * 5 / 2;
   else
     iout_usba_mA = 0;
-  //读取pd版本和快充协议
-  const uint8_t status = i2cReadReg8(SW35XX_FCX_STATUS);
+  if (!useADCDataBuffer)
+    memcpy(_raw, raw, sizeof(raw));
+  _raw[RAW_FCX_STATUS] = status;
   PDVersion = ((status & 0x30) >> 4) + 1;
   fastChargeType = (fastChargeType_t)(status & 0x0f);
+  return RESULT_OK;
 }
 
-float SW35xx::readTemperature(const bool useADCDataBuffer) {
+SW35xx::result_t SW35xx::readTemperature(float &mV, const bool useADCDataBuffer) {
   uint16_t temperature = 0;
+  result_t result = RESULT_OK;
 
   if (useADCDataBuffer) {
-    temperature = readADCDataBuffer(ADC_TEMPERATURE);
+    result = readADCDataBuffer(ADC_TEMPERATURE, temperature);
   } else {
-    temperature = i2cReadReg8(SW35XX_ADC_TS_H) << 4;
-    temperature |= i2cReadReg8(SW35XX_ADC_TS_L) & 0x0F;
+    uint8_t high = 0;
+    uint8_t low = 0;
+    result = i2cReadReg8(SW35XX_ADC_TS_H, high);
+    if (result == RESULT_OK)
+      result = i2cReadReg8(SW35XX_ADC_TS_L, low);
+    temperature = (high << 4) | (low & 0x0F);
+    if (result == RESULT_OK) {
+      _raw[RAW_ADC_TS_H] = high;
+      _raw[RAW_ADC_TS_L] = low;
+    }
   }
 
   /* return it in mV */
-  return temperature * 0.5;
+  if (result == RESULT_OK)
+    mV = temperature * 0.5;
+  return result;
+}
+
+SW35xx::result_t SW35xx::unlock_i2c_write() {
+  result_t result = i2cWriteReg8(SW35XX_I2C_ENABLE, 0x20);
+  if (result == RESULT_OK)
+    result = i2cWriteReg8(SW35XX_I2C_ENABLE, 0x40);
+  if (result == RESULT_OK)
+    result = i2cWriteReg8(SW35XX_I2C_ENABLE, 0x80);
+  return result;
+}
+
+SW35xx::result_t SW35xx::lock_i2c_write() {
+  return i2cWriteReg8(SW35XX_I2C_ENABLE, 0x00);
+}
+
+void SW35xx::beginConfig() {
+  _batch = true;
+  _batchResult = RESULT_OK;
+}
+
+SW35xx::result_t SW35xx::endConfig() {
+  if (_unlocked) {
+    const result_t result = lock_i2c_write();
+    if (_batchResult == RESULT_OK)
+      _batchResult = result;
+    _unlocked = false;
+  }
+  _batch = false;
+  return _batchResult;
 }
 
-void SW35xx::unlock_i2c_write() {
-  i2cWriteReg8(SW35XX_I2C_ENABLE, 0x20);
-  i2cWriteReg8(SW35XX_I2C_ENABLE, 0x40);
-  i2cWriteReg8(SW35XX_I2C_ENABLE, 0x80);
+void SW35xx::invalidateConfigCache() {
+  _shadowValid = 0;
 }
 
-void SW35xx::lock_i2c_write() {
-  i2cWriteReg8(SW35XX_I2C_ENABLE, 0x00);
+SW35xx::result_t SW35xx::readConfigReg(const uint8_t reg, uint8_t &value) {
+  const uint8_t index = reg - SHADOW_FIRST;
+  if (_shadowValid & BIT(index)) {
+    value = _shadow[index];
+    return RESULT_OK;
+  }
+
+  const result_t result = i2cReadReg8(reg, value);
+  if (result == RESULT_OK) {
+    _shadow[index] = value;
+    _shadowValid |= BIT(index);
+  }
+  return result;
+}
+
+SW35xx::result_t SW35xx::writeConfigReg(const uint8_t reg, const uint8_t value) {
+  const uint8_t index = reg - SHADOW_FIRST;
+  if ((_shadowValid & BIT(index)) && _shadow[index] == value) {
+    _stats.skippedWrites++;
+    return RESULT_OK;
+  }
+  /* a failed step already aborted the batch, the remaining registers keep their old values */
+  if (_batchResult != RESULT_OK)
+    return _batchResult;
+
+  result_t result = RESULT_OK;
+  if (!_unlocked) {
+    result = unlock_i2c_write();
+    _unlocked = result == RESULT_OK;
+  }
+  if (result == RESULT_OK)
+    result = i2cWriteReg8(reg, value);
+
+  if (result == RESULT_OK) {
+    _shadow[index] = value;
+    _shadowValid |= BIT(index);
+  } else {
+    _batchResult = result;
+  }
+  return result;
 }
 
 void SW35xx::sendPDCmd(SW35xx::PDCmd_t cmd){
@@ -185,18 +328,22 @@ void SW35xx::rebroadcastPDO(){
   i2cWriteReg8(SW35XX_I2C_CTRL, 0x03);
 }
 
-void SW35xx::setMaxCurrent5A() {
-  unlock_i2c_write();
-  i2cWriteReg8(SW35XX_PD_CONF1, 0b01100100);
-  i2cWriteReg8(SW35XX_PD_CONF2, 0b01100100);
-  i2cWriteReg8(SW35XX_PD_CONF3, 0b01100100);
-  i2cWriteReg8(SW35XX_PD_CONF4, 0b01100100);
-  i2cWriteReg8(SW35XX_PD_CONF6, 0b01100100);
-  i2cWriteReg8(SW35XX_PD_CONF7, 0b01100100);
-  lock_i2c_write();
+SW35xx::result_t SW35xx::setMaxCurrent5A() {
+  const bool standalone = !_batch;
+  if (standalone)
+    beginConfig();
+
+  writeConfigReg(SW35XX_PD_CONF1, 0b01100100);
+  writeConfigReg(SW35XX_PD_CONF2, 0b01100100);
+  writeConfigReg(SW35XX_PD_CONF3, 0b01100100);
+  writeConfigReg(SW35XX_PD_CONF4, 0b01100100);
+  writeConfigReg(SW35XX_PD_CONF6, 0b01100100);
+  writeConfigReg(SW35XX_PD_CONF7, 0b01100100);
+
+  return standalone ? endConfig() : _batchResult;
 }
 
-void SW35xx::setQuickChargeConfiguration(const uint16_t flags,
+SW35xx::result_t SW35xx::setQuickChargeConfiguration(const uint16_t flags,
     const enum QuickChargePowerClass power) {
   /* mask all available bits to avoid setting reserved bits */
   const uint16_t validFlags = flags & QC_CONF_ALL;
@@ -204,20 +351,34 @@ void SW35xx::setQuickChargeConfiguration(const uint16_t flags,
   const uint8_t conf1 = validFlags;
   const uint8_t conf2 = (validFlags >> 8) | (validPower << 2);
 
-  unlock_i2c_write();
-  i2cWriteReg8(SW35XX_QC_CONF1, conf1);
-  i2cWriteReg8(SW35XX_QC_CONF2, conf2);
-  lock_i2c_write();
+  const bool standalone = !_batch;
+  if (standalone)
+    beginConfig();
+
+  writeConfigReg(SW35XX_QC_CONF1, conf1);
+  writeConfigReg(SW35XX_QC_CONF2, conf2);
+
+  return standalone ? endConfig() : _batchResult;
 }
 
-void SW35xx::setMaxCurrentsFixed(uint32_t ma_5v, uint32_t ma_9v, uint32_t ma_12v, uint32_t ma_15v, uint32_t ma_20v){
+SW35xx::result_t SW35xx::setMaxCurrentsFixed(uint32_t ma_5v, uint32_t ma_9v, uint32_t ma_12v, uint32_t ma_15v, uint32_t ma_20v){
   if(ma_5v > 5000) ma_5v = 5000;
   if(ma_9v > 5000) ma_9v = 5000;
   if(ma_12v > 5000) ma_12v = 5000;
   if(ma_15v > 5000) ma_15v = 5000;
   if(ma_20v > 5000) ma_20v = 5000;
 
-  uint8_t tmp = i2cReadReg8(SW35XX_PD_CONF8);
+  const bool standalone = !_batch;
+  if (standalone)
+    beginConfig();
+
+  uint8_t tmp = 0;
+  result_t result = readConfigReg(SW35XX_PD_CONF8, tmp);
+  if (result != RESULT_OK) {
+    if (_batchResult == RESULT_OK)
+      _batchResult = result;
+    return standalone ? endConfig() : _batchResult;
+  }
 
   if(ma_9v == 0)
     tmp &= 0b11111011;
@@ -238,47 +399,52 @@ void SW35xx::setMaxCurrentsFixed(uint32_t ma_5v, uint32_t ma_9v, uint32_t ma_12v
     tmp &= 0b11011111;
   else
     tmp |= 0b00100000;
-  
-  unlock_i2c_write();
 
-  i2cWriteReg8(SW35XX_PD_CONF8, tmp);
+  writeConfigReg(SW35XX_PD_CONF8, tmp);
 
-  i2cWriteReg8(SW35XX_PD_CONF1, ma_5v/50);
-  i2cWriteReg8(SW35XX_PD_CONF2, ma_9v/50);
-  i2cWriteReg8(SW35XX_PD_CONF3, ma_12v/50);
-  i2cWriteReg8(SW35XX_PD_CONF4, ma_15v/50);
-  i2cWriteReg8(SW35XX_PD_CONF5, ma_20v/50);
-
-  lock_i2c_write();
+  writeConfigReg(SW35XX_PD_CONF1, ma_5v/50);
+  writeConfigReg(SW35XX_PD_CONF2, ma_9v/50);
+  writeConfigReg(SW35XX_PD_CONF3, ma_12v/50);
+  writeConfigReg(SW35XX_PD_CONF4, ma_15v/50);
+  writeConfigReg(SW35XX_PD_CONF5, ma_20v/50);
 
+  return standalone ? endConfig() : _batchResult;
 }
 
-void SW35xx::setMaxCurrentsPPS(uint32_t ma_pps1, uint32_t ma_pps2) {
+SW35xx::result_t SW35xx::setMaxCurrentsPPS(uint32_t ma_pps1, uint32_t ma_pps2) {
   if (ma_pps1 > 5000)
     ma_pps1 = 5000;
   if (ma_pps2 > 5000)
     ma_pps2 = 5000;
-  uint8_t tmp = i2cReadReg8(SW35XX_PD_CONF8);
+
+  const bool standalone = !_batch;
+  if (standalone)
+    beginConfig();
+
+  uint8_t tmp = 0;
+  result_t result = readConfigReg(SW35XX_PD_CONF8, tmp);
+  if (result != RESULT_OK) {
+    if (_batchResult == RESULT_OK)
+      _batchResult = result;
+    return standalone ? endConfig() : _batchResult;
+  }
 
   if(ma_pps1 == 0)
     tmp &= 0b10111111;
   else
     tmp |= 0b01000000;
 
-  if(ma_pps1 == 0)
+  if(ma_pps2 == 0)
     tmp &= 0b01111111;
   else
     tmp |= 0b10000000;
-  
-  
-  unlock_i2c_write();
 
-  i2cWriteReg8(SW35XX_PD_CONF8, tmp);
+  writeConfigReg(SW35XX_PD_CONF8, tmp);
 
-  i2cWriteReg8(SW35XX_PD_CONF6, ma_pps1/50);
-  i2cWriteReg8(SW35XX_PD_CONF7, ma_pps2/50);
+  writeConfigReg(SW35XX_PD_CONF6, ma_pps1/50);
+  writeConfigReg(SW35XX_PD_CONF7, ma_pps2/50);
 
-  lock_i2c_write();
+  return standalone ? endConfig() : _batchResult;
 }
 
 } // namespace h1_SW35xx
@@ -29,6 +29,38 @@ public:
     HARDRESET = 1
   };
 
+  enum result_t {
+    RESULT_OK = 0,
+    RESULT_ADDRESS_NACK, // register address was not acknowledged
+    RESULT_DATA_NACK,    // written value was not acknowledged
+    RESULT_NO_DATA,      // the read returned no byte
+    RESULT_COUNT
+  };
+
+  /* Order of rawRegisters() */
+  enum rawRegister_t {
+    RAW_ADC_VIN_VOUT_L = 0,
+    RAW_ADC_VIN_H,
+    RAW_ADC_VOUT_H,
+    RAW_ADC_IOUT_USBC_USBA_L,
+    RAW_ADC_IOUT_USBC_H,
+    RAW_ADC_IOUT_USBA_H,
+    RAW_FCX_STATUS,
+    RAW_ADC_TS_H,
+    RAW_ADC_TS_L,
+    RAW_COUNT
+  };
+
+  struct errorStats_t {
+    uint32_t transfers;
+    uint32_t failures;
+    // Attempts beyond the first one of a transfer
+    uint32_t retries;
+    enum result_t lastError;
+    // Configuration writes skipped because the shadow already held the value
+    uint32_t skippedWrites;
+  };
+
   enum QuickChargeConfig {
     QC_CONF_NONE  = 0,
     QC_CONF_PE    = BIT(0),
@@ -61,28 +93,63 @@ private:
   };
 
   TwoWire &_i2c;
+  uint8_t _retries;
+  errorStats_t _stats;
+  uint8_t _raw[RAW_COUNT];
 
+  int readAttempt(const uint8_t reg);
+  int retryRead(const uint8_t reg, int result);
   int i2cReadReg8(const uint8_t reg);
-  int i2cWriteReg8(const uint8_t reg, const uint8_t data);
+  enum result_t i2cReadReg8(const uint8_t reg, uint8_t &value);
+  enum result_t i2cWriteReg8(const uint8_t reg, const uint8_t data);
+  enum result_t account(const enum result_t result);
 
-  void unlock_i2c_write();
-  void lock_i2c_write();
+  /* Shadow of the configuration registers this driver writes, PD_CONF1 (0xb0) to QC_CONF2 (0xba) */
+  static const uint8_t SHADOW_FIRST = 0xb0;
+  static const uint8_t SHADOW_SIZE = 11;
+  uint8_t _shadow[SHADOW_SIZE];
+  uint16_t _shadowValid;
+  bool _batch;
+  bool _unlocked;
+  enum result_t _batchResult;
 
-  uint16_t readADCDataBuffer(const enum ADCDataType type);
+  enum result_t unlock_i2c_write();
+  enum result_t lock_i2c_write();
+  enum result_t readConfigReg(const uint8_t reg, uint8_t &value);
+  enum result_t writeConfigReg(const uint8_t reg, const uint8_t value);
+
+  enum result_t readADCDataBuffer(const enum ADCDataType type, uint16_t &value);
 
 public:
   SW35xx(TwoWire &i2c = Wire);
   ~SW35xx();
   void begin();
+  /**
+   * @brief Attempts per register access before it fails, 10 by default
+   */
+  void setRetries(const uint8_t retries);
   /**
    * @brief Read the current charging status
    * 
+   * @return RESULT_OK, or the first error; on error the status fields keep their previous values
+   */
+  enum result_t readStatus(const bool useADCDataBuffer=false);
+  /**
+   * @brief Read the voltage of the NTC in mV
+   *
+   * @return RESULT_OK, or the first error; mV is not touched on error
    */
-  void readStatus(const bool useADCDataBuffer=false);
+  enum result_t readTemperature(float &mV, const bool useADCDataBuffer=false);
   /**
-   * @brief Returns the voltage of the NTC in mV
+   * @brief Register bytes behind the last successful readStatus() and readTemperature(), in rawRegister_t order
+   *
+   * @note Only filled when the ADC registers are read directly, not through the ADC data buffer
    */
-  float readTemperature(const bool useADCDataBuffer=false);
+  const uint8_t *rawRegisters() const;
+  /**
+   * @brief Register access counters since construction
+   */
+  const errorStats_t &errorStats() const;
   /**
    * @brief Send PD command
    * 
@@ -93,23 +160,44 @@ public:
    * @brief Rebroadcast PDO. After changing the maximum current, you need to call this function or replug the USB cable to make the settings take effect.
    */
   void rebroadcastPDO();
+  /**
+   * @brief Start a batch of configuration calls
+   *
+   * Configuration registers are cached write-through, so a call only writes the registers whose
+   * value changes. Outside a batch every call that changes something unlocks and relocks the
+   * chip on its own; inside a batch the chip is unlocked once, at the first changed register,
+   * and relocked by endConfig().
+   */
+  void beginConfig();
+  /**
+   * @brief Finish a batch, relocks the chip if anything was written
+   * 
+   * @return RESULT_OK, or the first error of the batch
+   */
+  enum result_t endConfig();
+  /**
+   * @brief Forget the cached configuration, the next calls write every register again
+   * 
+   * @note Call it when the chip may have been reset behind the driver's back. A failed transfer does it too.
+   */
+  void invalidateConfigCache();
   /**
    * @brief Enable or disable the support for certain quick charge features
    * @param flags Multiple values of QuickChargeConfig combined with bitwise or
    */
-  void setQuickChargeConfiguration(const uint16_t flags,
+  enum result_t setQuickChargeConfiguration(const uint16_t flags,
       const enum QuickChargePowerClass power);
   /**
    * @brief Set the maximum output current of all PD groups to 5A. Use with caution if your chip is not sw3518s
    */
-  void setMaxCurrent5A();
+  enum result_t setMaxCurrent5A();
    /**
    * @brief Set the maximum output current of fixed voltage groups
    * 
    * @param ma_xx Maximum output current of each group in mA, minimum step is 50mA, set to 0 to disable
    * @note 5V cannot be disabled
    */
-  void setMaxCurrentsFixed(uint32_t ma_5v, uint32_t ma_9v, uint32_t ma_12v, uint32_t ma_15v, uint32_t ma_20v);
+  enum result_t setMaxCurrentsFixed(uint32_t ma_5v, uint32_t ma_9v, uint32_t ma_12v, uint32_t ma_15v, uint32_t ma_20v);
   /**
    * @brief Set the maximum output current of PPS groups
    * 
@@ -117,7 +205,7 @@ public:
    * @note Note that when the maximum power configured by PD is greater than 60W, pps1 will not be broadcast (TODO: the datasheet says so, but I haven't tried it)
    *       The maximum voltage of pps1 needs to be greater than that of pps0, otherwise pps1 will not be broadcast;
    */
-  void setMaxCurrentsPPS(uint32_t ma_pps1, uint32_t ma_pps2);
+  enum result_t setMaxCurrentsPPS(uint32_t ma_pps1, uint32_t ma_pps2);
   /**
   //  * @brief Reset the maximum output current
   //  * 
@@ -11,8 +11,17 @@
 # An example of an upload URL:
 #                custom_upload_url = http://192.168.1.123/update 
 # also possible: custom_upload_url = http://domainname/update
+#
+# Firmware images are gzip-compressed before upload (custom_upload_compress = no to
+# disable). The ESP8266 Updater accepts gzip images and eboot inflates them while
+# copying to flash. Filesystem images are sent raw: inflating them needs ATOMIC_FS_UPDATE,
+# which stages the whole image in the sketch area and does not fit a 4m1m/4m2m layout.
+#
+# tools/ota_upload checks the compression on the host, `make test` there.
 
 import sys
+import io
+import gzip
 import requests
 import hashlib
 from urllib.parse import urlparse
@@ -29,6 +38,16 @@ except ImportError:
     from requests_toolbelt import MultipartEncoder, MultipartEncoderMonitor
     from tqdm import tqdm
 
+FS_IMAGES = ("spiffs.bin", "littlefs.bin")
+
+def prepare_image(name, image, compress=True):
+    """Returns the bytes to send for an image file and the ElegantOTA mode of it."""
+    if name in FS_IMAGES:
+        return image, "fs"
+    if compress and image[:2] != b'\x1f\x8b':
+        image = gzip.compress(image, 9)
+    return image, "fr"
+
 def on_upload(source, target, env):
     firmware_path = str(source[0])
 
@@ -36,15 +55,22 @@ def on_upload(source, target, env):
     upload_url_compatibility = env.GetProjectOption('custom_upload_url')
     upload_url = upload_url_compatibility.replace("/update", "")
 
-    with open(firmware_path, 'rb') as firmware:
-        md5 = hashlib.md5(firmware.read()).hexdigest()
+    with open(firmware_path, 'rb') as image_file:
+        image = image_file.read()
+
+    raw_size = len(image)
+    compress = str(env.GetProjectOption('custom_upload_compress', 'yes')).lower() not in ('no', 'false', '0')
+    image, file_type = prepare_image(source[0].name, image, compress)
+    if len(image) != raw_size:
+        print(f"Compressed {source[0].name}: {raw_size} -> {len(image)} bytes ({100 * len(image) / raw_size:.1f}%)")
+
+    with io.BytesIO(image) as firmware:
+        # The device verifies the MD5 of the bytes it receives, i.e. the compressed image
+        md5 = hashlib.md5(image).hexdigest()
 
         parsed_url = urlparse(upload_url)
         host_ip = parsed_url.netloc
 
-        is_spiffs = source[0].name == "spiffs.bin"
-        file_type = "fs" if is_spiffs else "fr"
-
         # execute GET request
         start_url = f"{upload_url}/ota/start?mode={file_type}&hash={md5}"
 
@@ -124,13 +150,16 @@ def on_upload(source, target, env):
             'Origin': f'{upload_url}'
         }
 
+        upload_start = time.time()
         try:
             response = requests.post(f"{upload_url}/ota/upload", data=monitor, headers=post_headers, auth=auth)
         except Exception as e:
             return 'Error while uploading: ' + repr(e)
+        upload_time = time.time() - upload_start
         
         bar.close()
         time.sleep(0.1)
+        tqdm.write(f"Sent {len(image)} of {raw_size} bytes in {upload_time:.1f}s ({len(image) / 1024 / max(upload_time, 0.001):.1f} KB/s)")
         
         if response.status_code != 200:
             message = "\nUpload failed.\nServer response: " + response.text
@@ -0,0 +1,67 @@
+#include "BootSequencer.h"
+
+void BootSequencer::close(uint32_t now)
+{
+    if (open)
+    {
+        BootPhase &last = phases[phaseCount - 1];
+        last.durationUs = now - last.startUs;
+        open = false;
+    }
+}
+
+void BootSequencer::phase(const char *name)
+{
+    uint32_t now = micros();
+    close(now);
+    if (phaseCount == kMaxPhases)
+    {
+        return;
+    }
+    phases[phaseCount++] = {name, now, 0};
+    open = true;
+}
+
+void BootSequencer::finish()
+{
+    uint32_t now = micros();
+    close(now);
+    setupDoneUs = now;
+}
+
+void BootSequencer::record(const char *name, uint32_t startUs)
+{
+    if (phaseCount == kMaxPhases || open)
+    {
+        return;
+    }
+    phases[phaseCount++] = {name, startUs, micros() - startUs};
+}
+
+void BootSequencer::markFirstSample()
+{
+    if (firstSampleAtUs == 0)
+    {
+        firstSampleAtUs = micros();
+    }
+}
+
+uint8_t BootSequencer::count() const
+{
+    return phaseCount;
+}
+
+const BootPhase &BootSequencer::at(uint8_t index) const
+{
+    return phases[index];
+}
+
+uint32_t BootSequencer::setupUs() const
+{
+    return setupDoneUs;
+}
+
+uint32_t BootSequencer::firstSampleUs() const
+{
+    return firstSampleAtUs;
+}
@@ -37,7 +37,7 @@ void Config::saveConfig()
 {
     // Serial.println("Begin save configuration file");
     // Create a JSON document to hold the configuration
-    DynamicJsonDocument doc(256);
+    DynamicJsonDocument doc(kConfigDocumentSize);
 
     // Convert the configuration struct to JSON
     doc["state"] = this->state;
@@ -46,6 +46,21 @@ void Config::saveConfig()
     doc["totalEnergy3"] = this->totalEnergy3;
     doc["totalEnergy4"] = this->totalEnergy4;
     doc["serverName"] = this->serverName;
+    doc["mqttEnabled"] = this->mqttEnabled;
+    doc["mqttHost"] = this->mqttHost;
+    doc["mqttPort"] = this->mqttPort;
+    doc["mqttUser"] = this->mqttUser;
+    doc["mqttPassword"] = this->mqttPassword;
+    doc["mqttInterval"] = this->mqttInterval;
+    doc["udpEnabled"] = this->udpEnabled;
+    doc["udpAddress"] = this->udpAddress;
+    doc["bootDiagnostics"] = this->bootDiagnostics;
+    JsonObject parametersObject = doc.createNestedObject("parameters");
+    for (uint8_t i = 0; i < PARAM_COUNT; i++)
+    {
+        ParameterId id = (ParameterId)i;
+        parametersObject[Parameters::info(id).name] = this->parameters.get(id);
+    }
 
     // Open the configuration file in write mode
     File configFile = LittleFS.open(CONFIG_FILE, "w");
@@ -58,18 +73,22 @@ void Config::saveConfig()
     // Serialize JSON to the file
     serializeJson(doc, configFile);
     configFile.close();
+    dirty = false;
 
     // Serial.println("Save configuration file successfully");
 }
 
-bool Config::loadConfig()
+void Config::saveConfigIfNeeded()
 {
-    if (!LittleFS.begin())
+    if (dirty)
     {
-        Serial.println("LittleFS Mount Failed");
-        return false;
+        saveConfig();
     }
+}
 
+// LittleFS is mounted once in setup() before the config is created
+bool Config::loadConfig()
+{
     // Open the configuration file in read mode
     File configFile = LittleFS.open(CONFIG_FILE, "r");
     if (!configFile)
@@ -79,7 +98,7 @@ bool Config::loadConfig()
     }
 
     // Parse the JSON file into a JSON document
-    DynamicJsonDocument doc(256);
+    DynamicJsonDocument doc(kConfigDocumentSize);
     DeserializationError error = deserializeJson(doc, configFile);
 
     // Check for parsing errors
@@ -96,6 +115,32 @@ bool Config::loadConfig()
     this->totalEnergy3 = doc["totalEnergy3"].as<float>();
     this->totalEnergy4 = doc["totalEnergy4"].as<float>();
     this->serverName = doc["serverName"].isNull() ? defaultName() : doc["serverName"].as<String>();
+    this->mqttEnabled = doc["mqttEnabled"] | false;
+    this->mqttHost = doc["mqttHost"] | "";
+    this->mqttPort = doc["mqttPort"] | 1883;
+    this->mqttUser = doc["mqttUser"] | "";
+    this->mqttPassword = doc["mqttPassword"] | "";
+    this->mqttInterval = doc["mqttInterval"] | kMqttPublishInterval;
+    this->udpEnabled = doc["udpEnabled"] | false;
+    this->udpAddress = doc["udpAddress"] | "";
+    this->bootDiagnostics = doc["bootDiagnostics"] | false;
+
+    // Unknown or out of range values keep their defaults, a broken set falls back entirely
+    this->parameters.reset();
+    JsonObject parametersObject = doc["parameters"];
+    for (JsonPair parameter : parametersObject)
+    {
+        ParameterId id = Parameters::find(parameter.key().c_str());
+        if (id != PARAM_COUNT && parameter.value().is<float>())
+        {
+            this->parameters.set(id, parameter.value().as<float>());
+        }
+    }
+    if (this->parameters.validate())
+    {
+        Serial.println("Invalid parameters in the configuration, using defaults");
+        this->parameters.reset();
+    }
 
     configFile.close();
     return true;
@@ -124,7 +169,8 @@ void Config::updateTotalEnergy(float energy, int port) {
         return;
     }
 
-    saveConfig();
+    // Energy changes every sample, flash writes are batched by saveConfigIfNeeded()
+    dirty = true;
 }
 
 float Config::totalEnergyOf(int port) {
@@ -0,0 +1,167 @@
+#include "Connectivity.h"
+#include <ESP8266WiFi.h>
+#include <ESPAsyncWiFiManager.h>
+#include "log.h"
+
+void Connectivity::begin(AsyncWiFiManager *manager, const String &portalName, TaskCallback onLinkUp)
+{
+    this->manager = manager;
+    this->portalName = portalName;
+    this->onLinkUp = onLinkUp;
+
+    WiFi.setAutoReconnect(false);
+    WiFi.mode(WIFI_STA);
+    linkStats.changedAt = millis();
+    nextAttempt = millis();
+}
+
+void Connectivity::loop()
+{
+    uint32_t now = millis();
+    bool connected = WiFi.status() == WL_CONNECTED;
+    if (portal)
+    {
+        manager->loop();
+    }
+
+    switch (linkState)
+    {
+    case LINK_ONLINE:
+        if (!connected)
+        {
+            logMessage("WiFi link lost", true);
+            linkStats.drops++;
+            backoffMs = kWifiBackoffMin;
+            linkDown(now);
+        }
+        break;
+
+    case LINK_CONNECTING:
+        if (connected)
+        {
+            linkUp(now);
+        }
+        else if (now - attemptStart >= kWifiConnectTimeout)
+        {
+            // A wrong password or a network that moved away, give the user a way to fix it
+            if (++failures >= kWifiPortalAfterFailures && !portal)
+            {
+                logMessage("WiFi failed " + String(failures) + " times, starting the setup portal", true);
+                openPortal();
+            }
+            linkDown(now);
+        }
+        break;
+
+    case LINK_PORTAL:
+        if (connected)
+        {
+            linkUp(now);
+        }
+        break;
+
+    default:
+        if (connected)
+        {
+            linkUp(now);
+        }
+        else if ((int32_t)(now - nextAttempt) >= 0)
+        {
+            attempt(now);
+        }
+        break;
+    }
+}
+
+void Connectivity::attempt(uint32_t now)
+{
+    if (WiFi.SSID().length() == 0)
+    {
+        logMessage("No saved WiFi, starting the setup portal", true);
+        openPortal();
+        setState(LINK_PORTAL, now);
+        return;
+    }
+
+    linkStats.attempts++;
+    attemptStart = now;
+    // Saved credentials, the SDK keeps them in flash
+    WiFi.begin();
+    setState(LINK_CONNECTING, now);
+}
+
+void Connectivity::openPortal()
+{
+    manager->startConfigPortalModeless(portalName.c_str(), nullptr);
+    portal = true;
+}
+
+void Connectivity::linkUp(uint32_t now)
+{
+    if (portal)
+    {
+        // Credentials were saved through the portal or the saved network came back, the
+        // access point is not needed anymore
+        WiFi.mode(WIFI_STA);
+        portal = false;
+    }
+    failures = 0;
+    linkStats.connects++;
+    backoffMs = kWifiBackoffMin;
+    setState(LINK_ONLINE, now);
+    logMessage("WiFi connected, IP " + WiFi.localIP().toString(), true);
+    if (onLinkUp)
+    {
+        onLinkUp();
+    }
+}
+
+void Connectivity::linkDown(uint32_t now)
+{
+    // No WiFi.disconnect() here, with persistence on it would also erase the saved network
+    nextAttempt = now + backoffMs;
+    backoffMs = min(backoffMs * 2, (uint32_t)kWifiBackoffMax);
+    setState(LINK_OFFLINE, now);
+}
+
+void Connectivity::setState(LinkState state, uint32_t now)
+{
+    bool wasOnline = linkState == LINK_ONLINE;
+    if (wasOnline == (state == LINK_ONLINE))
+    {
+        linkState = state;
+        return;
+    }
+
+    if (!wasOnline)
+    {
+        linkStats.offlineMs += now - linkStats.changedAt;
+    }
+    linkStats.changedAt = now;
+    linkState = state;
+}
+
+LinkState Connectivity::state() const
+{
+    return linkState;
+}
+
+bool Connectivity::isOnline() const
+{
+    return linkState == LINK_ONLINE;
+}
+
+uint32_t Connectivity::backoff() const
+{
+    return backoffMs;
+}
+
+bool Connectivity::portalOpen() const
+{
+    return portal;
+}
+
+const ConnectivityStats &Connectivity::stats() const
+{
+    return linkStats;
+}
@@ -0,0 +1,362 @@
+#include "DeviceBench.h"
+#include <LittleFS.h>
+#include <Wire.h>
+#include "MonitorJson.h"
+
+// The SW35xx chargers and the OLED answer on the same address, each behind its own channel
+constexpr uint8_t kBenchAddress = 0x3C;
+// SW35xx IC version, harmless to read repeatedly
+constexpr uint8_t kBenchRegister = 0x01;
+// OLED control byte for a command and the NOP command, SSD1306 and SH1106 alike
+constexpr uint8_t kBenchOledCommand = 0x00;
+constexpr uint8_t kBenchOledNop = 0xE3;
+constexpr uint8_t kBenchPages = 8;
+
+DeviceBench *DeviceBench::active = nullptr;
+
+void BenchLatency::add(uint32_t us)
+{
+    minUs = count == 0 ? us : min(minUs, us);
+    maxUs = max(maxUs, us);
+    totalUs += us;
+    count++;
+}
+
+uint32_t BenchLatency::averageUs() const
+{
+    return count ? totalUs / count : 0;
+}
+
+DeviceBench::DeviceBench(I2CQueue &queue) : queue(queue)
+{
+}
+
+void DeviceBench::begin(I2CJobCallback displayPage, const SnapshotBuffer<MonitorSnapshot> &snapshot, const TaskStats *watched)
+{
+    this->displayPage = displayPage;
+    this->snapshot = &snapshot;
+    this->watched = watched;
+}
+
+bool DeviceBench::start()
+{
+    if (isRunning())
+    {
+        return false;
+    }
+
+    benchResults = DeviceBenchResults();
+    active = this;
+    startedAt = millis();
+    overrunsAtStart = watched ? watched->overruns : 0;
+    lastLoopUs = 0;
+    enter(BENCH_I2C);
+    return true;
+}
+
+void DeviceBench::enter(DeviceBenchState state)
+{
+    benchState = state;
+    phaseStartedAt = millis();
+    submitted = 0;
+    completed = 0;
+    pass = 0;
+    passUs = 0;
+    fileOffset = 0;
+    fileUs = 0;
+
+    if (state == BENCH_DONE)
+    {
+        benchResults.durationMs = millis() - startedAt;
+        benchResults.overruns = watched ? watched->overruns - overrunsAtStart : 0;
+    }
+}
+
+bool DeviceBench::timedOut()
+{
+    if (millis() - phaseStartedAt < kBenchPhaseTimeout)
+    {
+        return false;
+    }
+    benchResults.timedOut |= 1 << benchState;
+    return true;
+}
+
+void DeviceBench::step()
+{
+    switch (benchState)
+    {
+    case BENCH_I2C:
+        stepI2C();
+        break;
+    case BENCH_DISPLAY:
+        stepDisplay();
+        break;
+    case BENCH_FS_WRITE:
+        stepWrite();
+        break;
+    case BENCH_FS_READ:
+        stepRead();
+        break;
+    case BENCH_JSON:
+        stepJson();
+        break;
+    default:
+        break;
+    }
+}
+
+void DeviceBench::loopTick()
+{
+    if (!isRunning())
+    {
+        return;
+    }
+
+    uint32_t now = micros();
+    if (lastLoopUs != 0)
+    {
+        benchResults.loop.add(now - lastLoopUs);
+    }
+    lastLoopUs = now;
+}
+
+void DeviceBench::readChannel(uint8_t channel, bool selected)
+{
+    // Left over from a phase that timed out
+    if (active->benchState != BENCH_I2C)
+    {
+        return;
+    }
+
+    DeviceBenchResults &results = active->benchResults;
+    if (!selected)
+    {
+        results.i2cFailures[channel] += kBenchI2CReads;
+        active->completed++;
+        return;
+    }
+    for (uint8_t i = 0; i < kBenchI2CReads; i++)
+    {
+        uint32_t start = micros();
+        bool ok;
+        if (channel == 0)
+        {
+            // The SSD1306 does not answer reads, a NOP command write is its round trip
+            Wire.beginTransmission(kBenchAddress);
+            Wire.write(kBenchOledCommand);
+            Wire.write(kBenchOledNop);
+            ok = Wire.endTransmission() == 0;
+        }
+        else
+        {
+            Wire.beginTransmission(kBenchAddress);
+            Wire.write(kBenchRegister);
+            ok = Wire.endTransmission(false) == 0 && Wire.requestFrom(kBenchAddress, (uint8_t)1) == 1;
+            if (ok)
+            {
+                Wire.read();
+            }
+        }
+        if (ok)
+        {
+            results.i2c[channel].add(micros() - start);
+        }
+        else
+        {
+            results.i2cFailures[channel]++;
+        }
+    }
+    active->completed++;
+}
+
+void DeviceBench::stepI2C()
+{
+    while (submitted < kBenchChannels)
+    {
+        I2CTarget target = submitted == 0 ? I2C_TARGET_DISPLAY : I2C_TARGET_CHARGER;
+        // Display priority, a sample due meanwhile still goes first
+        if (!queue.submit(I2C_PRIORITY_DISPLAY, submitted, target, readChannel, submitted))
+        {
+            break;
+        }
+        submitted++;
+    }
+
+    if (completed == kBenchChannels || timedOut())
+    {
+        enter(BENCH_DISPLAY);
+    }
+}
+
+void DeviceBench::flushPage(uint8_t page, bool selected)
+{
+    uint32_t start = micros();
+    active->displayPage(page, selected);
+    uint32_t elapsed = micros() - start;
+
+    if (active->benchState != BENCH_DISPLAY)
+    {
+        return;
+    }
+    // Nothing was written, the pass still completes so the phase does not wait for the timeout
+    if (!selected)
+    {
+        active->completed++;
+        return;
+    }
+    active->benchResults.displayPage.add(elapsed);
+    active->passUs += elapsed;
+    active->completed++;
+}
+
+void DeviceBench::stepDisplay()
+{
+    while (submitted < kBenchPages)
+    {
+        if (!queue.submit(I2C_PRIORITY_DISPLAY, 0, I2C_TARGET_DISPLAY, flushPage, submitted))
+        {
+            break;
+        }
+        submitted++;
+    }
+
+    if (completed == kBenchPages)
+    {
+        benchResults.displayPagesSum.add(passUs);
+        submitted = 0;
+        completed = 0;
+        passUs = 0;
+        if (++pass < kBenchDisplayPasses)
+        {
+            return;
+        }
+    }
+    else if (!timedOut())
+    {
+        return;
+    }
+
+    enter(BENCH_FS_WRITE);
+}
+
+void DeviceBench::stepWrite()
+{
+    static uint8_t pattern[kUploadPageSize];
+    if (fileOffset == 0 && !file)
+    {
+        for (size_t i = 0; i < sizeof(pattern); i++)
+        {
+            pattern[i] = i * 31;
+        }
+        file = LittleFS.open(BENCH_FILE, "w");
+        if (!file)
+        {
+            benchResults.timedOut |= 1 << BENCH_FS_WRITE;
+            enter(BENCH_JSON);
+            return;
+        }
+    }
+
+    bool failed = false;
+    uint32_t start = micros();
+    for (uint32_t done = 0; done < kBenchStepBytes && fileOffset < kBenchFileBytes; done += sizeof(pattern))
+    {
+        if (file.write(pattern, sizeof(pattern)) != sizeof(pattern))
+        {
+            // Filesystem full, measure what was written
+            failed = true;
+            break;
+        }
+        fileOffset += sizeof(pattern);
+    }
+    fileUs += micros() - start;
+
+    if (fileOffset < kBenchFileBytes && !failed && !timedOut())
+    {
+        return;
+    }
+
+    start = micros();
+    file.close();
+    fileUs += micros() - start;
+    benchResults.fsWriteBytesPerSecond = (uint64_t)fileOffset * 1000000 / max(fileUs, (uint32_t)1);
+    enter(BENCH_FS_READ);
+}
+
+void DeviceBench::stepRead()
+{
+    static uint8_t buffer[kUploadPageSize];
+    if (fileOffset == 0 && !file)
+    {
+        file = LittleFS.open(BENCH_FILE, "r");
+        if (!file)
+        {
+            benchResults.timedOut |= 1 << BENCH_FS_READ;
+            enter(BENCH_JSON);
+            return;
+        }
+    }
+
+    bool finished = false;
+    uint32_t start = micros();
+    for (uint32_t done = 0; done < kBenchStepBytes; done += sizeof(buffer))
+    {
+        size_t count = file.read(buffer, sizeof(buffer));
+        fileOffset += count;
+        if (count < sizeof(buffer))
+        {
+            finished = true;
+            break;
+        }
+    }
+    fileUs += micros() - start;
+
+    if (!finished && !timedOut())
+    {
+        return;
+    }
+
+    file.close();
+    LittleFS.remove(BENCH_FILE);
+    benchResults.fsReadBytesPerSecond = (uint64_t)fileOffset * 1000000 / max(fileUs, (uint32_t)1);
+    enter(BENCH_JSON);
+}
+
+void DeviceBench::stepJson()
+{
+    MonitorSnapshot copy;
+    if (!snapshot->read(copy))
+    {
+        if (timedOut())
+        {
+            enter(BENCH_DONE);
+        }
+        return;
+    }
+
+    String response;
+    for (uint8_t i = 0; i < kBenchJsonRuns; i++)
+    {
+        uint32_t start = micros();
+        response = "";
+        writeMonitorJson(copy, response);
+        benchResults.json.add(micros() - start);
+    }
+    enter(BENCH_DONE);
+}
+
+DeviceBenchState DeviceBench::state() const
+{
+    return benchState;
+}
+
+bool DeviceBench::isRunning() const
+{
+    return benchState != BENCH_IDLE && benchState != BENCH_DONE;
+}
+
+const DeviceBenchResults &DeviceBench::results() const
+{
+    return benchResults;
+}
@@ -51,7 +51,6 @@ bool Emoticons::draw(SCREEN_CLASS *display, int screen_width, int screen_height,
                 }
             }
         }
-        display->display();
         return true;
     }
     else
@@ -114,46 +113,14 @@ void Emoticons::addListener(AsyncWebServer *server)
                });
 
     server->on("/emoticons", HTTP_POST, [](AsyncWebServerRequest *request)
-               { request->send(200, "text/plain", "File written successfully"); }, [](AsyncWebServerRequest *request, String filename, size_t index, uint8_t *data, size_t len, bool final)
+               { mySelf->uploadSink.sendResult(request, "File written successfully"); }, [](AsyncWebServerRequest *request, String filename, size_t index, uint8_t *data, size_t len, bool final)
                {
-                
-        if (index == 0) {
-            // First chunk of data, open the file
-            String fn = "/" + filename;
-            Serial.print("Starting emoticon upload: ");
-            Serial.println(fn);
-            if (LittleFS.exists(fn))
-            {
-                LittleFS.remove(fn); // Remove the existing file if it exists
-            }
-            mySelf->uploadFile = LittleFS.open(fn, "w");
-            if (!mySelf->uploadFile)
-            {
-                request->send(500, "text/plain", "Failed to open file for writing");
-                return;
-            }
-        }
-
-        // Write the current chunk to the file
-        if (mySelf->uploadFile)
-        {
-            mySelf->uploadFile.write(data, len);
-            Serial.println("Written " + String(len) + " bytes");
-        }
-        else
-        {
-            Serial.println("File not open during write");
-        }
+        mySelf->uploadSink.handleChunk(request, "/" + filename, index, data, len, final);
 
-        if (final)
+        // Only a verified upload that replaced the target changes the index
+        if (final && mySelf->uploadSink.succeeded())
         {
-            // All chunks received
-            Serial.println("Emoticon upload complete");
-            if (mySelf->uploadFile)
-            {
-                mySelf->uploadFile.close();
-                mySelf->loadEmoticons();
-            }
+            mySelf->loadEmoticons();
         }
          });
 }
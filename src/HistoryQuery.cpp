@@ -0,0 +1,244 @@
+#include "HistoryQuery.h"
+#include <math.h>
+
+void HistoryQuery::begin(uint8_t port, uint32_t from, uint32_t to, uint16_t points, HistoryQueryMode mode, HistorySeries series)
+{
+    this->port = port < kHistoryPorts ? port : 0;
+    this->from = from;
+    this->mode = mode;
+    this->series = series;
+
+    uint32_t span = to >= from ? to - from + 1 : 1;
+    uint16_t buckets = points > 0 ? points : 1;
+    // LTTB spends two of its points on the first and last sample
+    if (mode == HISTORY_QUERY_LTTB && buckets > 2)
+    {
+        buckets -= 2;
+    }
+    bucketLength = (span + buckets - 1) / buckets;
+    if (bucketLength < kHistoryInterval)
+    {
+        bucketLength = kHistoryInterval;
+    }
+
+    hasCurrent = false;
+    hasPrevious = false;
+    hasAnchor = false;
+    outputHead = 0;
+    outputCount = 0;
+}
+
+uint32_t HistoryQuery::bucketSeconds() const
+{
+    return bucketLength;
+}
+
+uint32_t HistoryQuery::valueOf(const HistoryPoint &point) const
+{
+    switch (series)
+    {
+    case HISTORY_SERIES_VOLTAGE:
+        return point.voltage_mV[port];
+    case HISTORY_SERIES_CURRENT:
+        return point.current_mA[port];
+    default:
+        return (uint32_t)point.voltage_mV[port] * point.current_mA[port] / 1000;
+    }
+}
+
+void HistoryQuery::startBucket(uint32_t index)
+{
+    memset(&current, 0, sizeof(current));
+    current.index = index;
+    current.voltageMin = UINT16_MAX;
+    current.currentMin = UINT16_MAX;
+    hasCurrent = true;
+}
+
+void HistoryQuery::add(const HistoryPoint &point)
+{
+    if (point.time < from)
+    {
+        return;
+    }
+
+    uint32_t index = (point.time - from) / bucketLength;
+    if (hasCurrent && index != current.index)
+    {
+        closeBucket();
+    }
+    if (!hasCurrent)
+    {
+        startBucket(index);
+    }
+
+    uint16_t voltage = point.voltage_mV[port];
+    uint16_t amps = point.current_mA[port];
+    current.count++;
+    current.voltageMin = min(current.voltageMin, voltage);
+    current.voltageMax = max(current.voltageMax, voltage);
+    current.currentMin = min(current.currentMin, amps);
+    current.currentMax = max(current.currentMax, amps);
+    current.voltageSum += voltage;
+    current.currentSum += amps;
+    current.powerSum += (uint32_t)voltage * amps / 1000;
+
+    Candidate candidate = {point.time, valueOf(point)};
+    last = candidate;
+    if (mode != HISTORY_QUERY_LTTB)
+    {
+        return;
+    }
+
+    current.timeSum += point.time - from;
+    current.valueSum += candidate.value;
+    if (!hasAnchor)
+    {
+        // LTTB always keeps the first point
+        anchor = candidate;
+        hasAnchor = true;
+        pushPoint(candidate);
+    }
+
+    uint8_t slice = (uint64_t)(point.time - from - index * bucketLength) * kSubBuckets / bucketLength;
+    if (!current.used[slice])
+    {
+        current.used[slice] = true;
+        current.low[slice] = candidate;
+        current.high[slice] = candidate;
+    }
+    else if (candidate.value < current.low[slice].value)
+    {
+        current.low[slice] = candidate;
+    }
+    else if (candidate.value > current.high[slice].value)
+    {
+        current.high[slice] = candidate;
+    }
+}
+
+void HistoryQuery::closeBucket()
+{
+    hasCurrent = false;
+    if (mode == HISTORY_QUERY_MINMAX)
+    {
+        HistoryRow row;
+        row.time = from + current.index * bucketLength;
+        row.count = current.count;
+        row.voltageMin = current.voltageMin;
+        row.voltageAvg = current.voltageSum / current.count;
+        row.voltageMax = current.voltageMax;
+        row.currentMin = current.currentMin;
+        row.currentAvg = current.currentSum / current.count;
+        row.currentMax = current.currentMax;
+        row.value = current.powerSum / current.count;
+        push(row);
+        return;
+    }
+
+    // The previous bucket can be decided now that the average of this one is known
+    if (hasPrevious)
+    {
+        select(previous, current.timeSum / current.count, current.valueSum / current.count);
+    }
+    previous = current;
+    hasPrevious = true;
+}
+
+void HistoryQuery::finish()
+{
+    if (mode == HISTORY_QUERY_MINMAX)
+    {
+        if (hasCurrent)
+        {
+            closeBucket();
+        }
+        return;
+    }
+
+    if (hasCurrent)
+    {
+        closeBucket();
+    }
+    if (hasPrevious)
+    {
+        // Nothing follows the last bucket, aim the triangle at the final point instead
+        select(previous, last.time - from, last.value);
+        hasPrevious = false;
+    }
+    if (hasAnchor && last.time > anchor.time)
+    {
+        anchor = last;
+        pushPoint(last);
+    }
+}
+
+void HistoryQuery::select(const Bucket &bucket, uint64_t nextTime, uint64_t nextValue)
+{
+    double anchorTime = (double)(anchor.time - from);
+    double anchorValue = anchor.value;
+    double best = -1;
+    Candidate chosen = {0, 0};
+
+    for (uint8_t slice = 0; slice < kSubBuckets; slice++)
+    {
+        if (!bucket.used[slice])
+        {
+            continue;
+        }
+        const Candidate *options[2] = {&bucket.low[slice], &bucket.high[slice]};
+        for (const Candidate *option : options)
+        {
+            if (option->time <= anchor.time)
+            {
+                continue;
+            }
+            double area = fabs((anchorTime - (double)nextTime) * ((double)option->value - anchorValue) -
+                               (anchorTime - (double)(option->time - from)) * ((double)nextValue - anchorValue));
+            if (area > best)
+            {
+                best = area;
+                chosen = *option;
+            }
+        }
+    }
+
+    if (best >= 0)
+    {
+        anchor = chosen;
+        pushPoint(chosen);
+    }
+}
+
+void HistoryQuery::pushPoint(const Candidate &candidate)
+{
+    HistoryRow row;
+    memset(&row, 0, sizeof(row));
+    row.time = candidate.time;
+    row.count = 1;
+    row.value = candidate.value;
+    push(row);
+}
+
+void HistoryQuery::push(const HistoryRow &row)
+{
+    if (outputCount == kOutputSize)
+    {
+        // Callers drain after every add(), this only guards against misuse
+        return;
+    }
+    output[(outputHead + outputCount) % kOutputSize] = row;
+    outputCount++;
+}
+
+bool HistoryQuery::pop(HistoryRow &row)
+{
+    if (outputCount == 0)
+    {
+        return false;
+    }
+    row = output[outputHead];
+    outputHead = (outputHead + 1) % kOutputSize;
+    outputCount--;
+    return true;
+}
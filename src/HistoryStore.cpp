@@ -0,0 +1,524 @@
+#include "HistoryStore.h"
+#include <LittleFS.h>
+#include <algorithm>
+#include <time.h>
+#include "log.h"
+
+uint16_t historyChecksum(const uint8_t *data, size_t length)
+{
+    uint16_t sum1 = 0;
+    uint16_t sum2 = 0;
+    for (size_t i = 0; i < length; i++)
+    {
+        sum1 = (sum1 + data[i]) % 255;
+        sum2 = (sum2 + sum1) % 255;
+    }
+    return (sum2 << 8) | sum1;
+}
+
+void historyToChannels(const HistoryPoint &point, uint16_t *values)
+{
+    memcpy(values, point.voltage_mV, sizeof(point.voltage_mV));
+    memcpy(values + kHistoryPorts, point.current_mA, sizeof(point.current_mA));
+}
+
+void historyFromChannels(uint32_t time, const uint16_t *values, HistoryPoint &point)
+{
+    point.time = time;
+    memcpy(point.voltage_mV, values, sizeof(point.voltage_mV));
+    memcpy(point.current_mA, values + kHistoryPorts, sizeof(point.current_mA));
+}
+
+static uint32_t windowOf(uint32_t time)
+{
+    return time - time % kHistorySegmentSeconds;
+}
+
+String HistoryStore::segmentPath(uint32_t window)
+{
+    return String(HISTORY_DIR "/") + String(window) + ".seg";
+}
+
+String HistoryStore::indexPath(uint32_t window)
+{
+    return String(HISTORY_DIR "/") + String(window) + ".idx";
+}
+
+void HistoryStore::begin()
+{
+    encoder.reset(open.data, sizeof(open.data), kHistoryChannels);
+    LittleFS.mkdir(HISTORY_DIR);
+
+    Dir dir = LittleFS.openDir(HISTORY_DIR);
+    while (dir.next())
+    {
+        String name = dir.fileName();
+        if (name.endsWith(".seg"))
+        {
+            windows.push_back(strtoul(name.c_str(), nullptr, 10));
+        }
+    }
+    std::sort(windows.begin(), windows.end());
+
+    // Only the newest segment can have been cut short by a reset
+    if (!windows.empty())
+    {
+        recover(windows.back());
+    }
+
+    time_t now = time(nullptr);
+    if (now >= kValidEpoch)
+    {
+        enforceRetention(now);
+    }
+}
+
+void HistoryStore::record(const uint16_t voltage_mV[kHistoryPorts], const uint16_t current_mA[kHistoryPorts])
+{
+    time_t now = time(nullptr);
+    if (now < kValidEpoch)
+    {
+        // Without a wall clock the point could not be placed after a reboot
+        historyStats.unsyncedSamples++;
+        return;
+    }
+
+    uint32_t slot = now - now % kHistoryInterval;
+    if (samples > 0 && slot != bucket)
+    {
+        closeBucket();
+    }
+
+    bucket = slot;
+    for (uint8_t i = 0; i < kHistoryPorts; i++)
+    {
+        sums[i] += voltage_mV[i];
+        sums[kHistoryPorts + i] += current_mA[i];
+    }
+    samples++;
+}
+
+void HistoryStore::closeBucket()
+{
+    HistoryPoint point;
+    point.time = bucket;
+    for (uint8_t i = 0; i < kHistoryPorts; i++)
+    {
+        point.voltage_mV[i] = (sums[i] + samples / 2) / samples;
+        point.current_mA[i] = (sums[kHistoryPorts + i] + samples / 2) / samples;
+    }
+    memset(sums, 0, sizeof(sums));
+    samples = 0;
+
+    // A block never spans two segments
+    if (open.count > 0 && windowOf(point.time) != windowOf(open.firstTime))
+    {
+        seal();
+    }
+
+    if (!append(point))
+    {
+        seal();
+        append(point);
+    }
+
+    if (open.count == kHistoryBlockPoints)
+    {
+        seal();
+    }
+}
+
+bool HistoryStore::append(const HistoryPoint &point)
+{
+    uint16_t values[kHistoryChannels];
+    historyToChannels(point, values);
+    if (!encoder.append(point.time, values))
+    {
+        return false;
+    }
+
+    if (open.count == 0)
+    {
+        open.firstTime = point.time;
+    }
+    open.lastTime = point.time;
+    open.count = encoder.count();
+    open.length = encoder.length();
+    return true;
+}
+
+void HistoryStore::seal()
+{
+    if (sealedBlocks == kSealedSize)
+    {
+        sealedHead = (sealedHead + 1) % kSealedSize;
+        sealedBlocks--;
+        historyStats.blocksDropped++;
+    }
+
+    blocks[(sealedHead + sealedBlocks) % kSealedSize] = open;
+    sealedBlocks++;
+    open.count = 0;
+    open.length = 0;
+    encoder.reset(open.data, sizeof(open.data), kHistoryChannels);
+}
+
+void HistoryStore::flush()
+{
+    while (sealedBlocks > 0)
+    {
+        uint32_t start = micros();
+        if (!write(blocks[sealedHead]))
+        {
+            return;
+        }
+        sealedHead = (sealedHead + 1) % kSealedSize;
+        sealedBlocks--;
+
+        historyStats.lastFlushUs = micros() - start;
+        if (historyStats.lastFlushUs > historyStats.maxFlushUs)
+        {
+            historyStats.maxFlushUs = historyStats.lastFlushUs;
+        }
+    }
+}
+
+bool HistoryStore::write(const HistoryBlock &block)
+{
+    uint32_t window = windowOf(block.firstTime);
+
+    enforceRetention(block.lastTime);
+    auto found = std::lower_bound(windows.begin(), windows.end(), window);
+    if (found == windows.end() || *found != window)
+    {
+        windows.insert(found, window);
+    }
+
+    HistoryBlockHeader header;
+    header.firstTime = block.firstTime;
+    header.lastTime = block.lastTime;
+    header.count = block.count;
+    header.length = block.length;
+    header.encoding = HISTORY_SERIES;
+    header.reserved = 0;
+    header.checksum = historyChecksum(block.data, block.length);
+
+    File segment = LittleFS.open(segmentPath(window), "a");
+    if (!segment)
+    {
+        logMessage("History: failed to open " + segmentPath(window), true);
+        return false;
+    }
+
+    HistoryIndexEntry entry;
+    entry.firstTime = header.firstTime;
+    entry.offset = segment.size();
+    bool ok = segment.write((const uint8_t *)&header, sizeof(header)) == sizeof(header) &&
+              segment.write(block.data, block.length) == block.length;
+    segment.close();
+    if (!ok)
+    {
+        logMessage("History: short write", true);
+        recover(window);
+        return false;
+    }
+
+    // The index is only a seek hint, readers fall through unindexed blocks sequentially
+    File index = LittleFS.open(indexPath(window), "a");
+    if (index)
+    {
+        index.write((const uint8_t *)&entry, sizeof(entry));
+        index.close();
+    }
+
+    historyStats.blocksWritten++;
+    historyStats.pointsWritten += block.count;
+    return true;
+}
+
+void HistoryStore::recover(uint32_t window)
+{
+    File segment = LittleFS.open(segmentPath(window), "r+");
+    if (!segment)
+    {
+        return;
+    }
+
+    uint32_t size = segment.size();
+    uint32_t position = 0;
+    HistoryBlockHeader header;
+    while (position + sizeof(header) <= size)
+    {
+        segment.seek(position);
+        if (segment.read((uint8_t *)&header, sizeof(header)) != sizeof(header) ||
+            position + sizeof(header) + header.length > size)
+        {
+            break;
+        }
+        position += sizeof(header) + header.length;
+    }
+
+    if (position != size)
+    {
+        logMessage("History: trimming " + String(size - position) + " bytes from " + segmentPath(window), true);
+        segment.truncate(position);
+    }
+    segment.close();
+
+    File index = LittleFS.open(indexPath(window), "r+");
+    if (!index)
+    {
+        return;
+    }
+    uint32_t entries = index.size() / sizeof(HistoryIndexEntry);
+    HistoryIndexEntry entry;
+    while (entries > 0)
+    {
+        index.seek((entries - 1) * sizeof(entry));
+        if (index.read((uint8_t *)&entry, sizeof(entry)) == sizeof(entry) && entry.offset < position)
+        {
+            break;
+        }
+        entries--;
+    }
+    if (entries * sizeof(entry) != index.size())
+    {
+        index.truncate(entries * sizeof(entry));
+    }
+    index.close();
+}
+
+void HistoryStore::enforceRetention(uint32_t now)
+{
+    while (windows.size() > 1 && windows.front() + (kHistoryRetentionDays + 1) * 86400UL <= now)
+    {
+        dropOldest();
+    }
+
+    FSInfo info;
+    while (windows.size() > 1 && LittleFS.info(info) && info.usedBytes * 100 > info.totalBytes * kHistoryMaxFsPercent)
+    {
+        dropOldest();
+    }
+}
+
+void HistoryStore::dropOldest()
+{
+    uint32_t window = windows.front();
+    logMessage("History: dropping segment " + String(window), true);
+    LittleFS.remove(segmentPath(window));
+    LittleFS.remove(indexPath(window));
+    windows.erase(windows.begin());
+    historyStats.segmentsDropped++;
+}
+
+const std::vector<uint32_t> &HistoryStore::segments() const
+{
+    return windows;
+}
+
+const HistoryStats &HistoryStore::stats() const
+{
+    return historyStats;
+}
+
+uint8_t HistoryStore::sealedCount() const
+{
+    return sealedBlocks;
+}
+
+const HistoryBlock &HistoryStore::sealed(uint8_t index) const
+{
+    return blocks[(sealedHead + index) % kSealedSize];
+}
+
+const HistoryBlock &HistoryStore::current() const
+{
+    return open;
+}
+
+HistoryCursor::HistoryCursor(const HistoryStore &store, uint32_t from, uint32_t to)
+    : store(store), from(from), to(to)
+{
+}
+
+// First time not returned yet
+uint32_t HistoryCursor::resumeTime() const
+{
+    return hasLast ? max(from, lastTime + 1) : from;
+}
+
+bool HistoryCursor::next(HistoryPoint &point)
+{
+    HistoryPoint candidate;
+    for (;;)
+    {
+        if (nextInBlock(candidate))
+        {
+            if (candidate.time < from || (hasLast && candidate.time <= lastTime))
+            {
+                continue;
+            }
+            if (candidate.time > to)
+            {
+                return false;
+            }
+            point = candidate;
+            lastTime = candidate.time;
+            hasLast = true;
+            return true;
+        }
+
+        // Flash first on every block, sealed blocks flushed since the last call are found there
+        if (readBlock())
+        {
+            continue;
+        }
+
+        if (!loadRamBlock())
+        {
+            return false;
+        }
+    }
+}
+
+bool HistoryCursor::nextInBlock(HistoryPoint &point)
+{
+    uint32_t time;
+    uint16_t values[kHistoryChannels];
+    if (!decoder.next(time, values))
+    {
+        return false;
+    }
+    historyFromChannels(time, values, point);
+    return true;
+}
+
+void HistoryCursor::startBlock()
+{
+    decoder.reset(block.data, block.length, kHistoryChannels, block.count);
+}
+
+bool HistoryCursor::openSegment()
+{
+    // By window value, retention may have dropped segments from the front since the last call
+    const std::vector<uint32_t> &windows = store.segments();
+    uint32_t target = inSegment ? window + kHistorySegmentSeconds : windowOf(from);
+    auto found = std::lower_bound(windows.begin(), windows.end(), target);
+    if (found == windows.end() || *found > to)
+    {
+        return false;
+    }
+
+    window = *found;
+    inSegment = true;
+    uint32_t resume = resumeTime();
+    offset = resume > window ? seekIndex(HistoryStore::indexPath(window), resume) : 0;
+    return true;
+}
+
+bool HistoryCursor::readBlock()
+{
+    if (!inSegment && !openSegment())
+    {
+        return false;
+    }
+
+    for (;;)
+    {
+        // Opened for one block only, retention may remove the segment before the next call
+        File file = LittleFS.open(HistoryStore::segmentPath(window), "r");
+        if (file && file.seek(offset))
+        {
+            HistoryBlockHeader header;
+            while (file.read((uint8_t *)&header, sizeof(header)) == sizeof(header))
+            {
+                if (header.encoding != HISTORY_SERIES || header.length > sizeof(block.data))
+                {
+                    // Unknown layout, the rest of this segment cannot be walked
+                    offset = file.size();
+                    break;
+                }
+                offset += sizeof(header) + header.length;
+
+                if (header.lastTime < resumeTime())
+                {
+                    file.seek(header.length, SeekCur);
+                    continue;
+                }
+
+                if (file.read(block.data, header.length) != header.length ||
+                    historyChecksum(block.data, header.length) != header.checksum)
+                {
+                    continue;
+                }
+
+                block.length = header.length;
+                block.count = header.count;
+                startBlock();
+                return true;
+            }
+        }
+
+        // The segment stays current while it is the newest, flush() may still append to it
+        if (!openSegment())
+        {
+            return false;
+        }
+    }
+}
+
+bool HistoryCursor::loadRamBlock()
+{
+    // By time, flush() may have moved sealed blocks to flash since the last call
+    uint32_t resume = resumeTime();
+    for (uint8_t i = 0; i <= store.sealedCount(); i++)
+    {
+        const HistoryBlock &candidate = i < store.sealedCount() ? store.sealed(i) : store.current();
+        if (candidate.count == 0 || candidate.lastTime < resume || (ramLoaded && candidate.lastTime <= ramLast))
+        {
+            continue;
+        }
+        block = candidate;
+        ramLast = candidate.lastTime;
+        ramLoaded = true;
+        startBlock();
+        return true;
+    }
+    return false;
+}
+
+uint32_t HistoryCursor::seekIndex(const String &path, uint32_t time)
+{
+    File index = LittleFS.open(path, "r");
+    if (!index)
+    {
+        return 0;
+    }
+
+    // Last entry whose block starts at or before time
+    uint32_t low = 0;
+    uint32_t high = index.size() / sizeof(HistoryIndexEntry);
+    uint32_t offset = 0;
+    HistoryIndexEntry entry;
+    while (low < high)
+    {
+        uint32_t middle = (low + high) / 2;
+        index.seek(middle * sizeof(entry));
+        if (index.read((uint8_t *)&entry, sizeof(entry)) != sizeof(entry))
+        {
+            break;
+        }
+        if (entry.firstTime <= time)
+        {
+            offset = entry.offset;
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+    index.close();
+    return offset;
+}
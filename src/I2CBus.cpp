@@ -0,0 +1,202 @@
+#include "I2CBus.h"
+
+static const uint32_t kBenchClocks[I2CBus::kBenchSpeeds] = {100000, 400000, 800000};
+
+I2CBus::I2CBus(TwoWire &wire, uint8_t muxAddress, uint8_t sdaPin, uint8_t sclPin)
+    : wire(wire), muxAddress(muxAddress), sdaPin(sdaPin), sclPin(sclPin)
+{
+    clocks[I2C_TARGET_DISPLAY] = kI2CDisplayClock;
+}
+
+void I2CBus::begin()
+{
+    if (isStuck())
+    {
+        // A brown-out or hot-unplug can leave a slave mid-byte
+        recover();
+    }
+
+    wire.begin(sdaPin, sclPin);
+    currentChannel = 0xFF;
+    currentClock = 0;
+}
+
+void I2CBus::setClock(I2CTarget target, uint32_t clock)
+{
+    if (target < I2C_TARGET_COUNT)
+    {
+        clocks[target] = clock;
+    }
+}
+
+uint32_t I2CBus::clockOf(I2CTarget target) const
+{
+    return target < I2C_TARGET_COUNT ? clocks[target] : 0;
+}
+
+void I2CBus::applyClock(uint32_t clock)
+{
+    // The display drivers change the clock around their own transfers, so always apply it
+    wire.setClock(clock);
+    currentClock = clock;
+}
+
+bool I2CBus::select(uint8_t channel, I2CTarget target)
+{
+    if (channel >= kChannels)
+    {
+        return false;
+    }
+
+    applyClock(clockOf(target));
+    if (channel == currentChannel)
+    {
+        return true;
+    }
+
+    wire.beginTransmission(muxAddress);
+    wire.write(1 << channel);
+    uint8_t error = wire.endTransmission();
+    currentChannel = channel;
+    if (!record(error))
+    {
+        // Unknown mux state, write it again next time
+        currentChannel = 0xFF;
+        return false;
+    }
+    return true;
+}
+
+uint8_t I2CBus::channel() const
+{
+    return currentChannel;
+}
+
+bool I2CBus::record(uint8_t error)
+{
+    I2CChannelStats *stats = currentChannel < kChannels ? &channelStats[currentChannel] : nullptr;
+    if (stats)
+    {
+        stats->transactions++;
+    }
+
+    switch (error)
+    {
+    case 0:
+        return true;
+
+    case 2: // NACK on address
+    case 3: // NACK on data
+        if (stats)
+        {
+            stats->naks++;
+        }
+        return false;
+
+    default: // Line busy / timeout
+        if (stats)
+        {
+            stats->timeouts++;
+        }
+        if (isStuck() && recover() && stats)
+        {
+            stats->recoveries++;
+        }
+        return false;
+    }
+}
+
+bool I2CBus::probe(uint8_t address)
+{
+    wire.beginTransmission(address);
+    return record(wire.endTransmission());
+}
+
+bool I2CBus::isStuck() const
+{
+    pinMode(sdaPin, INPUT_PULLUP);
+    pinMode(sclPin, INPUT_PULLUP);
+    return digitalRead(sdaPin) == LOW || digitalRead(sclPin) == LOW;
+}
+
+bool I2CBus::recover()
+{
+    pinMode(sdaPin, INPUT_PULLUP);
+    pinMode(sclPin, OUTPUT_OPEN_DRAIN);
+
+    // Up to 9 clocks let a slave finish the byte it is sending and release SDA
+    for (uint8_t i = 0; i < 9 && digitalRead(sdaPin) == LOW; i++)
+    {
+        digitalWrite(sclPin, LOW);
+        delayMicroseconds(5);
+        digitalWrite(sclPin, HIGH);
+        delayMicroseconds(5);
+    }
+
+    // STOP: SDA rises while SCL is high
+    pinMode(sdaPin, OUTPUT_OPEN_DRAIN);
+    digitalWrite(sdaPin, LOW);
+    delayMicroseconds(5);
+    digitalWrite(sclPin, HIGH);
+    delayMicroseconds(5);
+    digitalWrite(sdaPin, HIGH);
+    delayMicroseconds(5);
+
+    // The bit-banged TWI driver expects both output latches low
+    digitalWrite(sdaPin, LOW);
+    digitalWrite(sclPin, LOW);
+    pinMode(sdaPin, INPUT_PULLUP);
+    pinMode(sclPin, INPUT_PULLUP);
+    bool released = digitalRead(sdaPin) == HIGH && digitalRead(sclPin) == HIGH;
+
+    wire.begin(sdaPin, sclPin);
+    applyClock(currentClock ? currentClock : clocks[I2C_TARGET_CHARGER]);
+    currentChannel = 0xFF;
+    return released;
+}
+
+const I2CChannelStats &I2CBus::stats(uint8_t channel) const
+{
+    return channelStats[channel < kChannels ? channel : 0];
+}
+
+void I2CBus::beginBenchmark()
+{
+    for (uint8_t i = 0; i < kBenchSpeeds; i++)
+    {
+        benchResults[i] = I2CBenchResult();
+        benchResults[i].clock = kBenchClocks[i];
+    }
+}
+
+void I2CBus::benchmarkBatch(uint8_t speed, I2CTarget target, uint8_t address, uint8_t reg, uint16_t count)
+{
+    if (speed >= kBenchSpeeds)
+    {
+        return;
+    }
+
+    I2CBenchResult &result = benchResults[speed];
+    applyClock(kBenchClocks[speed]);
+    uint32_t start = micros();
+    for (uint16_t n = 0; n < count; n++)
+    {
+        result.attempts++;
+        wire.beginTransmission(address);
+        wire.write(reg);
+        if (!record(wire.endTransmission(false)) || wire.requestFrom(address, (uint8_t)1) != 1)
+        {
+            result.failures++;
+            continue;
+        }
+        wire.read();
+    }
+    result.elapsedUs += max(micros() - start, 1UL);
+    result.transactionsPerSecond = (uint64_t)(result.attempts - result.failures) * 1000000UL / result.elapsedUs;
+    applyClock(clockOf(target));
+}
+
+const I2CBenchResult &I2CBus::benchResult(uint8_t index) const
+{
+    return benchResults[index < kBenchSpeeds ? index : 0];
+}
@@ -0,0 +1,80 @@
+#include "I2CQueue.h"
+
+I2CQueue::I2CQueue(I2CBus &bus) : bus(bus)
+{
+}
+
+bool I2CQueue::submit(I2CPriority priority, uint8_t channel, I2CTarget target, I2CJobCallback callback, uint8_t arg)
+{
+    if (priority >= I2C_PRIORITY_COUNT)
+    {
+        return false;
+    }
+
+    Ring &ring = rings[priority];
+    if (ring.count == kCapacity)
+    {
+        queueStats[priority].dropped++;
+        return false;
+    }
+
+    Job &job = ring.jobs[(ring.head + ring.count) % kCapacity];
+    job.callback = callback;
+    job.enqueuedUs = micros();
+    job.channel = channel;
+    job.target = target;
+    job.arg = arg;
+    ring.count++;
+    return true;
+}
+
+void I2CQueue::pump(uint32_t budgetUs)
+{
+    uint32_t start = micros();
+    do
+    {
+        Ring *ring = nullptr;
+        uint8_t priority = 0;
+        for (; priority < I2C_PRIORITY_COUNT; priority++)
+        {
+            if (rings[priority].count > 0)
+            {
+                ring = &rings[priority];
+                break;
+            }
+        }
+
+        if (!ring)
+        {
+            return;
+        }
+
+        Job job = ring->jobs[ring->head];
+        ring->head = (ring->head + 1) % kCapacity;
+        ring->count--;
+
+        uint32_t delay = micros() - job.enqueuedUs;
+        I2CQueueStats &stats = queueStats[priority];
+        stats.jobs++;
+        stats.lastDelayUs = delay;
+        stats.maxDelayUs = max(stats.maxDelayUs, delay);
+        stats.totalDelayUs += delay;
+
+        bool selected = bus.select(job.channel, job.target);
+        if (!selected)
+        {
+            stats.unselected++;
+        }
+        job.callback(job.arg, selected);
+    } while (micros() - start < budgetUs);
+}
+
+uint8_t I2CQueue::pending(I2CPriority priority) const
+{
+    return priority < I2C_PRIORITY_COUNT ? rings[priority].count : 0;
+}
+
+const I2CQueueStats &I2CQueue::stats(I2CPriority priority) const
+{
+    return queueStats[priority < I2C_PRIORITY_COUNT ? priority : 0];
+}
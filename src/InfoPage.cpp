@@ -0,0 +1,94 @@
+#include "InfoPage.h"
+
+void InfoPage::begin()
+{
+    glyphs.begin();
+}
+
+void InfoPage::setHeader(const String &text)
+{
+    headerStrip.setText(glyphs, text + "    "); // Extra spaces for smooth loop
+    headerOffset = 0;
+}
+
+bool InfoPage::hasHeader() const
+{
+    return headerStrip.width() > 0;
+}
+
+void InfoPage::drawHeader(const FrameBuffer &frame, float temperature)
+{
+    if (headerStrip.width() > 0)
+    {
+        headerStrip.blit(frame, 0, 4, 86, headerOffset);
+        headerOffset = (headerOffset + kGlyphWidth) % headerStrip.width();
+    }
+
+    char tempText[12] = " |";
+    dtostrf(temperature, 1, 1, tempText + 2);
+    strcat(tempText, "C");
+    glyphs.draw(frame, 86, 4, tempText);
+
+    // Separator line on row 13
+    uint8_t *row = frame.buffer + (13 / 8) * frame.width;
+    for (int16_t x = 0; x < frame.width; x++)
+    {
+        row[x] |= 1 << (13 & 7);
+    }
+}
+
+void InfoPage::drawPort(const FrameBuffer &frame, uint8_t index, const PortItem &port)
+{
+    int yPos = 18 + (index * 13);
+
+    // Port number (column 0)
+    char portText[3] = {'P', (char)('1' + index), '\0'};
+    glyphs.draw(frame, 0, yPos, portText);
+
+    if (!port.isActive)
+    {
+        // OFF status (column 20)
+        glyphs.draw(frame, 18, yPos, "OFF");
+        return;
+    }
+
+    // Page 1: Voltage, Current, Power
+    if (pageTime < 30)
+    { // Show first page for 30 cycles
+        glyphs.drawValue(frame, 18, yPos, port.voltage, 'V');
+        glyphs.drawValue(frame, 55, yPos, port.current, 'A');
+        glyphs.drawValue(frame, 90, yPos, port.getPower(), 'W');
+    }
+    // Page 2: Protocol and Input voltage
+    else
+    {
+        const String &protocolText = port.protocol;
+
+        // Assuming 7 characters fit in the display
+        if (protocolText.length() > 7)
+        {
+            // Pad and re-render only when the protocol changed, not on every frame
+            if (protocolText != protocolTexts[index])
+            {
+                protocolTexts[index] = protocolText;
+                protocolStrips[index].setText(glyphs, protocolText + "    "); // Extra spaces for smooth loop
+                protocolOffsets[index] = 0;
+            }
+            protocolStrips[index].blit(frame, 18, yPos, 7 * kGlyphWidth, protocolOffsets[index]);
+            protocolOffsets[index] = (protocolOffsets[index] + kGlyphWidth) % protocolStrips[index].width();
+        }
+        else
+        {
+            glyphs.draw(frame, 18, yPos, protocolText.c_str());
+        }
+
+        glyphs.draw(frame, 70, yPos, "Vin");
+        glyphs.drawValue(frame, 94, yPos, port.inputVoltage, 'V');
+    }
+    pageTime++;
+    // Show second page for 10 cycles
+    if (pageTime >= 40)
+    {
+        pageTime = 0;
+    }
+}
@@ -0,0 +1,42 @@
+#include "MonitorJson.h"
+#include <ArduinoJson.h>
+
+// Root members, the ports array and the members of each port. Keys are literals and the
+// protocol is passed as const char *, so ArduinoJson stores no string copies in the pool.
+static constexpr size_t kMonitorJsonSize =
+    JSON_OBJECT_SIZE(6) + JSON_ARRAY_SIZE(kSnapshotPorts) + kSnapshotPorts * JSON_OBJECT_SIZE(9);
+
+void writeMonitorJson(const MonitorSnapshot &snapshot, String &output)
+{
+    StaticJsonDocument<kMonitorJsonSize> doc;
+    JsonArray portsArray = doc.createNestedArray("ports");
+    for (int i = 0; i < kSnapshotPorts; i++)
+    {
+        const PortSnapshot &sample = snapshot.ports[i];
+        JsonObject port = portsArray.createNestedObject();
+        port["voltage"] = sample.voltage;
+        port["current"] = sample.current;
+        port["temperature"] = sample.temperature;
+        port["protocol"] = (const char *)sample.protocol;
+        port["isActive"] = sample.active;
+        port["valid"] = sample.valid;
+        port["health"] = sample.health;
+        port["power"] = sample.power;
+        port["totalPower"] = sample.energy;
+    }
+
+    // Module temperature
+    doc["moduleTemp"] = snapshot.moduleTemperature;
+
+    // Module Input Voltage
+    // Because all port using same input source, so we just need first active port
+    doc["inputVoltage"] = snapshot.inputVoltage;
+
+    // State of module
+    doc["state"] = snapshot.state;
+
+    doc["fanSpeed"] = snapshot.fanSpeed;
+    doc["generation"] = snapshot.generation;
+
+    serializeJson(doc, output);
+}
@@ -0,0 +1,317 @@
+#include "MqttExporter.h"
+#include <ArduinoJson.h>
+#include <ESP8266WiFi.h>
+#include "Config.h"
+
+struct DiscoveryField
+{
+    const char *key;
+    const char *name;
+    const char *unit;
+    const char *deviceClass;
+    const char *stateClass;
+};
+
+static const DiscoveryField kDiscoveryFieldTable[] = {
+    {"voltage", "Voltage", "V", "voltage", "measurement"},
+    {"current", "Current", "A", "current", "measurement"},
+    {"power", "Power", "W", "power", "measurement"},
+    {"energy", "Energy", "Wh", "energy", "total_increasing"},
+    {"protocol", "Protocol", nullptr, nullptr, nullptr},
+};
+
+MqttExporter::MqttExporter()
+{
+}
+
+void MqttExporter::begin(Config *config)
+{
+    this->config = config;
+    deviceId = String(ESP.getChipId());
+    baseTopic = "sw351x/" + deviceId;
+    willTopic = baseTopic + "/status";
+
+    // Callbacks run in the TCP context, they only leave flags for loop()
+    client.onConnect([this](bool sessionPresent)
+                     {
+        needOnline = true;
+        reconnectDelay = 1000;
+        pendingPacketId = 0;
+        exporterStats.connects++; });
+
+    // A PUBACK lost with the connection never comes, stop waiting for it or latency freezes
+    client.onDisconnect([this](AsyncMqttClientDisconnectReason reason)
+                        { pendingPacketId = 0; });
+
+    client.onPublish([this](uint16_t packetId)
+                     {
+        if (packetId != pendingPacketId)
+        {
+            return;
+        }
+        uint32_t latency = micros() - pendingSince;
+        exporterStats.lastLatencyUs = latency;
+        exporterStats.maxLatencyUs = max(exporterStats.maxLatencyUs, latency);
+        pendingPacketId = 0; });
+
+    reconfigure();
+}
+
+void MqttExporter::reconfigure()
+{
+    needReconfigure = true;
+}
+
+void MqttExporter::applySettings()
+{
+    needReconfigure = false;
+    if (client.connected())
+    {
+        client.disconnect();
+    }
+
+    // AsyncMqttClient keeps the pointers, so the strings live in members
+    host = config->mqttHost;
+    user = config->mqttUser;
+    password = config->mqttPassword;
+    client.setServer(host.c_str(), config->mqttPort);
+    client.setClientId(deviceId.c_str());
+    if (user.length() > 0)
+    {
+        client.setCredentials(user.c_str(), password.c_str());
+    }
+    client.setWill(willTopic.c_str(), 1, true, "offline");
+
+    discoveryIndex = 0;
+    discoveryDone = false;
+    pendingPacketId = 0;
+    reconnectDelay = 1000;
+    nextConnectAttempt = millis();
+}
+
+void MqttExporter::record(uint8_t port, bool active, uint16_t voltage_mV, uint16_t current_mA, const String &protocol, float energy)
+{
+    if (!config || !config->mqttEnabled || port >= kPorts)
+    {
+        return;
+    }
+
+    MqttPortState state;
+    state.time = millis();
+    state.port = port;
+    state.active = active;
+    state.voltage_mV = voltage_mV;
+    state.current_mA = current_mA;
+    state.energy = energy;
+    strlcpy(state.protocol, protocol.c_str(), sizeof(state.protocol));
+
+    if (!shouldPublish(state))
+    {
+        return;
+    }
+
+    lastPublished[port] = state;
+    hasPublished[port] = true;
+    push(state);
+}
+
+bool MqttExporter::shouldPublish(const MqttPortState &state) const
+{
+    if (!hasPublished[state.port])
+    {
+        return true;
+    }
+
+    const MqttPortState &last = lastPublished[state.port];
+    return state.active != last.active ||
+           strcmp(state.protocol, last.protocol) != 0 ||
+           abs((int32_t)state.voltage_mV - (int32_t)last.voltage_mV) >= kMqttVoltageThreshold ||
+           abs((int32_t)state.current_mA - (int32_t)last.current_mA) >= kMqttCurrentThreshold ||
+           state.time - last.time >= config->mqttInterval;
+}
+
+void MqttExporter::push(const MqttPortState &state)
+{
+    if (client.connected())
+    {
+        // Fresh states always go out, only the backlog stays thinned
+        queueStride = 1;
+        memset(strideSkipped, 0, sizeof(strideSkipped));
+    }
+    else if (++strideSkipped[state.port] < queueStride)
+    {
+        exporterStats.dropped++;
+        return;
+    }
+    strideSkipped[state.port] = 0;
+
+    if (queueCount == kMqttQueueSize && queueStride < kMqttStrideMax && !client.connected())
+    {
+        thin();
+    }
+    if (queueCount == kMqttQueueSize)
+    {
+        // Keep the newest states, a stale reading is worth less than a fresh one
+        queueHead = (queueHead + 1) % kMqttQueueSize;
+        queueCount--;
+        exporterStats.dropped++;
+    }
+
+    queue[(queueHead + queueCount) % kMqttQueueSize] = state;
+    queueCount++;
+}
+
+// Keep every other state of each port from the oldest on and double the stride
+void MqttExporter::thin()
+{
+    bool keep[kPorts] = {true, true, true, true};
+    uint8_t kept = 0;
+    for (uint8_t i = 0; i < queueCount; i++)
+    {
+        const MqttPortState &state = queue[(queueHead + i) % kMqttQueueSize];
+        if (keep[state.port])
+        {
+            queue[(queueHead + kept) % kMqttQueueSize] = state;
+            kept++;
+        }
+        keep[state.port] = !keep[state.port];
+    }
+    exporterStats.dropped += queueCount - kept;
+    queueCount = kept;
+    queueStride *= 2;
+}
+
+void MqttExporter::loop()
+{
+    if (!config || !config->mqttEnabled || config->mqttHost.length() == 0)
+    {
+        if (client.connected())
+        {
+            client.disconnect();
+        }
+        return;
+    }
+
+    if (needReconfigure)
+    {
+        applySettings();
+    }
+
+    if (!client.connected())
+    {
+        if (WiFi.status() != WL_CONNECTED || (int32_t)(millis() - nextConnectAttempt) < 0)
+        {
+            return;
+        }
+
+        heapBeforeConnect = ESP.getFreeHeap();
+        client.connect();
+        nextConnectAttempt = millis() + reconnectDelay;
+        reconnectDelay = min(reconnectDelay * 2, (uint32_t)60000);
+        return;
+    }
+
+    if (needOnline)
+    {
+        needOnline = false;
+        client.publish(willTopic.c_str(), 1, true, "online");
+        exporterStats.heapCost = (int32_t)heapBeforeConnect - (int32_t)ESP.getFreeHeap();
+    }
+
+    // One discovery config per tick keeps the TCP send buffer from overflowing
+    if (!discoveryDone)
+    {
+        if (publishDiscovery(discoveryIndex) && ++discoveryIndex >= kPorts * kDiscoveryFields)
+        {
+            discoveryDone = true;
+        }
+        return;
+    }
+
+    for (uint8_t i = 0; i < kMqttBatchSize && queueCount > 0; i++)
+    {
+        if (!publishState(queue[queueHead]))
+        {
+            break;
+        }
+        queueHead = (queueHead + 1) % kMqttQueueSize;
+        queueCount--;
+    }
+}
+
+bool MqttExporter::publishDiscovery(uint8_t index)
+{
+    uint8_t port = index / kDiscoveryFields;
+    const DiscoveryField &field = kDiscoveryFieldTable[index % kDiscoveryFields];
+    String objectId = "p" + String(port + 1) + "_" + field.key;
+
+    DynamicJsonDocument doc(640);
+    doc["name"] = "Port " + String(port + 1) + " " + field.name;
+    doc["uniq_id"] = deviceId + "_" + objectId;
+    doc["stat_t"] = baseTopic + "/port" + String(port + 1) + "/state";
+    doc["avty_t"] = willTopic;
+    doc["val_tpl"] = String("{{ value_json.") + field.key + " }}";
+    if (field.unit)
+    {
+        doc["unit_of_meas"] = field.unit;
+        doc["dev_cla"] = field.deviceClass;
+        doc["stat_cla"] = field.stateClass;
+    }
+    JsonObject device = doc.createNestedObject("dev");
+    device["ids"][0] = deviceId;
+    device["name"] = config->getServerName();
+    device["mf"] = "NguyenHungA5";
+    device["mdl"] = "SW3518 Monitor";
+    device["sw"] = FWVersion;
+
+    String payload;
+    serializeJson(doc, payload);
+    String topic = "homeassistant/sensor/" + deviceId + "/" + objectId + "/config";
+    return client.publish(topic.c_str(), 1, true, payload.c_str()) != 0;
+}
+
+bool MqttExporter::publishState(const MqttPortState &state)
+{
+    StaticJsonDocument<256> doc;
+    doc["voltage"] = state.voltage_mV / 1000.0;
+    doc["current"] = state.current_mA / 1000.0;
+    doc["power"] = (state.voltage_mV / 1000.0) * (state.current_mA / 1000.0);
+    doc["energy"] = state.energy;
+    doc["protocol"] = state.protocol;
+    doc["active"] = state.active;
+    doc["age"] = millis() - state.time;
+
+    char payload[256];
+    size_t length = serializeJson(doc, payload, sizeof(payload));
+    String topic = baseTopic + "/port" + String(state.port + 1) + "/state";
+
+    uint32_t start = micros();
+    uint16_t packetId = client.publish(topic.c_str(), 1, false, payload, length);
+    if (packetId == 0)
+    {
+        return false;
+    }
+
+    if (pendingPacketId == 0)
+    {
+        pendingPacketId = packetId;
+        pendingSince = start;
+    }
+    exporterStats.published++;
+    return true;
+}
+
+bool MqttExporter::isConnected()
+{
+    return client.connected();
+}
+
+uint8_t MqttExporter::queued() const
+{
+    return queueCount;
+}
+
+const MqttStats &MqttExporter::stats() const
+{
+    return exporterStats;
+}
@@ -0,0 +1,103 @@
+#include "Parameters.h"
+#include "Thermistor.h"
+
+static const ParameterInfo kParameterInfo[PARAM_COUNT] = {
+    {"sampleInterval", PARAM_TYPE_UINT, 250, 10000, kTimeToReadInformation, "ms"},
+    {"temperatureInterval", PARAM_TYPE_UINT, 100, 60000, kTimeToCheckTemperature, "ms"},
+    {"fanInterval", PARAM_TYPE_UINT, 1000, 600000, kTimeToChangeFan, "ms"},
+    {"maxTemperature", PARAM_TYPE_FLOAT, 20, 120, kMaxTemperature, "C"},
+    {"minTemperature", PARAM_TYPE_FLOAT, 0, 100, kMinTemperature, "C"},
+    {"maxPower", PARAM_TYPE_FLOAT, 5, 500, kMaxPower, "W"},
+    {"minPower", PARAM_TYPE_FLOAT, 0, 400, kMinPower, "W"},
+    {"thermistorRs", PARAM_TYPE_UINT, 1000, 1000000, kThermistorRs, "ohm"},
+    {"thermistorVcc", PARAM_TYPE_FLOAT, 1.5, 5.5, kThermistorVcc, "V"},
+};
+
+Parameters::Parameters()
+{
+    reset();
+}
+
+void Parameters::reset()
+{
+    for (uint8_t i = 0; i < PARAM_COUNT; i++)
+    {
+        values[i] = kParameterInfo[i].defaultValue;
+    }
+}
+
+float Parameters::get(ParameterId id) const
+{
+    return id < PARAM_COUNT ? values[id] : 0;
+}
+
+uint32_t Parameters::getUint(ParameterId id) const
+{
+    return (uint32_t)get(id);
+}
+
+bool Parameters::set(ParameterId id, float value)
+{
+    if (id >= PARAM_COUNT)
+    {
+        return false;
+    }
+
+    const ParameterInfo &parameter = kParameterInfo[id];
+    // Also false for NaN
+    if (!(value >= parameter.minValue && value <= parameter.maxValue))
+    {
+        return false;
+    }
+    if (parameter.type == PARAM_TYPE_UINT && value != (float)(uint32_t)value)
+    {
+        return false;
+    }
+
+    values[id] = value;
+    return true;
+}
+
+const char *Parameters::validate() const
+{
+    // Fan curves divide by these spans
+    if (values[PARAM_MIN_TEMPERATURE] >= values[PARAM_MAX_TEMPERATURE])
+    {
+        return kParameterInfo[PARAM_MIN_TEMPERATURE].name;
+    }
+    if (values[PARAM_MIN_POWER] >= values[PARAM_MAX_POWER])
+    {
+        return kParameterInfo[PARAM_MIN_POWER].name;
+    }
+    return nullptr;
+}
+
+uint32_t Parameters::diff(const Parameters &other) const
+{
+    uint32_t changed = 0;
+    for (uint8_t i = 0; i < PARAM_COUNT; i++)
+    {
+        if (values[i] != other.values[i])
+        {
+            changed |= PARAM_BIT(i);
+        }
+    }
+    return changed;
+}
+
+const ParameterInfo &Parameters::info(ParameterId id)
+{
+    return kParameterInfo[id < PARAM_COUNT ? id : 0];
+}
+
+ParameterId Parameters::find(const char *name)
+{
+    for (uint8_t i = 0; i < PARAM_COUNT; i++)
+    {
+        if (strcmp(kParameterInfo[i].name, name) == 0)
+        {
+            return (ParameterId)i;
+        }
+    }
+    return PARAM_COUNT;
+}
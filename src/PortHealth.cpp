@@ -0,0 +1,90 @@
+#include "PortHealth.h"
+
+bool PortHealth::allow(uint32_t now)
+{
+    if (breakerState != BREAKER_OPEN)
+    {
+        return true;
+    }
+    if ((int32_t)(now - nextProbe) < 0)
+    {
+        healthStats.skipped++;
+        return false;
+    }
+    breakerState = BREAKER_PROBING;
+    return true;
+}
+
+void PortHealth::success()
+{
+    healthStats.samples++;
+    consecutive = 0;
+    backoffMs = kPortBreakerBackoffMin;
+    breakerState = BREAKER_CLOSED;
+    updateScore(100);
+}
+
+void PortHealth::failure(uint8_t error, uint32_t now)
+{
+    healthStats.samples++;
+    healthStats.failures++;
+    healthStats.lastError = error;
+    healthStats.lastFailureAt = now;
+    if (consecutive < UINT8_MAX)
+    {
+        consecutive++;
+    }
+    updateScore(0);
+
+    if (breakerState == BREAKER_PROBING)
+    {
+        // Failed probe, wait longer before the next one
+        backoffMs = min(backoffMs * 2, (uint32_t)kPortBreakerBackoffMax);
+    }
+    else if (breakerState == BREAKER_CLOSED && consecutive >= kPortBreakerThreshold)
+    {
+        healthStats.trips++;
+    }
+    else
+    {
+        return;
+    }
+
+    breakerState = BREAKER_OPEN;
+    nextProbe = now + backoffMs;
+}
+
+void PortHealth::updateScore(uint8_t outcome)
+{
+    // Weight 1/8 per sample, about the last 20 samples matter
+    scoreFixed = scoreFixed - (scoreFixed >> 3) + (((uint16_t)outcome << 8) >> 3);
+}
+
+BreakerState PortHealth::state() const
+{
+    return breakerState;
+}
+
+uint8_t PortHealth::consecutiveFailures() const
+{
+    return consecutive;
+}
+
+uint8_t PortHealth::score() const
+{
+    return (scoreFixed + 128) >> 8;
+}
+
+uint32_t PortHealth::retryIn(uint32_t now) const
+{
+    if (breakerState != BREAKER_OPEN || (int32_t)(now - nextProbe) >= 0)
+    {
+        return 0;
+    }
+    return nextProbe - now;
+}
+
+const PortHealthStats &PortHealth::stats() const
+{
+    return healthStats;
+}
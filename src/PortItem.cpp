@@ -2,6 +2,7 @@
 
 PortItem::PortItem() {
     sw = new SW35xx(Wire);
+    sw->setRetries(kSW35xxRetries);
     sw->begin();
 }
 
@@ -83,10 +84,20 @@ const char *fastChargeType2String(SW35xx::fastChargeType_t type,
     }
 }
 
-void PortItem::update() {
-    sw->readStatus();
+SW35xx::result_t PortItem::update() {
+    SW35xx::result_t result = sw->readStatus();
+    float ntc = temperature;
+    if (result == SW35xx::RESULT_OK) {
+        result = sw->readTemperature(ntc);
+    }
+    valid = result == SW35xx::RESULT_OK;
+    if (!valid) {
+        // samplePort() logs the failure with the port number
+        return result;
+    }
+
     protocol = fastChargeType2String(sw->fastChargeType, sw->PDVersion);
-    temperature = sw->readTemperature();
+    temperature = ntc;
     // Convert temperature from mV to Celsius
     // float tempCelsius = (temperature - 500) / 10.0;
     // Current disable because in the board, NTC pin is connected to GND, so we cannot use it.
@@ -105,4 +116,41 @@ void PortItem::update() {
     inputVoltage = sw->vin_mV / 1000.0;
     voltage = sw->vout_mV / 1000.0;
     current = (sw->iout_usbc_mA + sw->iout_usba_mA) / 1000.0;
-}
\ No newline at end of file
+    return result;
+}
+bool PortItem::sampleAllowed(uint32_t now) {
+    if (!health.allow(now)) {
+        valid = false;
+        return false;
+    }
+    return true;
+}
+
+SampleOutcome PortItem::applySample(bool present, SW35xx::result_t result, uint32_t now, float hours, float &energy) {
+    energy = 0;
+    if (!present) {
+        health.success();
+        isActive = false;
+        valid = true;
+        return SAMPLE_ABSENT;
+    }
+
+    if (result == SW35xx::RESULT_OK) {
+        health.success();
+        isActive = true;
+        float power = getPower();
+        if (power > 0.0) {
+            energy = power * hours;
+        }
+        return SAMPLE_OK;
+    }
+
+    // Invalid sample, no energy is counted and the last good values are kept
+    valid = false;
+    health.failure(result, now);
+    if (health.state() == BREAKER_OPEN && isActive) {
+        isActive = false;
+        return SAMPLE_TRIPPED;
+    }
+    return SAMPLE_FAILED;
+}
@@ -0,0 +1,141 @@
+#include "RegisterCapture.h"
+#include "LittleFS.h"
+#include "log.h"
+
+void RegisterCapture::requestStart(uint32_t sampleIntervalMs)
+{
+    this->sampleIntervalMs = sampleIntervalMs;
+    captureState = CAPTURE_STARTING;
+}
+
+void RegisterCapture::requestStop()
+{
+    if (captureState == CAPTURE_RECORDING)
+    {
+        captureState = CAPTURE_STOPPING;
+    }
+    else if (captureState == CAPTURE_STARTING)
+    {
+        captureState = CAPTURE_IDLE;
+    }
+}
+
+void RegisterCapture::record(uint8_t port, uint8_t result, const uint8_t *raw)
+{
+    if (captureState != CAPTURE_RECORDING)
+    {
+        return;
+    }
+    if (count == kCaptureBufferRecords)
+    {
+        captureStats.dropped++;
+        return;
+    }
+
+    CaptureRecord &record = buffer[count++];
+    record.timeMs = millis() - startMs;
+    record.port = port;
+    record.result = result;
+    if (raw && result == 0)
+    {
+        memcpy(record.registers, raw, kCaptureRegisterCount);
+    }
+    else
+    {
+        memset(record.registers, 0, kCaptureRegisterCount);
+    }
+}
+
+void RegisterCapture::flush()
+{
+    switch (captureState)
+    {
+    case CAPTURE_STARTING:
+        count = 0;
+        captureStats = CaptureStats();
+        captureState = create() ? CAPTURE_RECORDING : CAPTURE_IDLE;
+        break;
+
+    case CAPTURE_RECORDING:
+        append();
+        captureStats.durationMs = millis() - startMs;
+        if (captureStats.bytes + sizeof(buffer) > kCaptureMaxBytes)
+        {
+            logMessage("Register capture reached its size limit", true);
+            captureState = CAPTURE_IDLE;
+        }
+        break;
+
+    case CAPTURE_STOPPING:
+        append();
+        captureStats.durationMs = millis() - startMs;
+        captureState = CAPTURE_IDLE;
+        break;
+
+    default:
+        break;
+    }
+}
+
+bool RegisterCapture::create()
+{
+    File file = LittleFS.open(CAPTURE_FILE, "w");
+    if (!file)
+    {
+        logMessage("Register capture: failed to open " CAPTURE_FILE, true);
+        return false;
+    }
+
+    startMs = millis();
+    CaptureHeader header = {};
+    header.magic = kCaptureMagic;
+    header.version = kCaptureVersion;
+    header.recordSize = sizeof(CaptureRecord);
+    header.portCount = 4;
+    header.chipId = ESP.getChipId();
+    header.sampleIntervalMs = sampleIntervalMs;
+    header.startMs = startMs;
+    size_t size = file.write((const uint8_t *)&header, sizeof(header));
+    file.close();
+    captureStats.bytes = size;
+    return size == sizeof(header);
+}
+
+void RegisterCapture::append()
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    File file = LittleFS.open(CAPTURE_FILE, "a");
+    size_t size = 0;
+    if (file)
+    {
+        size = file.write((const uint8_t *)buffer, sizeof(CaptureRecord) * count);
+        file.close();
+    }
+    if (size != sizeof(CaptureRecord) * count)
+    {
+        // A torn record would misalign everything after it, end the capture here
+        logMessage("Register capture: short write, stopped", true);
+        captureStats.dropped += count;
+        captureState = CAPTURE_IDLE;
+    }
+    else
+    {
+        captureStats.records += count;
+    }
+    captureStats.bytes += size;
+    count = 0;
+}
+
+CaptureState RegisterCapture::state() const
+{
+    return captureState;
+}
+
+const CaptureStats &RegisterCapture::stats() const
+{
+    return captureStats;
+}
@@ -0,0 +1,47 @@
+#include "SceneManager.h"
+
+SceneManager::SceneManager()
+{
+}
+
+void SceneManager::show(Scene scene, unsigned long duration, SceneCallback onDone)
+{
+    this->scene = scene;
+    this->startTime = millis();
+    this->duration = duration;
+    this->onDone = onDone;
+    generation++;
+}
+
+Scene SceneManager::current() const
+{
+    return scene;
+}
+
+bool SceneManager::isHolding() const
+{
+    return duration > 0;
+}
+
+void SceneManager::loop()
+{
+    if (duration == 0 || millis() - startTime < duration)
+    {
+        return;
+    }
+
+    SceneCallback callback = onDone;
+    uint32_t expired = generation;
+    duration = 0;
+    onDone = nullptr;
+    if (callback)
+    {
+        callback();
+    }
+
+    // The callback may have moved on to another scene already
+    if (generation == expired)
+    {
+        scene = Scene::PortInfo;
+    }
+}
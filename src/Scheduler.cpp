@@ -0,0 +1,157 @@
+#include "Scheduler.h"
+
+Scheduler::Scheduler()
+{
+}
+
+int Scheduler::every(const char *name, uint32_t periodMs, TaskCallback callback, uint8_t priority, uint32_t deadlineMs)
+{
+    return add(name, periodMs, 0, callback, priority, deadlineMs ? deadlineMs : periodMs);
+}
+
+int Scheduler::once(const char *name, uint32_t delayMs, TaskCallback callback, uint8_t priority, uint32_t deadlineMs)
+{
+    return add(name, 0, delayMs, callback, priority, deadlineMs);
+}
+
+int Scheduler::add(const char *name, uint32_t periodMs, uint32_t delayMs, TaskCallback callback, uint8_t priority, uint32_t deadlineMs)
+{
+    for (uint8_t i = 0; i < kMaxTasks; i++)
+    {
+        if (tasks[i].active)
+        {
+            continue;
+        }
+
+        Task &task = tasks[i];
+        task = Task();
+        task.name = name;
+        task.callback = callback;
+        task.periodMs = periodMs;
+        task.deadlineMs = deadlineMs;
+        task.priority = priority;
+        task.nextFire = millis() + delayMs;
+        task.active = true;
+        return i;
+    }
+
+    if (rejectedCount++ == 0)
+    {
+        rejectedName = name;
+    }
+    return -1;
+}
+
+void Scheduler::cancel(int id)
+{
+    if (id >= 0 && id < kMaxTasks)
+    {
+        tasks[id].active = false;
+    }
+}
+
+void Scheduler::setPeriod(int id, uint32_t periodMs)
+{
+    if (id < 0 || id >= kMaxTasks || !tasks[id].active || periodMs == 0)
+    {
+        return;
+    }
+
+    Task &task = tasks[id];
+    if (task.deadlineMs == task.periodMs)
+    {
+        task.deadlineMs = periodMs;
+    }
+    task.periodMs = periodMs;
+
+    // A shorter period takes effect now instead of after the rest of the old one
+    uint32_t latest = millis() + periodMs;
+    if ((int32_t)(task.nextFire - latest) > 0)
+    {
+        task.nextFire = latest;
+    }
+}
+
+void Scheduler::loop()
+{
+    uint32_t now = millis();
+    Task *next = nullptr;
+    for (uint8_t i = 0; i < kMaxTasks; i++)
+    {
+        Task &task = tasks[i];
+        if (!task.active || (int32_t)(now - task.nextFire) < 0)
+        {
+            continue;
+        }
+
+        if (!next || task.priority < next->priority ||
+            (task.priority == next->priority && (int32_t)(task.nextFire - next->nextFire) < 0))
+        {
+            next = &task;
+        }
+    }
+
+    if (next)
+    {
+        run(*next, now);
+    }
+}
+
+void Scheduler::run(Task &task, uint32_t now)
+{
+    uint32_t lateness = now - task.nextFire;
+
+    if (task.periodMs > 0)
+    {
+        task.nextFire += task.periodMs;
+        if ((int32_t)(now - task.nextFire) >= 0)
+        {
+            // More than a whole period behind, stay on the grid but drop the missed runs
+            uint32_t missed = (now - task.nextFire) / task.periodMs + 1;
+            task.nextFire += missed * task.periodMs;
+            task.stats.skipped += missed;
+        }
+    }
+
+    uint32_t start = micros();
+    task.callback();
+    uint32_t runUs = micros() - start;
+
+    TaskStats &stats = task.stats;
+    stats.runs++;
+    stats.lastRunUs = runUs;
+    stats.maxRunUs = max(stats.maxRunUs, runUs);
+    stats.totalRunUs += runUs;
+    stats.lastLatenessMs = lateness;
+    stats.maxLatenessMs = max(stats.maxLatenessMs, lateness);
+    if (task.deadlineMs > 0 && lateness + runUs / 1000 > task.deadlineMs)
+    {
+        stats.overruns++;
+    }
+
+    // Freed only now so a one-shot scheduling its successor cannot reuse this slot mid-run
+    if (task.periodMs == 0)
+    {
+        task.active = false;
+    }
+}
+
+uint8_t Scheduler::size() const
+{
+    return kMaxTasks;
+}
+
+uint8_t Scheduler::rejected() const
+{
+    return rejectedCount;
+}
+
+const char *Scheduler::firstRejected() const
+{
+    return rejectedName;
+}
+
+const Task &Scheduler::task(uint8_t id) const
+{
+    return tasks[id];
+}
@@ -0,0 +1,159 @@
+#include "SeriesCodec.h"
+#include <string.h>
+
+static inline uint64_t zigzag(int64_t value)
+{
+    return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+static inline int64_t unzigzag(uint64_t value)
+{
+    return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+static inline uint8_t writeVarint(uint8_t *out, uint64_t value)
+{
+    uint8_t length = 0;
+    while (value >= 0x80)
+    {
+        out[length++] = (uint8_t)value | 0x80;
+        value >>= 7;
+    }
+    out[length++] = (uint8_t)value;
+    return length;
+}
+
+void SeriesEncoder::reset(uint8_t *buffer, size_t capacity, uint8_t channels)
+{
+    this->buffer = buffer;
+    this->capacity = capacity;
+    this->channels = channels > kSeriesMaxChannels ? kSeriesMaxChannels : channels;
+    used = 0;
+    points = 0;
+    lastTime = 0;
+    lastDelta = 0;
+    memset(last, 0, sizeof(last));
+}
+
+bool SeriesEncoder::append(uint32_t time, const uint16_t *values)
+{
+    uint8_t scratch[kSeriesMaxPointBytes];
+    uint8_t length = 0;
+
+    // The first point stores the absolute time, the second its delta, the rest delta-of-deltas
+    int32_t delta = points == 0 ? 0 : (int32_t)(time - lastTime);
+    int64_t stored = points == 0 ? (int64_t)time : (int64_t)delta - lastDelta;
+    length += writeVarint(scratch + length, zigzag(stored));
+
+    uint8_t mask = 0;
+    for (uint8_t i = 0; i < channels; i++)
+    {
+        if (values[i] != last[i])
+        {
+            mask |= 1 << i;
+        }
+    }
+    scratch[length++] = mask;
+    for (uint8_t i = 0; i < channels; i++)
+    {
+        if (mask & (1 << i))
+        {
+            length += writeVarint(scratch + length, zigzag((int32_t)values[i] - (int32_t)last[i]));
+        }
+    }
+
+    if (used + length > capacity)
+    {
+        return false;
+    }
+
+    memcpy(buffer + used, scratch, length);
+    used += length;
+    points++;
+    lastDelta = delta;
+    lastTime = time;
+    memcpy(last, values, sizeof(uint16_t) * channels);
+    return true;
+}
+
+void SeriesDecoder::reset(const uint8_t *data, size_t length, uint8_t channels, uint16_t count)
+{
+    this->data = data;
+    this->length = length;
+    this->channels = channels > kSeriesMaxChannels ? kSeriesMaxChannels : channels;
+    points = count;
+    position = 0;
+    first = true;
+    lastTime = 0;
+    lastDelta = 0;
+    memset(last, 0, sizeof(last));
+}
+
+bool SeriesDecoder::readVarint(uint64_t &value)
+{
+    value = 0;
+    for (uint8_t shift = 0; shift < 64; shift += 7)
+    {
+        if (position >= length)
+        {
+            return false;
+        }
+        uint8_t byte = data[position++];
+        value |= (uint64_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool SeriesDecoder::next(uint32_t &time, uint16_t *values)
+{
+    if (points == 0)
+    {
+        return false;
+    }
+
+    uint64_t raw;
+    if (!readVarint(raw))
+    {
+        points = 0;
+        return false;
+    }
+
+    if (first)
+    {
+        lastTime = (uint32_t)unzigzag(raw);
+        first = false;
+    }
+    else
+    {
+        lastDelta += (int32_t)unzigzag(raw);
+        lastTime += lastDelta;
+    }
+
+    if (position >= length)
+    {
+        points = 0;
+        return false;
+    }
+    uint8_t mask = data[position++];
+    for (uint8_t i = 0; i < channels; i++)
+    {
+        if (mask & (1 << i))
+        {
+            if (!readVarint(raw))
+            {
+                points = 0;
+                return false;
+            }
+            last[i] += (uint16_t)unzigzag(raw);
+        }
+    }
+
+    time = lastTime;
+    memcpy(values, last, sizeof(uint16_t) * channels);
+    points--;
+    return true;
+}
@@ -0,0 +1,238 @@
+#include "SessionTracker.h"
+#include <LittleFS.h>
+#include <time.h>
+#include "log.h"
+
+void SessionTracker::begin()
+{
+    // A reset in the middle of an append leaves a partial record, cut it so appends stay aligned
+    File file = LittleFS.open(SESSION_LOG_FILE, "r+");
+    if (file)
+    {
+        if (file.size() % sizeof(SessionRecord) != 0)
+        {
+            logMessage("Session log: dropping a partial record", true);
+            file.truncate(file.size() - file.size() % sizeof(SessionRecord));
+        }
+        file.close();
+    }
+
+    currentRecords = recordsIn(SESSION_LOG_FILE);
+    previousRecords = recordsIn(SESSION_LOG_OLD_FILE);
+
+    SessionRecord last;
+    if (read(0, last))
+    {
+        nextId = last.id + 1;
+    }
+}
+
+void SessionTracker::update(uint8_t port, bool present, float voltage, float current, uint8_t protocol, uint8_t pdVersion)
+{
+    if (port >= kPorts)
+    {
+        return;
+    }
+
+    uint32_t now = millis();
+    ActiveSession &session = sessions[port];
+    if (!present)
+    {
+        if (session.open)
+        {
+            close(port, SESSION_END_UNPLUGGED, now);
+        }
+        return;
+    }
+
+    bool charging = current >= kSessionStartCurrent;
+    if (!session.open)
+    {
+        if (!charging)
+        {
+            return;
+        }
+        session = ActiveSession();
+        session.open = true;
+        session.startMs = now;
+        time_t wallClock = time(nullptr);
+        session.startTime = wallClock >= kValidEpoch ? wallClock : 0;
+    }
+    else
+    {
+        float power = voltage * current;
+        session.energy += power * (now - session.lastSampleMs) / 3600000.0;
+    }
+    session.lastSampleMs = now;
+
+    if (!charging)
+    {
+        if (now - session.lastChargingMs >= kSessionEndDelay)
+        {
+            // The session ended when the current dropped, not when the delay ran out
+            close(port, SESSION_END_IDLE, session.lastChargingMs);
+        }
+        return;
+    }
+
+    session.lastChargingMs = now;
+    float power = voltage * current;
+    if (power > session.peakPower)
+    {
+        session.peakPower = power;
+    }
+    uint16_t current_mA = current * 1000;
+    if (current_mA > session.peakCurrent_mA)
+    {
+        session.peakCurrent_mA = current_mA;
+    }
+    if (protocol < 16)
+    {
+        session.protocols |= 1 << protocol;
+    }
+    if (pdVersion == 2 || pdVersion == 3)
+    {
+        session.pdVersions |= 1 << pdVersion;
+    }
+}
+
+void SessionTracker::closeAll(SessionEndReason reason)
+{
+    uint32_t now = millis();
+    for (uint8_t i = 0; i < kPorts; i++)
+    {
+        if (sessions[i].open)
+        {
+            close(i, reason, now);
+        }
+    }
+}
+
+void SessionTracker::close(uint8_t port, SessionEndReason reason, uint32_t endMs)
+{
+    ActiveSession &session = sessions[port];
+    session.open = false;
+
+    uint32_t durationMs = endMs - session.startMs;
+    if (durationMs < kSessionMinDuration)
+    {
+        return;
+    }
+
+    if (pendingCount == kPendingSize)
+    {
+        // Flash has been failing for a while, keep the newest sessions
+        logMessage("Session log: pending queue full, dropping session " + String(pending[0].id), true);
+        memmove(pending, pending + 1, sizeof(SessionRecord) * (kPendingSize - 1));
+        pendingCount--;
+    }
+
+    SessionRecord &record = pending[pendingCount++];
+    memset(&record, 0, sizeof(record));
+    record.id = nextId++;
+    record.startTime = session.startTime;
+    record.startUptime = session.startMs / 1000;
+    record.duration = (durationMs + 500) / 1000;
+    record.energy = session.energy;
+    record.peakPower = min(session.peakPower * 100, 65535.0f);
+    record.averagePower = min(session.energy * 3600000.0f / durationMs * 100, 65535.0f);
+    record.peakCurrent_mA = session.peakCurrent_mA;
+    record.protocols = session.protocols;
+    record.port = port;
+    record.reason = reason;
+    record.pdVersions = session.pdVersions;
+}
+
+void SessionTracker::flush()
+{
+    uint8_t written = 0;
+    while (written < pendingCount)
+    {
+        if (currentRecords >= kSessionLogRecords)
+        {
+            LittleFS.remove(SESSION_LOG_OLD_FILE);
+            LittleFS.rename(SESSION_LOG_FILE, SESSION_LOG_OLD_FILE);
+            previousRecords = currentRecords;
+            currentRecords = 0;
+        }
+
+        File file = LittleFS.open(SESSION_LOG_FILE, "a");
+        if (!file)
+        {
+            logMessage("Session log: failed to open " SESSION_LOG_FILE, true);
+            break;
+        }
+        size_t size = file.write((const uint8_t *)&pending[written], sizeof(SessionRecord));
+        file.close();
+        if (size != sizeof(SessionRecord))
+        {
+            logMessage("Session log: short write", true);
+            break;
+        }
+        currentRecords++;
+        written++;
+    }
+
+    if (written > 0)
+    {
+        memmove(pending, pending + written, sizeof(SessionRecord) * (pendingCount - written));
+        pendingCount -= written;
+    }
+}
+
+const ActiveSession &SessionTracker::active(uint8_t port) const
+{
+    return sessions[port < kPorts ? port : 0];
+}
+
+uint32_t SessionTracker::count() const
+{
+    return pendingCount + currentRecords + previousRecords;
+}
+
+bool SessionTracker::read(uint32_t index, SessionRecord &record)
+{
+    if (index < pendingCount)
+    {
+        record = pending[pendingCount - 1 - index];
+        return true;
+    }
+    index -= pendingCount;
+
+    if (index < currentRecords)
+    {
+        return readFrom(SESSION_LOG_FILE, currentRecords - 1 - index, record);
+    }
+    index -= currentRecords;
+
+    if (index < previousRecords)
+    {
+        return readFrom(SESSION_LOG_OLD_FILE, previousRecords - 1 - index, record);
+    }
+    return false;
+}
+
+bool SessionTracker::readFrom(const char *path, uint32_t position, SessionRecord &record)
+{
+    File file = LittleFS.open(path, "r");
+    if (!file)
+    {
+        return false;
+    }
+    bool ok = file.seek(position * sizeof(SessionRecord)) &&
+              file.read((uint8_t *)&record, sizeof(SessionRecord)) == sizeof(SessionRecord);
+    file.close();
+    return ok;
+}
+
+uint32_t SessionTracker::recordsIn(const char *path)
+{
+    File file = LittleFS.open(path, "r");
+    if (!file)
+    {
+        return 0;
+    }
+    uint32_t records = file.size() / sizeof(SessionRecord);
+    file.close();
+    return records;
+}
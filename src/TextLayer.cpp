@@ -0,0 +1,144 @@
+#include "TextLayer.h"
+#include <Adafruit_GFX.h>
+
+namespace {
+
+// Adafruit_GFX target that writes one glyph into column bytes
+class GlyphCanvas : public Adafruit_GFX
+{
+public:
+    GlyphCanvas() : Adafruit_GFX(kGlyphWidth, 8) {}
+
+    uint8_t *target = nullptr;
+
+    void drawPixel(int16_t x, int16_t y, uint16_t color) override
+    {
+        if (x < 0 || x >= kGlyphWidth || y < 0 || y >= 8)
+        {
+            return;
+        }
+
+        if (color)
+        {
+            target[x] |= (1 << y);
+        }
+        else
+        {
+            target[x] &= ~(1 << y);
+        }
+    }
+};
+
+} // namespace
+
+void FrameBuffer::blitColumns(int16_t x, int16_t y, const uint8_t *columns, uint16_t count) const
+{
+    if (y <= -8 || y >= height)
+    {
+        return;
+    }
+
+    int16_t page = y >> 3;
+    uint8_t shift = y & 7;
+    int16_t pages = height / 8;
+    for (uint16_t i = 0; i < count; i++)
+    {
+        int16_t column = x + i;
+        if (column < 0)
+        {
+            continue;
+        }
+        if (column >= width)
+        {
+            break;
+        }
+
+        uint8_t value = columns[i];
+        if (page >= 0)
+        {
+            uint8_t &low = buffer[column + page * width];
+            low = (low & ~(0xFF << shift)) | (value << shift);
+        }
+        if (shift > 0 && page + 1 < pages)
+        {
+            uint8_t &high = buffer[column + (page + 1) * width];
+            high = (high & ~(0xFF >> (8 - shift))) | (value >> (8 - shift));
+        }
+    }
+}
+
+void GlyphAtlas::begin()
+{
+    GlyphCanvas canvas;
+    for (char c = kGlyphFirst; c <= kGlyphLast; c++)
+    {
+        canvas.target = &columns[(c - kGlyphFirst) * kGlyphWidth];
+        canvas.drawChar(0, 0, c, 1, 0, 1);
+    }
+}
+
+const uint8_t *GlyphAtlas::glyph(char c) const
+{
+    if (c < kGlyphFirst || c > kGlyphLast)
+    {
+        c = '?';
+    }
+    return &columns[(c - kGlyphFirst) * kGlyphWidth];
+}
+
+void GlyphAtlas::draw(const FrameBuffer &frame, int16_t x, int16_t y, const char *text) const
+{
+    for (; *text; text++, x += kGlyphWidth)
+    {
+        frame.blitColumns(x, y, glyph(*text), kGlyphWidth);
+    }
+}
+
+void GlyphAtlas::drawValue(const FrameBuffer &frame, int16_t x, int16_t y, float value, char unit) const
+{
+    char text[12];
+    dtostrf(value, 1, 1, text);
+    size_t length = strlen(text);
+    text[length] = unit;
+    text[length + 1] = '\0';
+    draw(frame, x, y, text);
+}
+
+bool TextStrip::setText(const GlyphAtlas &atlas, const String &text)
+{
+    if (text == this->text && !columns.empty())
+    {
+        return false;
+    }
+
+    this->text = text;
+    columns.resize(text.length() * kGlyphWidth);
+    for (size_t i = 0; i < text.length(); i++)
+    {
+        memcpy(&columns[i * kGlyphWidth], atlas.glyph(text[i]), kGlyphWidth);
+    }
+    return true;
+}
+
+void TextStrip::blit(const FrameBuffer &frame, int16_t x, int16_t y, uint16_t width, uint16_t offset) const
+{
+    if (columns.empty())
+    {
+        return;
+    }
+
+    offset %= columns.size();
+    while (width > 0)
+    {
+        uint16_t count = min((size_t)width, columns.size() - offset);
+        frame.blitColumns(x, y, &columns[offset], count);
+        x += count;
+        width -= count;
+        offset = 0;
+    }
+}
+
+uint16_t TextStrip::width() const
+{
+    return columns.size();
+}
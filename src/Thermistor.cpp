@@ -0,0 +1,134 @@
+#include "Thermistor.h"
+
+static constexpr ThermistorTable kThermistorTable PROGMEM = makeThermistorTable();
+
+constexpr int TEMPERATURE_SENSOR_PIN = A0; // The ESP8266 pin ADC0
+
+Thermistor::Thermistor()
+{
+}
+
+void Thermistor::sample()
+{
+    uint32_t sum = 0;
+    for (int i = 0; i < kTemperatureOversample; i++)
+    {
+        sum += analogRead(TEMPERATURE_SENSOR_PIN);
+    }
+
+    window[windowHead] = (sum << kThermistorFracBits) / kTemperatureOversample;
+    windowHead = (windowHead + 1) % kMedianSize;
+    if (windowCount < kMedianSize)
+    {
+        windowCount++;
+    }
+
+    uint16_t value = median();
+    if (!hasValue)
+    {
+        filtered = value;
+        hasValue = true;
+    }
+    else
+    {
+        // EMA with alpha = 1/4
+        filtered = filtered + ((int32_t)value - (int32_t)filtered) / 4;
+    }
+}
+
+uint16_t Thermistor::median() const
+{
+    uint16_t sorted[kMedianSize];
+    for (uint8_t i = 0; i < windowCount; i++)
+    {
+        uint16_t value = window[i];
+        int j = i - 1;
+        while (j >= 0 && sorted[j] > value)
+        {
+            sorted[j + 1] = sorted[j];
+            j--;
+        }
+        sorted[j + 1] = value;
+    }
+
+    return sorted[windowCount / 2];
+}
+
+float Thermistor::temperature() const
+{
+    return celsiusOf(filtered);
+}
+
+float Thermistor::celsiusOf(uint32_t adcFixed) const
+{
+    return interpolate(adcFixed, custom.get());
+}
+
+void Thermistor::setCircuit(uint32_t rs, float vcc)
+{
+    if (rs == kThermistorRs && vcc == (float)kThermistorVcc)
+    {
+        custom.reset();
+        return;
+    }
+
+    if (!custom)
+    {
+        custom.reset(new ThermistorTable);
+    }
+    // Same curve as thermistor_detail::centiCelsius(), with the libm log instead of the constexpr one
+    for (int i = 0; i < kThermistorTableSize; i++)
+    {
+        int adc = i <= kThermistorFineLimit ? i : kThermistorFineLimit + (i - kThermistorFineLimit) * kThermistorCoarseStep;
+        double vNtc = (adc < 1 ? 1 : adc) / 1024.0;
+        double rNtc = log((rs * vNtc) / (vcc - vNtc));
+        double value = (1 / (kSteinhartA + (kSteinhartB + (kSteinhartC * rNtc * rNtc)) * rNtc) - 273.15) * 100;
+        custom->centiCelsius[i] = thermistor_detail::roundCenti(value);
+    }
+}
+
+float Thermistor::toCelsius(uint32_t adcFixed)
+{
+    return interpolate(adcFixed, nullptr);
+}
+
+float Thermistor::interpolate(uint32_t adcFixed, const ThermistorTable *ram)
+{
+    constexpr uint32_t fineLimit = (uint32_t)kThermistorFineLimit << kThermistorFracBits;
+    constexpr uint32_t maxValue = (uint32_t)1024 << kThermistorFracBits;
+    if (adcFixed >= maxValue)
+    {
+        adcFixed = maxValue - 1;
+    }
+
+    uint32_t index;
+    uint32_t frac;
+    uint32_t span;
+    if (adcFixed < fineLimit)
+    {
+        index = adcFixed >> kThermistorFracBits;
+        frac = adcFixed & ((1 << kThermistorFracBits) - 1);
+        span = 1 << kThermistorFracBits;
+    }
+    else
+    {
+        uint32_t offset = adcFixed - fineLimit;
+        index = kThermistorFineLimit + (offset >> (kThermistorFracBits + kThermistorCoarseShift));
+        frac = offset & ((1 << (kThermistorFracBits + kThermistorCoarseShift)) - 1);
+        span = 1 << (kThermistorFracBits + kThermistorCoarseShift);
+    }
+
+    int32_t a;
+    int32_t b;
+    if (ram)
+    {
+        a = ram->centiCelsius[index];
+        b = ram->centiCelsius[index + 1];
+    }
+    else
+    {
+        a = (int16_t)pgm_read_word(&kThermistorTable.centiCelsius[index]);
+        b = (int16_t)pgm_read_word(&kThermistorTable.centiCelsius[index + 1]);
+    }
+    return (a + ((b - a) * (int32_t)frac) / (int32_t)span) / 100.0f;
+}
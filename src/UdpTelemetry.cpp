@@ -0,0 +1,146 @@
+#include "UdpTelemetry.h"
+#include <ESP8266WiFi.h>
+#include "Config.h"
+
+UdpTelemetry::UdpTelemetry()
+{
+}
+
+void UdpTelemetry::begin(Config *config)
+{
+    this->config = config;
+}
+
+bool UdpTelemetry::isEnabled() const
+{
+    return config && config->udpEnabled;
+}
+
+bool UdpTelemetry::send(TelemetryPacket &packet)
+{
+    packet.magic = kTelemetryMagic;
+    packet.version = kTelemetryVersion;
+    packet.portCount = kTelemetryPorts;
+    packet.size = sizeof(TelemetryPacket);
+    packet.chipId = ESP.getChipId();
+    packet.sequence = nextSequence++;
+    packet.uptimeMs = millis();
+
+    if (!isEnabled())
+    {
+        return false;
+    }
+
+    bool online = WiFi.status() == WL_CONNECTED;
+    if (online)
+    {
+        // Fresh packets always go out, only the backlog stays thinned
+        queueStride = 1;
+        strideSkipped = 0;
+    }
+    push(packet);
+    if (!online)
+    {
+        return false;
+    }
+
+    for (uint8_t i = 0; i < kUdpBatchSize && queueCount > 0; i++)
+    {
+        // A datagram the stack refuses is counted and dropped, retrying it would stall the queue
+        transmit(queue[queueHead]);
+        queueHead = (queueHead + 1) % kUdpQueueSize;
+        queueCount--;
+    }
+    return queueCount == 0;
+}
+
+void UdpTelemetry::push(const TelemetryPacket &packet)
+{
+    if (++strideSkipped < queueStride)
+    {
+        droppedCount++;
+        return;
+    }
+    strideSkipped = 0;
+
+    if (queueCount == kUdpQueueSize && queueStride < kUdpStrideMax)
+    {
+        thin();
+    }
+    else if (queueCount == kUdpQueueSize)
+    {
+        // Past the longest stride keep the newest packets, like the MQTT queue
+        queueHead = (queueHead + 1) % kUdpQueueSize;
+        queueCount--;
+        droppedCount++;
+    }
+
+    queue[(queueHead + queueCount) % kUdpQueueSize] = packet;
+    queueCount++;
+}
+
+// Keep every other packet from the oldest on and double the stride, so the spacing stays even
+void UdpTelemetry::thin()
+{
+    uint8_t kept = 0;
+    for (uint8_t i = 0; i < queueCount; i += 2)
+    {
+        queue[(queueHead + kept) % kUdpQueueSize] = queue[(queueHead + i) % kUdpQueueSize];
+        kept++;
+    }
+    droppedCount += queueCount - kept;
+    queueCount = kept;
+    queueStride *= 2;
+}
+
+bool UdpTelemetry::transmit(const TelemetryPacket &packet)
+{
+    IPAddress address;
+    int result;
+    if (config->udpAddress.length() == 0 || !address.fromString(config->udpAddress))
+    {
+        result = udp.beginPacket(WiFi.broadcastIP(), kTelemetryPort);
+    }
+    else if (address[0] >= 224 && address[0] <= 239)
+    {
+        result = udp.beginPacketMulticast(address, kTelemetryPort, WiFi.localIP());
+    }
+    else
+    {
+        result = udp.beginPacket(address, kTelemetryPort);
+    }
+
+    if (result && udp.write((const uint8_t *)&packet, sizeof(packet)) == sizeof(packet) && udp.endPacket())
+    {
+        sentCount++;
+        return true;
+    }
+
+    failedCount++;
+    return false;
+}
+
+uint32_t UdpTelemetry::sequence() const
+{
+    return nextSequence;
+}
+
+uint32_t UdpTelemetry::sent() const
+{
+    return sentCount;
+}
+
+uint32_t UdpTelemetry::failed() const
+{
+    return failedCount;
+}
+
+uint8_t UdpTelemetry::queued() const
+{
+    return queueCount;
+}
+
+uint32_t UdpTelemetry::dropped() const
+{
+    return droppedCount;
+}
@@ -0,0 +1,277 @@
+#include "UploadSink.h"
+#include "log.h"
+
+static uint32_t crc32Update(uint32_t crc, const uint8_t *data, size_t len)
+{
+    // Nibble table keeps the CRC fast without a 1 KB table in RAM
+    static const uint32_t table[16] PROGMEM = {
+        0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+        0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C};
+
+    crc = ~crc;
+    for (size_t i = 0; i < len; i++)
+    {
+        crc ^= data[i];
+        crc = pgm_read_dword(&table[crc & 0x0F]) ^ (crc >> 4);
+        crc = pgm_read_dword(&table[crc & 0x0F]) ^ (crc >> 4);
+    }
+    return ~crc;
+}
+
+UploadSink::UploadSink()
+{
+}
+
+UploadSink::~UploadSink()
+{
+    abort();
+}
+
+bool UploadSink::begin(const String &target, const String &crc32, const String &md5)
+{
+    abort();
+
+    targetPath = target.startsWith("/") ? target : "/" + target;
+    tempPath = targetPath + ".tmp";
+    expectedCrc32 = crc32;
+    expectedMd5 = md5;
+    expectedMd5.toLowerCase();
+    lastError = "";
+    crc = 0;
+    totalSize = 0;
+    buffered = 0;
+    success = false;
+    startTime = millis();
+    this->md5.begin();
+
+    file = LittleFS.open(tempPath, "w");
+    if (!file)
+    {
+        fail("Failed to open file for writing");
+        return false;
+    }
+
+    return true;
+}
+
+bool UploadSink::write(const uint8_t *data, size_t len)
+{
+    if (!file)
+    {
+        return false;
+    }
+
+    crc = crc32Update(crc, data, len);
+    md5.add(data, len);
+    totalSize += len;
+
+    // Top up a partially filled page first
+    if (buffered > 0)
+    {
+        size_t length = min(len, kUploadPageSize - buffered);
+        memcpy(buffer + buffered, data, length);
+        buffered += length;
+        data += length;
+        len -= length;
+        if (buffered == kUploadPageSize && !flushBuffer())
+        {
+            return false;
+        }
+    }
+
+    // Whole pages go straight to flash, only the tail is kept back
+    size_t direct = len - (len % kUploadPageSize);
+    if (direct > 0 && !writeFile(data, direct))
+    {
+        return false;
+    }
+
+    memcpy(buffer + buffered, data + direct, len - direct);
+    buffered += len - direct;
+    return true;
+}
+
+bool UploadSink::finish()
+{
+    if (!file)
+    {
+        return false;
+    }
+
+    if (!flushBuffer())
+    {
+        return false;
+    }
+    file.close();
+
+    if (expectedCrc32.length() > 0 && strtoul(expectedCrc32.c_str(), nullptr, 16) != crc)
+    {
+        fail("CRC32 mismatch");
+        return false;
+    }
+
+    md5.calculate();
+    if (expectedMd5.length() > 0 && md5.toString() != expectedMd5)
+    {
+        fail("MD5 mismatch");
+        return false;
+    }
+
+    if (!LittleFS.rename(tempPath, targetPath))
+    {
+        // Older LittleFS wrappers refuse to rename over an existing file
+        LittleFS.remove(targetPath);
+        if (!LittleFS.rename(tempPath, targetPath))
+        {
+            fail("Failed to replace " + targetPath);
+            return false;
+        }
+    }
+
+    unsigned long elapsed = max(millis() - startTime, 1UL);
+    logMessage("Uploaded " + targetPath + ": " + String(totalSize) + " bytes in " + String(elapsed) + "ms (" + String(totalSize / elapsed) + " KB/s)", true);
+    success = true;
+    return true;
+}
+
+void UploadSink::abort()
+{
+    if (file)
+    {
+        file.close();
+        LittleFS.remove(tempPath);
+    }
+    buffered = 0;
+}
+
+void UploadSink::handleChunk(AsyncWebServerRequest *request, const String &target, size_t index, uint8_t *data, size_t len, bool final)
+{
+    if (index == 0)
+    {
+        if (owner && owner != request)
+        {
+            // Marks the request for a 409, the server frees _tempObject with the request
+            if (!request->_tempObject)
+            {
+                request->_tempObject = malloc(1);
+            }
+            logMessage("Upload of " + target + " refused, " + targetPath + " is still in progress", true);
+            return;
+        }
+
+        owner = request;
+        request->onDisconnect([this, request]()
+                              {
+                                  // The client went away before its answer, free the sink for the next one
+                                  if (owner == request)
+                                  {
+                                      abort();
+                                      owner = nullptr;
+                                  } });
+        logMessage("Starting upload: " + target);
+        if (!begin(target, request->arg("crc32"), request->arg("md5")))
+        {
+            return;
+        }
+    }
+
+    if (request != owner)
+    {
+        return;
+    }
+
+    if (len > 0)
+    {
+        write(data, len);
+    }
+
+    if (final)
+    {
+        finish();
+    }
+}
+
+void UploadSink::sendResult(AsyncWebServerRequest *request, const String &message)
+{
+    if (request != owner)
+    {
+        if (request->_tempObject)
+        {
+            request->send(409, "text/plain", "Another upload is in progress");
+        }
+        else
+        {
+            request->send(400, "text/plain", "No file in request");
+        }
+        return;
+    }
+
+    owner = nullptr;
+    if (success)
+    {
+        request->send(200, "text/plain", message);
+    }
+    else
+    {
+        request->send(lastError.endsWith("mismatch") ? 400 : 500, "text/plain", lastError.length() > 0 ? lastError : "Upload incomplete");
+    }
+}
+
+bool UploadSink::isOpen() const
+{
+    return file;
+}
+
+bool UploadSink::succeeded() const
+{
+    return success;
+}
+
+const String &UploadSink::error() const
+{
+    return lastError;
+}
+
+const String &UploadSink::target() const
+{
+    return targetPath;
+}
+
+size_t UploadSink::size() const
+{
+    return totalSize;
+}
+
+bool UploadSink::flushBuffer()
+{
+    if (buffered == 0)
+    {
+        return true;
+    }
+
+    bool result = writeFile(buffer, buffered);
+    buffered = 0;
+    return result;
+}
+
+bool UploadSink::writeFile(const uint8_t *data, size_t len)
+{
+    if (file.write(data, len) != len)
+    {
+        fail("Write failed, file system full?");
+        return false;
+    }
+    return true;
+}
+
+void UploadSink::fail(const String &message)
+{
+    lastError = message;
+    logMessage("Upload failed: " + message, true);
+    if (file)
+    {
+        file.close();
+    }
+    LittleFS.remove(tempPath);
+    success = false;
+}
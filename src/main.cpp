@@ -18,13 +18,31 @@
 #include "PortItem.h"
 #include "Config.h"
 #include "Emoticons.hpp"
+#include "Thermistor.h"
+#include "UploadSink.h"
+#include "SceneManager.h"
+#include "Scheduler.h"
+#include "InfoPage.h"
+#include "I2CBus.h"
+#include "I2CQueue.h"
+#include "MqttExporter.h"
+#include "UdpTelemetry.h"
+#include "SessionTracker.h"
+#include "HistoryStore.h"
+#include "HistoryQuery.h"
+#include "PortSnapshot.h"
+#include "MonitorJson.h"
+#include "BootSequencer.h"
+#include "Connectivity.h"
+#include "DeviceBench.h"
+#include "Parameters.h"
+#include "RegisterCapture.h"
 
 constexpr int SCREEN_WIDTH = 128; // OLED display width, in pixels
 constexpr int SCREEN_HEIGHT = 64; // OLED display height, in pixels
 
 constexpr int TCAADDR = 0x70;
 
-constexpr int TEMPERATURE_SENSOR_PIN = A0; // The ESP8266 pin ADC0
 constexpr int SCREEN_ADDRESS = 0x3C;
 
 #ifdef OLED_SSD1306
@@ -32,13 +50,13 @@ constexpr int SCREEN_ADDRESS = 0x3C;
 #define OLED_RESET -1 // Reset pin # (or -1 if sharing Arduino reset pin)
 #define PX_COLOR_WHITE SSD1306_WHITE
 #define PX_COLOR_BLACK SSD1306_BLACK
-Adafruit_SSD1306 display(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire, OLED_RESET);
+Adafruit_SSD1306 display(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire, OLED_RESET, kI2CDisplayClock, kI2CChargerClock);
 #else
 #include <Adafruit_SH110x.h>
 constexpr int OLED_RESET = LED_BUILTIN; // 4
 #define PX_COLOR_WHITE SH110X_WHITE
 #define PX_COLOR_BLACK SH110X_BLACK
-Adafruit_SH1106G display = Adafruit_SH1106G(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire, OLED_RESET);
+Adafruit_SH1106G display = Adafruit_SH1106G(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire, OLED_RESET, kI2CDisplayClock, kI2CChargerClock);
 #endif
 
 std::unique_ptr<AsyncWebServer> server = nullptr;
@@ -56,6 +74,14 @@ std::unique_ptr<Emoticons> emoticons = nullptr;
 
 // Config
 std::unique_ptr<Config> config = nullptr;
+SceneManager scenes;
+Scheduler scheduler;
+MqttExporter mqttExporter;
+UdpTelemetry udpTelemetry;
+SessionTracker sessionTracker;
+HistoryStore historyStore;
+// Written once per sample generation in loop(), read by the async HTTP handlers
+SnapshotBuffer<MonitorSnapshot> monitorSnapshot;
 bool needUpdateState = false;
 
 // Is updating
@@ -66,19 +92,52 @@ int progressWidth = 100;
 int progressHeight = 10;
 char updatingTitle[12] = "Updating...";
 void drawUpdateProgress();
+void flushDisplay();
 
 int fanSpeed = 0;
 float lastTemperature = 0;
-// Helper function for changing TCA output channel
-void tcaselect(uint8_t channel)
+Thermistor thermistor;
+// Owns the TCA mux channel and the clock of the device behind it
+I2CBus i2cBus(Wire, TCAADDR);
+// Every periodic bus access goes through the queue so samples are not stuck behind display flushes
+I2CQueue i2cQueue(i2cBus);
+bool needI2CBenchmark = false;
+// Batches of the /i2c/bench run, stepped by the "i2c-bench" task
+const uint8_t kI2CBenchJobs = I2CBus::kBenchSpeeds * (kI2CBenchTransactions / kI2CBenchBatch);
+uint8_t i2cBenchSubmitted = kI2CBenchJobs;
+uint8_t i2cBenchCompleted = kI2CBenchJobs;
+
+void benchI2CBatch(uint8_t job, bool selected)
 {
-  if (channel > 7)
-    return;
-
-  Wire.beginTransmission(TCAADDR);
-  Wire.write(1 << channel);
-  Wire.endTransmission();
+  i2cBenchCompleted++;
+  if (selected)
+  {
+    // Register 0x01 is the SW35xx IC version, harmless to read repeatedly
+    i2cBus.benchmarkBatch(job / (kI2CBenchTransactions / kI2CBenchBatch), I2C_TARGET_CHARGER, SCREEN_ADDRESS, 0x01, kI2CBenchBatch);
+  }
 }
+// Self benchmark behind /bench, stepped by the "bench" task
+DeviceBench deviceBench(i2cQueue);
+bool needDeviceBenchmark = false;
+int sampleTask = -1;
+// The "sample" task only queues the reads, this times each generation until its last port is done
+TaskStats sampleGeneration;
+uint32_t sampleQueuedUs = 0;
+// Display pages with a write job in the queue, bit per page
+uint8_t queuedPages = 0;
+int temperatureTask = -1;
+int fanTask = -1;
+// Hours per sample, follows the sampleInterval parameter
+float powerInterval = kTimeToReadInformation / 3600000.0;
+// Raw register capture behind /capture, written by the "capture" task
+RegisterCapture registerCapture;
+// Validated by PATCH /config, applied as a whole from loop()
+Parameters stagedParameters;
+bool needApplyParameters = false;
+BootSequencer boot;
+uint32_t wifiStartUs = 0;
+Connectivity connectivity;
+bool serverStarted = false;
 
 void buildServer();
 void setupFileManagement();
@@ -90,57 +149,174 @@ void dimScreen();
 
 void buildWelcome();
 
+void setupTasks();
+void updatePortValues();
+void writeDisplayPage(uint8_t page, bool selected);
+void checkTemperature();
+void applyParameters(uint32_t changed);
+void onLinkUp();
+void listFiles();
+void scanI2C();
+
 /**
  * @brief Setup function for initializing the system.
  * 
- * This function performs the following tasks:
+ * Every step is timed by the boot sequencer, see GET /boot. Sampling starts before the network
+ * so the ports are measured and energy is counted while WiFi is still connecting:
  * - Initializes serial communication at 115200 baud rate.
- * - Mounts the LittleFS filesystem and lists all files in the root directory.
- * - Configures pin modes for switch and button.
- * - Initializes the configuration object and updates the switch state.
- * - Sets up ElegantOTA with auto-reboot disabled.
- * - Scans for I2C devices and prints their addresses.
- * - Configures the fan pin mode.
- * - Calls setupI2C() to initialize I2C communication.
- * - Adds default headers for CORS to the HTTP server.
- * - Initializes the asynchronous web server and DNS server.
- * - Sets up the WiFi manager with callbacks for AP mode and saving configuration.
- * - Attempts to auto-connect to WiFi using the configured server name.
- * - Initializes the emoticons object.
+ * - Mounts the LittleFS filesystem and loads the configuration.
+ * - Lists the files and scans the I2C bus only when boot diagnostics are enabled.
+ * - Configures pin modes for switch, button and fan.
+ * - Calls setupI2C() to initialize I2C communication and updates the switch state.
+ * - Opens the exporters, the session log and the history store.
  * - Sets up button click and long press callbacks to update switch state and reset WiFi settings, respectively.
+ * - Registers the scheduler tasks and queues the first sample.
+ * - Hands WiFi to the connectivity state machine, the server is built on the first link-up.
  */
 void setup()
 {
+  boot.phase("serial");
   Serial.begin(115200);
 
+  boot.phase("littlefs");
   if (!LittleFS.begin())
   {
     Serial.println("LittleFS mount failed");
     return;
   }
-  else
-  {
-    Serial.println("Little FS Mounted Successfully");
-    File root = LittleFS.open("/", "r");
-    File file = root.openNextFile();
+  Serial.println("Little FS Mounted Successfully");
 
-    while (file)
-    {
-      Serial.print("FILE: ");
-      Serial.println(file.name());
+  boot.phase("config");
+  pinMode(SWITCH_PIN, OUTPUT);
+  pinMode(SWITCH_BUTTON, INPUT);
 
-      file = root.openNextFile();
-    }
+  config = std::make_unique<Config>();
 
-    root.close();
+#ifdef BOOT_DIAGNOSTICS
+  bool diagnostics = true;
+#else
+  bool diagnostics = config->bootDiagnostics;
+#endif
+  if (diagnostics)
+  {
+    boot.phase("diagnostics");
+    listFiles();
+    scanI2C();
   }
 
-  pinMode(SWITCH_PIN, OUTPUT);
-  pinMode(SWITCH_BUTTON, INPUT);
+  boot.phase("i2c");
+  pinMode(FAN_PIN, OUTPUT);
 
-  config = std::make_unique<Config>();
-  
+  setupI2C();
+
+  // Force update switch state
+  updateSwitch();
+
+  boot.phase("storage");
+  mqttExporter.begin(config.get());
+  udpTelemetry.begin(config.get());
+  sessionTracker.begin();
+  historyStore.begin();
+
+  boot.phase("tasks");
+  emoticons = std::make_unique<Emoticons>();
+  config->buttonClickedCallback = []
+  {
+    needUpdateState = true;
+  };
+
+  config->buttonLongPressedCallback = [] {
+    logMessage("Button Long Pressed!");
+    wm->resetSettings();
+    delay(200);
+    ESP.reset();
+  };
+
+  applyParameters(PARAM_ALL);
+  // Prime the NTC filter so the first fan decision sees a real reading
+  thermistor.sample();
+  checkTemperature();
+  setupTasks();
+  // The "sample" task first fires a period from now, do not wait for it
+  updatePortValues();
+
+  buildWelcome();
+
+  boot.phase("wifi");
   ElegantOTA.setAutoReboot(false);
+  DefaultHeaders::Instance().addHeader("Access-Control-Allow-Origin", "*");
+  DefaultHeaders::Instance().addHeader("Access-Control-Allow-Methods", "POST, GET, OPTIONS");
+  DefaultHeaders::Instance().addHeader("Access-Control-Allow-Headers", "Content-Type");
+  server = std::make_unique<AsyncWebServer>(80);
+  dns = std::make_unique<DNSServer>();
+  Serial.println("Building wifi manager");
+  wm = std::make_unique<AsyncWiFiManager>(server.get(), dns.get());
+
+  wm->setAPCallback([](AsyncWiFiManager *wifiConfig) {
+    display.clearDisplay();
+    display.setCursor(4, 10);
+    display.setTextSize(1);
+    display.setTextColor(PX_COLOR_WHITE);
+    display.println("WiFi Setup Mode");
+    display.println("Connect to:");
+    display.println(wifiConfig->getConfigPortalSSID());
+    display.println("to configure WiFi");
+    flushDisplay();
+    scenes.show(Scene::WifiSetup); });
+
+  // Connects in the background, buildServer() runs on the first link-up
+  wifiStartUs = micros();
+  connectivity.begin(wm.get(), config->getServerName(), onLinkUp);
+
+  boot.finish();
+}
+
+/**
+ * @brief Runs on every link-up. The server and WebSocket are built on the first one and keep
+ * running across later drops, only mDNS has to announce the address again.
+ */
+void onLinkUp()
+{
+  if (scenes.current() == Scene::WifiSetup)
+  {
+    scenes.show(Scene::PortInfo);
+  }
+  // Session records carry wall clock time once this has synced
+  configTime(0, 0, kNtpServer);
+
+  if (serverStarted)
+  {
+    MDNS.notifyAPChange();
+    return;
+  }
+
+  serverStarted = true;
+  boot.record("wifi-connect", wifiStartUs);
+  uint32_t start = micros();
+  // Drop the setup portal pages if it ran, they would shadow "/"
+  server->reset();
+  buildServer();
+  boot.record("server", start);
+}
+
+void listFiles()
+{
+  File root = LittleFS.open("/", "r");
+  File file = root.openNextFile();
+
+  while (file)
+  {
+    Serial.print("FILE: ");
+    Serial.println(file.name());
+
+    file = root.openNextFile();
+  }
+
+  root.close();
+}
+
+void scanI2C()
+{
   byte error, address;
   int nDevices;
 
@@ -177,94 +353,100 @@ void setup()
     Serial.println("No I2C devices found\n");
   else
     Serial.println("done\n");
+}
 
-  pinMode(FAN_PIN, OUTPUT);
-
-  setupI2C();
-
-  // Force update switch state
-  updateSwitch();
-
-  DefaultHeaders::Instance().addHeader("Access-Control-Allow-Origin", "*");
-  DefaultHeaders::Instance().addHeader("Access-Control-Allow-Methods", "POST, GET, OPTIONS");
-  DefaultHeaders::Instance().addHeader("Access-Control-Allow-Headers", "Content-Type");
-  server = std::make_unique<AsyncWebServer>(80);
-  dns = std::make_unique<DNSServer>();
-  Serial.println("Building wifi manager");
-  wm = std::make_unique<AsyncWiFiManager>(server.get(), dns.get());
+void updateFanSpeed();
+void displayInfo();
 
-  wm->setAPCallback([](AsyncWiFiManager *wifiConfig) {
-    tcaselect(0);
-    display.clearDisplay();
-    display.setCursor(4, 10);
-    display.setTextSize(1);
-    display.setTextColor(PX_COLOR_WHITE);
-    display.println("WiFi Setup Mode");
-    display.println("Connect to:");
-    display.println(wifiConfig->getConfigPortalSSID());
-    display.println("to configure WiFi");
-    display.display();
-    delay(200); });
+void debugMemory();
 
-  bool res;
-  res = wm->autoConnect(config->getServerName().c_str());
+/**
+ * @brief Register the periodic work on the scheduler.
+ *
+ * Sampling runs at high priority with a tight deadline because energy is integrated per run;
+ * rendering, fan control and persistence only need to keep their average rate.
+ */
+void setupTasks()
+{
+  const Parameters &parameters = config->parameters;
+  sampleTask = scheduler.every("sample", parameters.getUint(PARAM_SAMPLE_INTERVAL), updatePortValues, PRIORITY_HIGH, kSampleDeadline);
+  scheduler.every("ntc", kTimeToSampleTemperature, []
+                  { thermistor.sample(); }, PRIORITY_HIGH);
+  scheduler.every("scenes", 50, []
+                  { scenes.loop(); }, PRIORITY_HIGH);
+  temperatureTask = scheduler.every("temperature", parameters.getUint(PARAM_TEMPERATURE_INTERVAL), checkTemperature);
+  scheduler.every("render", kTimeToRender, displayInfo);
+  scheduler.every("ota", 1000, drawUpdateProgress);
+  fanTask = scheduler.every("fan", parameters.getUint(PARAM_FAN_INTERVAL), updateFanSpeed);
+  scheduler.every("persist", kTimeToSaveConfig, []
+                  { config->saveConfigIfNeeded(); }, PRIORITY_LOW);
+  scheduler.every("memory", 1000, debugMemory, PRIORITY_LOW);
+  scheduler.every("sessions", 1000, []
+                  { sessionTracker.flush(); }, PRIORITY_LOW);
+  scheduler.every("history", 1000, []
+                  { historyStore.flush(); }, PRIORITY_LOW);
+  scheduler.every("wifi", kWifiPollInterval, []
+                  { connectivity.loop(); }, PRIORITY_LOW);
+  scheduler.every("mqtt", 100, []
+                  { mqttExporter.loop(); }, PRIORITY_LOW);
+  scheduler.every("i2c-bench", kBenchStepInterval, []
+                  {
+    // One batch in the queue at a time, so display pages still find room next to it
+    if (i2cBenchCompleted != i2cBenchSubmitted)
+    {
+      return;
+    }
+    if (needI2CBenchmark)
+    {
+      needI2CBenchmark = false;
+      i2cBus.beginBenchmark();
+      i2cBenchSubmitted = 0;
+      i2cBenchCompleted = 0;
+    }
+    // Display priority like the device bench, a sample due meanwhile still goes first
+    if (i2cBenchSubmitted < kI2CBenchJobs &&
+        i2cQueue.submit(I2C_PRIORITY_DISPLAY, 1, I2C_TARGET_CHARGER, benchI2CBatch, i2cBenchSubmitted))
+    {
+      i2cBenchSubmitted++;
+    } }, PRIORITY_LOW);
+  scheduler.every("bench", kBenchStepInterval, []
+                  {
+    if (needDeviceBenchmark)
+    {
+      needDeviceBenchmark = false;
+      deviceBench.start();
+    }
+    deviceBench.step(); }, PRIORITY_LOW);
+  scheduler.every("capture", kCaptureFlushInterval, []
+                  { registerCapture.flush(); }, PRIORITY_LOW);
 
-  if (!res)
+  // A task that did not fit would never run, and sampleTask and friends would index slot -1
+  if (scheduler.rejected() > 0)
   {
-    Serial.println("Failed to auto connect");
-    // ESP.restart();
+    logMessage("Scheduler table full, " + String(scheduler.rejected()) + " task(s) from \"" + String(scheduler.firstRejected()) + "\" onward not registered, raise Scheduler::kMaxTasks", true);
+    panic();
   }
-  else
-  {
-    // if you get here you have connected to the WiFi
-    Serial.println("connected...yeey :)");
-    buildServer();
-  }
-
-  emoticons = std::make_unique<Emoticons>();
-  config->buttonClickedCallback = []
-  {
-    needUpdateState = true;
-  };
-
-  config->buttonLongPressedCallback = [] {
-    logMessage("Button Long Pressed!");
-    wm->resetSettings();
-    delay(200);
-    ESP.reset();
-  };
-
-  buildWelcome();
+  deviceBench.begin(writeDisplayPage, monitorSnapshot, &sampleGeneration);
 }
 
-void checkTemperature();
-void updatePortValues();
-
-void debugMemory();
-
 /**
  * @brief The main loop of the program.
  *
  * This function is called repeatedly by the Arduino framework.
  *
  * It does the following:
- * - Updates the port values every 1000ms (1 second).
+ * - Runs the next due scheduler task (sampling, temperature, fan, rendering, persistence).
+ * - Applies switch state changes requested by the button or the web UI.
  * - Updates the MDNS service.
- * - Checks the temperature.
  * - Checks for OTA updates.
  * - Checks for WebSocket messages.
  */
 void loop()
 {
+  deviceBench.loopTick();
   config->loop();
-  static unsigned long lastUpdate = 0;
-  if (millis() - lastUpdate > 1000)
-  { // Update every second
-    lastUpdate = millis();
-    drawUpdateProgress();
-    updatePortValues();
-    debugMemory();
-  }
+  scheduler.loop();
+  i2cQueue.pump(kI2CPumpBudgetUs);
 
   if (needUpdateState)
   {
@@ -272,29 +454,24 @@ void loop()
     updateSwitch();
   }
 
+  if (needApplyParameters)
+  {
+    needApplyParameters = false;
+    uint32_t changed = stagedParameters.diff(config->parameters);
+    config->parameters = stagedParameters;
+    config->saveConfig();
+    applyParameters(changed);
+  }
+
   MDNS.update();
-  checkTemperature();
   ElegantOTA.loop();
   webSocket.loop();
 }
 
-// Ref: https://esp8266tutorials.blogspot.com/2016/09/esp8266-ntc-temperature-thermistor.html
-unsigned int Rs = 157000;
-double Vcc = 3.3;
-double Thermister(int val)
-{
-  double V_NTC = (double)val / 1024;
-  double R_NTC = (Rs * V_NTC) / (Vcc - V_NTC);
-  R_NTC = log(R_NTC);
-  double Temp = 1 / (0.001129148 + (0.000234125 + (0.0000000876741 * R_NTC * R_NTC)) * R_NTC);
-  Temp = Temp - 273.15;
-  return Temp;
-}
+// Text is composed from cached glyph columns, the marquees are pre-rendered strips
+InfoPage infoPage;
+uint32_t headerAddress = 0;
 
-// Add this global variable at the top with other globals
-unsigned int scrollPosition = 0;
-unsigned long lastScrollTime = 0;
-uint8_t pageTime = 0;
 void displayInfo()
 {
   if (isUpdating || !digitalRead(SWITCH_BUTTON))
@@ -302,39 +479,33 @@ void displayInfo()
     return;
   }
 
-  tcaselect(0);
-  display.clearDisplay();
-  display.setTextSize(1);
-  display.setTextColor(PX_COLOR_WHITE);
-
-  // Header with scrolling text
-  display.setCursor(0, 4);
-  // I hope you do not remove my name
-  String headerText = "SW3518X " + String(FWVersion);
-  headerText += " by NguyenHungA5 IP: " + WiFi.localIP().toString();
-  headerText += " | http://" + config->getServerName() + ".local";
-  headerText += "    "; // Extra spaces for smooth loop
+  // Splash screens and the current emoticon keep the display until they expire
+  if (scenes.current() != Scene::PortInfo)
+  {
+    return;
+  }
 
-  // Update scroll position every 200ms
-  if (millis() - lastScrollTime > 200)
+  // The previous frame is still going out page by page
+  if (i2cQueue.pending(I2C_PRIORITY_DISPLAY) > 0)
   {
-    lastScrollTime = millis();
-    scrollPosition++;
-    if (scrollPosition >= headerText.length())
-    {
-      scrollPosition = 0;
-    }
+    return;
   }
 
-  // Create scrolling effect by showing a window of the text
-  String displayText = headerText.substring(scrollPosition) + headerText.substring(0, scrollPosition);
-  display.print(displayText.substring(0, 15)); // Show only what fits on screen
-  display.setCursor(86, 4);
-  String tempStr = " |" + String(lastTemperature, 1) + "C";
-  display.println(tempStr);
+  display.clearDisplay();
+  FrameBuffer frame = {display.getBuffer(), SCREEN_WIDTH, SCREEN_HEIGHT};
 
-  // Draw separator line
-  display.drawLine(0, 13, 128, 13, PX_COLOR_WHITE);
+  // Header with scrolling text, only re-rendered when the address changes
+  uint32_t address = WiFi.localIP();
+  if (headerAddress != address || !infoPage.hasHeader())
+  {
+    headerAddress = address;
+    // I hope you do not remove my name
+    String headerText = "SW3518X " + String(FWVersion);
+    headerText += " by NguyenHungA5 IP: " + WiFi.localIP().toString();
+    headerText += " | http://" + config->getServerName() + ".local";
+    infoPage.setHeader(headerText);
+  }
+  infoPage.drawHeader(frame, lastTemperature);
 
   bool allPortsIdle = true;
   for (const auto &port : ports)
@@ -354,115 +525,48 @@ void displayInfo()
   // Port information
   for (int i = 0; i < 4; i++)
   {
-    int yPos = 18 + (i * 13);
-
-    // Port number (column 0)
-    display.setCursor(0, yPos);
-    display.print("P");
-    display.print(i + 1);
-
-    if (ports[i]->isActive)
-    {
-      // Page 1: Voltage, Current, Power
-      if (pageTime < 30)
-      { // Show first page for 30 cycles
-        // Voltage (column 20)
-        display.setCursor(18, yPos);
-        display.print(ports[i]->voltage, 1);
-        display.print("V");
-
-        // Current (column 55)
-        display.setCursor(55, yPos);
-        display.print(ports[i]->current, 1);
-        display.print("A");
-
-        // Power (column 90)
-        display.setCursor(90, yPos);
-        display.print(ports[i]->getPower(), 1);
-        display.print("W");
-      }
-      // Page 2: Protocol and Temperature
-      else
-      { // Show second page for exactly 5 cycles
-        // Create a formatted string for the protocol
-        String protocolText = ports[i]->protocol;
-        String displayText;
-
-        // Check if the protocol text is too long
-        if (protocolText.length() > 7)
-        {                         // Assuming 7 characters fit in the display
-          protocolText += "    "; // Extra spaces for smooth loop
-          // Scroll the text
-          static unsigned long lastScrollTime = 0;
-          static unsigned int scrollPosition = 0;
-          if (millis() - lastScrollTime > 200)
-          { // Update every 200ms
-            lastScrollTime = millis();
-            scrollPosition++;
-            if (scrollPosition >= protocolText.length())
-            {
-              scrollPosition = 0;
-            }
-          }
-          // Create the scrolling effect
-          protocolText = protocolText.substring(scrollPosition) + protocolText.substring(0, scrollPosition);
-          displayText = protocolText.substring(0, 7);
-        }
-        else
-        {
-          displayText = protocolText; // Use the full text if it's short enough
-        }
-
-        // Protocol (column 20)
-        display.setCursor(18, yPos);
-        display.print(displayText);
-
-        // Temperature (column 90)
-        display.setCursor(70, yPos);
-        display.print("Vin ");
-        display.print(ports[i]->inputVoltage, 1);
-        display.print("V");
-      }
-      pageTime++;
-      // Show second page for 10 cycles
-      if (pageTime >= 40)
-      {
-        pageTime = 0;
-      }
-    }
-    else
-    {
-      // OFF status (column 20)
-      display.setCursor(18, yPos);
-      display.print("OFF");
-    }
+    infoPage.drawPort(frame, i, *ports[i]);
   }
 
-  display.display();
+  flushDisplay();
 }
 
 void checkTemperature()
 {
-  static unsigned long lastChecktime = 0;
-  static unsigned long lastChangeFanSpeed = 0;
-  unsigned long currentTime = millis();
-  if (currentTime - lastChecktime < kTimeToCheckTemperature)
+  lastTemperature = thermistor.temperature();
+}
+
+// Push changed parameters into the tasks and the NTC table, the fan limits are read per run
+void applyParameters(uint32_t changed)
+{
+  const Parameters &parameters = config->parameters;
+  if (changed & PARAM_BIT(PARAM_SAMPLE_INTERVAL))
   {
-    return;
+    uint32_t interval = parameters.getUint(PARAM_SAMPLE_INTERVAL);
+    scheduler.setPeriod(sampleTask, interval);
+    powerInterval = interval / 3600000.0;
   }
-
-  lastChecktime = currentTime;
-  lastTemperature = Thermister(analogRead(TEMPERATURE_SENSOR_PIN));
-  displayInfo();
-
-  if (currentTime - lastChangeFanSpeed < kTimeToChangeFan)
+  if (changed & PARAM_BIT(PARAM_TEMPERATURE_INTERVAL))
   {
-    return;
+    scheduler.setPeriod(temperatureTask, parameters.getUint(PARAM_TEMPERATURE_INTERVAL));
   }
+  if (changed & PARAM_BIT(PARAM_FAN_INTERVAL))
+  {
+    scheduler.setPeriod(fanTask, parameters.getUint(PARAM_FAN_INTERVAL));
+  }
+  if (changed & (PARAM_BIT(PARAM_THERMISTOR_RS) | PARAM_BIT(PARAM_THERMISTOR_VCC)))
+  {
+    thermistor.setCircuit(parameters.getUint(PARAM_THERMISTOR_RS), parameters.get(PARAM_THERMISTOR_VCC));
+    checkTemperature();
+  }
+}
 
-  lastChangeFanSpeed = currentTime;
-
-  float percent = (lastTemperature - kMinTemperature) / (kMaxTemperature - kMinTemperature);
+void updateFanSpeed()
+{
+  const Parameters &parameters = config->parameters;
+  float minTemperature = parameters.get(PARAM_MIN_TEMPERATURE);
+  float minPower = parameters.get(PARAM_MIN_POWER);
+  float percent = (lastTemperature - minTemperature) / (parameters.get(PARAM_MAX_TEMPERATURE) - minTemperature);
   float totalPower = 0;
   if (ports.size() == 4)
   {
@@ -475,9 +579,9 @@ void checkTemperature()
     }
   }
 
-  float pPercent = (totalPower - kMinPower) / (kMaxPower - kMinPower); // kMaxPower is power max per port, so we just estimate total power
+  float pPercent = (totalPower - minPower) / (parameters.get(PARAM_MAX_POWER) - minPower); // maxPower is power max per port, so we just estimate total power
 
-  if (lastTemperature > kMinTemperature || pPercent > percent)
+  if (lastTemperature > minTemperature || pPercent > percent)
   {
     percent = max(pPercent, percent);
     if (percent < 0.05)
@@ -500,19 +604,13 @@ void onOTAStart()
   Serial.println("OTA update started!");
   isUpdating = true;
   isUpdateSuccess = false;
+  scenes.show(Scene::OtaProgress);
 }
 
-unsigned long ota_progress_millis = 0;
 void onOTAProgress(size_t current, size_t final)
 {
-  // Log every 1 second
-  if (millis() - ota_progress_millis > 1000)
-  {
-    ota_progress_millis = millis();
-    progressValue = map(current, 0, final, 0, progressWidth);
-
-    debugMemory();
-  }
+  // Drawn by the "ota" task every second
+  progressValue = map(current, 0, final, 0, progressWidth);
 }
 
 void onOTAEnd(bool success)
@@ -527,13 +625,29 @@ void onOTAEnd(bool success)
   {
     Serial.println("There was an error during OTA update!");
     isUpdating = false;
+    scenes.show(Scene::PortInfo);
   }
   // <Add your own code here>
 }
 
-File uploadFile;
+UploadSink uploadSink;
+const char *const kLinkStateNames[] = {"offline", "connecting", "online", "portal"};
+const char *const kBenchStateNames[] = {"idle", "i2c", "display", "fsWrite", "fsRead", "json", "done"};
+const char *const kBreakerStateNames[] = {"closed", "open", "probing"};
+const char *const kSW35xxResultNames[] = {"ok", "addressNack", "dataNack", "noData"};
+const char *const kCaptureStateNames[] = {"idle", "starting", "recording", "stopping"};
+
+void addBenchLatency(JsonObject target, const BenchLatency &latency)
+{
+  target["count"] = latency.count;
+  target["minUs"] = latency.minUs;
+  target["avgUs"] = latency.averageUs();
+  target["maxUs"] = latency.maxUs;
+}
 // Handle large file upload
 void handleTextUpload(AsyncWebServerRequest *request, String filename, size_t index, uint8_t *data, size_t len, bool final);
+void handleSessionList(AsyncWebServerRequest *request);
+void handleHistoryQuery(AsyncWebServerRequest *request);
 void buildServer()
 {
   if (!MDNS.begin(config->getServerName()))
@@ -568,86 +682,552 @@ void buildServer()
 
   server->on("/monitor", HTTP_GET, [&](AsyncWebServerRequest *request)
              {
-        StaticJsonDocument<640> doc;
-        JsonArray portsArray = doc.createNestedArray("ports");
-        float inputVoltage = 0.0;
-        for (int i = 0; i < 4; i++)
+        // Never read ports[] here, the loop may be halfway through updating them
+        MonitorSnapshot snapshot;
+        if (!monitorSnapshot.read(snapshot))
         {
-          JsonObject port = portsArray.createNestedObject();
-          port["voltage"] = ports[i]->voltage;
-          port["current"] = ports[i]->current;
-          port["temperature"] = ports[i]->temperature;
-          port["protocol"] = ports[i]->protocol;
-          port["isActive"] = ports[i]->isActive;
-          port["power"] = ports[i]->getPower();
-          port["totalPower"] = config->totalEnergyOf(i);
-          if (ports[i]->isActive) {
-            inputVoltage = ports[i]->inputVoltage;
-          }
+          request->send(503, "application/json", "{\"status\":\"error\",\"message\":\"sample in progress\"}");
+          return;
         }
 
-        // Module temperature
-        doc["moduleTemp"] = lastTemperature;
-        
-        // Module Input Voltage
-        // Because all port using same input source, so we just need first active port
-        doc["inputVoltage"] = inputVoltage;
-        
-        // State of module
-        doc["state"] = config->getState();
-
-        doc["fanSpeed"] = fanSpeed;
-
         String response;
-        serializeJson(doc, response);
+        writeMonitorJson(snapshot, response);
         request->send(200, "application/json", response); });
 
-  server->on("/info", HTTP_GET, [](AsyncWebServerRequest *request)
+  server->on("/tasks", HTTP_GET, [](AsyncWebServerRequest *request)
              {
-        StaticJsonDocument<128> doc;
-        doc["firmware"] = FWVersion;
-        doc["serverName"] = config->getServerName();
+        DynamicJsonDocument doc(3072);
+        JsonArray tasks = doc.createNestedArray("tasks");
+        for (uint8_t i = 0; i < scheduler.size(); i++)
+        {
+          const Task &task = scheduler.task(i);
+          if (!task.active)
+          {
+            continue;
+          }
+
+          JsonObject item = tasks.createNestedObject();
+          item["name"] = task.name;
+          item["priority"] = task.priority;
+          item["period"] = task.periodMs;
+          item["deadline"] = task.deadlineMs;
+          item["runs"] = task.stats.runs;
+          item["overruns"] = task.stats.overruns;
+          item["skipped"] = task.stats.skipped;
+          item["lastRunUs"] = task.stats.lastRunUs;
+          item["maxRunUs"] = task.stats.maxRunUs;
+          item["avgRunUs"] = task.stats.runs ? (uint32_t)(task.stats.totalRunUs / task.stats.runs) : 0;
+          item["lastLatenessMs"] = task.stats.lastLatenessMs;
+          item["maxLatenessMs"] = task.stats.maxLatenessMs;
+        }
+
+        // The "sample" task above only queues the reads, this covers them until the last port
+        JsonObject generation = doc.createNestedObject("sampleGeneration");
+        generation["deadline"] = kSampleDeadline;
+        generation["runs"] = sampleGeneration.runs;
+        generation["overruns"] = sampleGeneration.overruns;
+        generation["lastRunUs"] = sampleGeneration.lastRunUs;
+        generation["maxRunUs"] = sampleGeneration.maxRunUs;
+        generation["avgRunUs"] = sampleGeneration.runs ? (uint32_t)(sampleGeneration.totalRunUs / sampleGeneration.runs) : 0;
 
         String response;
         serializeJson(doc, response);
         request->send(200, "application/json", response); });
 
-  server->on("/state", HTTP_GET, [](AsyncWebServerRequest *request)
+  server->on("/boot", HTTP_GET, [](AsyncWebServerRequest *request)
              {
-        StaticJsonDocument<128> doc;
-        doc["state"] = config->getState();
+        DynamicJsonDocument doc(1536);
+        JsonArray phases = doc.createNestedArray("phases");
+        for (uint8_t i = 0; i < boot.count(); i++)
+        {
+          const BootPhase &phase = boot.at(i);
+          JsonObject item = phases.createNestedObject();
+          item["name"] = phase.name;
+          item["startUs"] = phase.startUs;
+          item["durationUs"] = phase.durationUs;
+        }
+        doc["setupMs"] = boot.setupUs() / 1000;
+        doc["firstSampleMs"] = boot.firstSampleUs() / 1000;
+        doc["resetReason"] = ESP.getResetReason();
+        doc["diagnostics"] = config->bootDiagnostics;
 
         String response;
         serializeJson(doc, response);
         request->send(200, "application/json", response); });
 
-  server->on("/state", HTTP_POST, [](AsyncWebServerRequest *request)
+  server->on("/boot", HTTP_POST, [](AsyncWebServerRequest *request)
              {
-        String state = request->arg("state");
-        if (state == "on") {
-          config->setState(true);
-        } else if (state == "off") {
-          config->setState(false);
+        if (!request->hasArg("diagnostics"))
+        {
+          request->send(400, "application/json", "{\"status\":\"error\",\"message\":\"Missing diagnostics parameter\"}");
+          return;
         }
+        // Takes effect on the next boot
+        config->bootDiagnostics = request->arg("diagnostics") == "true" || request->arg("diagnostics") == "1";
+        config->saveConfig();
+        request->send(200, "application/json", "{\"status\":\"success\"}"); });
 
-        needUpdateState = true;
-        request->send(200, "application/json", "State updated"); });
-
-  server->on("/reset_energy", HTTP_POST, [](AsyncWebServerRequest *request)
+  server->on("/i2c", HTTP_GET, [](AsyncWebServerRequest *request)
              {
-        int portIndex = request->arg("port").toInt();
-        config->resetTotalEnergy(portIndex - 1);
-        logMessage("Reset total energy of port " + String(portIndex));
-        request->send(200, "application/json", "State updated"); });
+        DynamicJsonDocument doc(2048);
+        doc["displayClock"] = i2cBus.clockOf(I2C_TARGET_DISPLAY);
+        doc["chargerClock"] = i2cBus.clockOf(I2C_TARGET_CHARGER);
+        JsonArray channels = doc.createNestedArray("channels");
+        for (uint8_t i = 0; i < 5; i++)
+        {
+          const I2CChannelStats &stats = i2cBus.stats(i);
+          JsonObject channel = channels.createNestedObject();
+          channel["channel"] = i;
+          channel["transactions"] = stats.transactions;
+          channel["naks"] = stats.naks;
+          channel["timeouts"] = stats.timeouts;
+          channel["recoveries"] = stats.recoveries;
+        }
 
-  server->on("/edit", HTTP_GET, [](AsyncWebServerRequest *request)
-             { request->send(LittleFS, "/edit.html", "text/html"); });
+        JsonArray bench = doc.createNestedArray("bench");
+        for (uint8_t i = 0; i < I2CBus::kBenchSpeeds; i++)
+        {
+          const I2CBenchResult &result = i2cBus.benchResult(i);
+          if (result.attempts == 0)
+          {
+            continue;
+          }
+          JsonObject item = bench.createNestedObject();
+          item["clock"] = result.clock;
+          item["attempts"] = result.attempts;
+          item["failures"] = result.failures;
+          item["tps"] = result.transactionsPerSecond;
+        }
 
-  server->on("/edit_content", HTTP_GET, [](AsyncWebServerRequest *request)
-             { request->send(LittleFS, "/index.html", "text/html"); });
+        JsonArray queue = doc.createNestedArray("queue");
+        for (uint8_t i = 0; i < I2C_PRIORITY_COUNT; i++)
+        {
+          const I2CQueueStats &stats = i2cQueue.stats((I2CPriority)i);
+          JsonObject item = queue.createNestedObject();
+          item["priority"] = i == I2C_PRIORITY_CHARGER ? "charger" : "display";
+          item["pending"] = i2cQueue.pending((I2CPriority)i);
+          item["jobs"] = stats.jobs;
+          item["dropped"] = stats.dropped;
+          item["unselected"] = stats.unselected;
+          item["lastDelayUs"] = stats.lastDelayUs;
+          item["maxDelayUs"] = stats.maxDelayUs;
+          item["avgDelayUs"] = stats.jobs ? (uint32_t)(stats.totalDelayUs / stats.jobs) : 0;
+        }
+
+        String response;
+        serializeJson(doc, response);
+        request->send(200, "application/json", response); });
+
+  // The benchmark runs from the scheduler in batches through the I2C queue, not in the TCP callback
+  server->on("/i2c/bench", HTTP_POST, [](AsyncWebServerRequest *request)
+             {
+        needI2CBenchmark = true;
+        request->send(202, "application/json", "{\"status\":\"scheduled\"}"); });
+
+  server->on("/bench", HTTP_GET, [](AsyncWebServerRequest *request)
+             {
+        DynamicJsonDocument doc(2048);
+        doc["state"] = kBenchStateNames[deviceBench.state()];
+        if (deviceBench.state() != BENCH_DONE)
+        {
+          String response;
+          serializeJson(doc, response);
+          request->send(200, "application/json", response);
+          return;
+        }
+
+        const DeviceBenchResults &results = deviceBench.results();
+        JsonArray channels = doc.createNestedArray("i2c");
+        for (uint8_t i = 0; i < kBenchChannels; i++)
+        {
+          JsonObject channel = channels.createNestedObject();
+          channel["channel"] = i;
+          addBenchLatency(channel, results.i2c[i]);
+          channel["failures"] = results.i2cFailures[i];
+        }
+        addBenchLatency(doc.createNestedObject("displayPage"), results.displayPage);
+        addBenchLatency(doc.createNestedObject("displayPagesSum"), results.displayPagesSum);
+        doc["fsWriteBytesPerSecond"] = results.fsWriteBytesPerSecond;
+        doc["fsReadBytesPerSecond"] = results.fsReadBytesPerSecond;
+        addBenchLatency(doc.createNestedObject("json"), results.json);
+        addBenchLatency(doc.createNestedObject("loop"), results.loop);
+        JsonArray timedOut = doc.createNestedArray("timedOut");
+        for (uint8_t state = BENCH_I2C; state < BENCH_DONE; state++)
+        {
+          if (results.timedOut & (1 << state))
+          {
+            timedOut.add(kBenchStateNames[state]);
+          }
+        }
+        doc["sampleOverruns"] = results.overruns;
+        doc["durationMs"] = results.durationMs;
+#ifdef OLED_SSD1306
+        doc["display"] = "SSD1306";
+#else
+        doc["display"] = "SH1106";
+#endif
+        doc["flashChipId"] = ESP.getFlashChipId();
+        doc["rssi"] = WiFi.RSSI();
+
+        String response;
+        serializeJson(doc, response);
+        request->send(200, "application/json", response); });
+
+  server->on("/bench", HTTP_POST, [](AsyncWebServerRequest *request)
+             {
+        // Only flags the run, the suite itself is stepped from loop()
+        if (needDeviceBenchmark || deviceBench.isRunning())
+        {
+          request->send(409, "application/json", "{\"status\":\"error\",\"message\":\"benchmark already running\"}");
+          return;
+        }
+        needDeviceBenchmark = true;
+        request->send(202, "application/json", "{\"status\":\"started\"}"); });
+
+  // Registered before /capture, which it would otherwise shadow
+  server->on("/capture/download", HTTP_GET, [](AsyncWebServerRequest *request)
+             {
+        if (!LittleFS.exists(CAPTURE_FILE))
+        {
+          request->send(404, "application/json", "{\"status\":\"error\",\"message\":\"no capture\"}");
+          return;
+        }
+        request->send(LittleFS, CAPTURE_FILE, "application/octet-stream", true); });
+
+  server->on("/capture", HTTP_GET, [](AsyncWebServerRequest *request)
+             {
+        const CaptureStats &stats = registerCapture.stats();
+        StaticJsonDocument<192> doc;
+        doc["state"] = kCaptureStateNames[registerCapture.state()];
+        doc["records"] = stats.records;
+        doc["dropped"] = stats.dropped;
+        doc["bytes"] = stats.bytes;
+        doc["maxBytes"] = kCaptureMaxBytes;
+        doc["durationMs"] = stats.durationMs;
+
+        String response;
+        serializeJson(doc, response);
+        request->send(200, "application/json", response); });
+
+  server->on("/capture", HTTP_POST, [](AsyncWebServerRequest *request)
+             {
+        // Only flags the change, the file is written by the "capture" task
+        String action = request->arg("action");
+        if (action == "start")
+        {
+          registerCapture.requestStart(config->parameters.getUint(PARAM_SAMPLE_INTERVAL));
+        }
+        else if (action == "stop")
+        {
+          registerCapture.requestStop();
+        }
+        else
+        {
+          request->send(400, "application/json", "{\"status\":\"error\",\"message\":\"action must be start or stop\"}");
+          return;
+        }
+        request->send(202, "application/json", "{\"status\":\"accepted\"}"); });
+
+  server->on("/config", HTTP_GET, [](AsyncWebServerRequest *request)
+             {
+        DynamicJsonDocument doc(1536);
+        doc["pending"] = needApplyParameters;
+        JsonObject parametersObject = doc.createNestedObject("parameters");
+        for (uint8_t i = 0; i < PARAM_COUNT; i++)
+        {
+          ParameterId id = (ParameterId)i;
+          const ParameterInfo &info = Parameters::info(id);
+          JsonObject parameter = parametersObject.createNestedObject(info.name);
+          parameter["value"] = config->parameters.get(id);
+          parameter["type"] = info.type == PARAM_TYPE_UINT ? "uint" : "float";
+          parameter["min"] = info.minValue;
+          parameter["max"] = info.maxValue;
+          parameter["default"] = info.defaultValue;
+          parameter["unit"] = info.unit;
+        }
+
+        String response;
+        serializeJson(doc, response);
+        request->send(200, "application/json", response); });
+
+  // JSON object of name: value, every value is checked before any is applied
+  server->on(
+      "/config", HTTP_PATCH, [](AsyncWebServerRequest *request)
+      {
+        if (!request->_tempObject)
+        {
+          request->send(400, "application/json", "{\"status\":\"error\",\"message\":\"missing or oversized body\"}");
+          return;
+        }
+
+        StaticJsonDocument<kParametersBodyMax> body;
+        if (deserializeJson(body, (const char *)request->_tempObject) || !body.is<JsonObject>())
+        {
+          request->send(400, "application/json", "{\"status\":\"error\",\"message\":\"invalid JSON\"}");
+          return;
+        }
+
+        // A PATCH not yet applied is the base, so two quick batches do not undo each other
+        Parameters staged = needApplyParameters ? stagedParameters : config->parameters;
+        const char *rejected = nullptr;
+        for (JsonPair pair : body.as<JsonObject>())
+        {
+          ParameterId id = Parameters::find(pair.key().c_str());
+          if (id == PARAM_COUNT || !pair.value().is<float>() || !staged.set(id, pair.value().as<float>()))
+          {
+            rejected = pair.key().c_str();
+            break;
+          }
+        }
+        if (!rejected)
+        {
+          rejected = staged.validate();
+        }
+        if (rejected)
+        {
+          StaticJsonDocument<192> doc;
+          doc["status"] = "error";
+          doc["message"] = "invalid parameter";
+          doc["parameter"] = rejected;
+          String response;
+          serializeJson(doc, response);
+          request->send(400, "application/json", response);
+          return;
+        }
+
+        stagedParameters = staged;
+        needApplyParameters = true;
+        request->send(202, "application/json", "{\"status\":\"accepted\"}"); },
+      nullptr,
+      [](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total)
+      {
+        if (total >= kParametersBodyMax)
+        {
+          return;
+        }
+        if (index == 0)
+        {
+          // Freed by the request
+          request->_tempObject = malloc(total + 1);
+        }
+        if (request->_tempObject)
+        {
+          memcpy((uint8_t *)request->_tempObject + index, data, len);
+          if (index + len == total)
+          {
+            ((char *)request->_tempObject)[total] = 0;
+          }
+        }
+      });
+
+  server->on("/mqtt", HTTP_GET, [](AsyncWebServerRequest *request)
+             {
+        StaticJsonDocument<384> doc;
+        doc["enabled"] = config->mqttEnabled;
+        doc["host"] = config->mqttHost;
+        doc["port"] = config->mqttPort;
+        doc["user"] = config->mqttUser;
+        doc["interval"] = config->mqttInterval;
+        doc["connected"] = mqttExporter.isConnected();
+        doc["queued"] = mqttExporter.queued();
+        const MqttStats &stats = mqttExporter.stats();
+        doc["published"] = stats.published;
+        doc["dropped"] = stats.dropped;
+        doc["connects"] = stats.connects;
+        doc["lastLatencyUs"] = stats.lastLatencyUs;
+        doc["maxLatencyUs"] = stats.maxLatencyUs;
+        doc["heapCost"] = stats.heapCost;
+
+        String response;
+        serializeJson(doc, response);
+        request->send(200, "application/json", response); });
+
+  server->on("/mqtt", HTTP_POST, [](AsyncWebServerRequest *request)
+             {
+        if (request->hasArg("enabled"))
+        {
+          config->mqttEnabled = request->arg("enabled") == "true" || request->arg("enabled") == "1";
+        }
+        if (request->hasArg("host"))
+        {
+          config->mqttHost = request->arg("host");
+        }
+        if (request->hasArg("port"))
+        {
+          config->mqttPort = request->arg("port").toInt();
+        }
+        if (request->hasArg("user"))
+        {
+          config->mqttUser = request->arg("user");
+        }
+        if (request->hasArg("password"))
+        {
+          config->mqttPassword = request->arg("password");
+        }
+        if (request->hasArg("interval"))
+        {
+          config->mqttInterval = max(1000L, request->arg("interval").toInt());
+        }
+        config->saveConfig();
+        mqttExporter.reconfigure();
+        request->send(200, "application/json", "{\"status\":\"success\"}"); });
+
+  server->on("/sessions", HTTP_GET, handleSessionList);
+
+  server->on("/history/info", HTTP_GET, [](AsyncWebServerRequest *request)
+             {
+        const HistoryStats &stats = historyStore.stats();
+        const std::vector<uint32_t> &segments = historyStore.segments();
+        StaticJsonDocument<384> doc;
+        doc["segments"] = segments.size();
+        doc["oldest"] = segments.empty() ? 0 : segments.front();
+        doc["newest"] = segments.empty() ? 0 : segments.back();
+        doc["interval"] = kHistoryInterval;
+        doc["pendingBlocks"] = historyStore.sealedCount();
+        doc["openPoints"] = historyStore.current().count;
+        doc["pointsWritten"] = stats.pointsWritten;
+        doc["blocksWritten"] = stats.blocksWritten;
+        doc["blocksDropped"] = stats.blocksDropped;
+        doc["segmentsDropped"] = stats.segmentsDropped;
+        doc["unsyncedSamples"] = stats.unsyncedSamples;
+        doc["lastFlushUs"] = stats.lastFlushUs;
+        doc["maxFlushUs"] = stats.maxFlushUs;
+
+        String response;
+        serializeJson(doc, response);
+        request->send(200, "application/json", response); });
+
+  // Registered after /history/info, which it would otherwise shadow
+  server->on("/history", HTTP_GET, handleHistoryQuery);
+
+  server->on("/udp", HTTP_GET, [](AsyncWebServerRequest *request)
+             {
+        StaticJsonDocument<192> doc;
+        doc["enabled"] = config->udpEnabled;
+        doc["address"] = config->udpAddress;
+        doc["port"] = kTelemetryPort;
+        doc["sequence"] = udpTelemetry.sequence();
+        doc["sent"] = udpTelemetry.sent();
+        doc["failed"] = udpTelemetry.failed();
+        doc["queued"] = udpTelemetry.queued();
+        doc["dropped"] = udpTelemetry.dropped();
+
+        String response;
+        serializeJson(doc, response);
+        request->send(200, "application/json", response); });
+
+  server->on("/udp", HTTP_POST, [](AsyncWebServerRequest *request)
+             {
+        if (request->hasArg("enabled"))
+        {
+          config->udpEnabled = request->arg("enabled") == "true" || request->arg("enabled") == "1";
+        }
+        if (request->hasArg("address"))
+        {
+          config->udpAddress = request->arg("address");
+        }
+        config->saveConfig();
+        request->send(200, "application/json", "{\"status\":\"success\"}"); });
+
+  server->on("/network", HTTP_GET, [](AsyncWebServerRequest *request)
+             {
+        const ConnectivityStats &stats = connectivity.stats();
+        StaticJsonDocument<384> doc;
+        doc["state"] = kLinkStateNames[connectivity.state()];
+        doc["ip"] = WiFi.localIP().toString();
+        doc["rssi"] = WiFi.RSSI();
+        doc["backoffMs"] = connectivity.backoff();
+        doc["portal"] = connectivity.portalOpen();
+        doc["attempts"] = stats.attempts;
+        doc["connects"] = stats.connects;
+        doc["drops"] = stats.drops;
+        doc["offlineMs"] = stats.offlineMs;
+        doc["sinceMs"] = millis() - stats.changedAt;
+        doc["udpQueued"] = udpTelemetry.queued();
+        doc["mqttQueued"] = mqttExporter.queued();
+
+        String response;
+        serializeJson(doc, response);
+        request->send(200, "application/json", response); });
+
+  server->on("/health", HTTP_GET, [](AsyncWebServerRequest *request)
+             {
+        DynamicJsonDocument doc(1536);
+        uint32_t now = millis();
+        JsonArray portsArray = doc.createNestedArray("ports");
+        for (uint8_t i = 0; i < ports.size(); i++)
+        {
+          const PortHealth &health = ports[i]->health;
+          const PortHealthStats &stats = health.stats();
+          const SW35xx::errorStats_t &driver = ports[i]->sw->errorStats();
+          JsonObject port = portsArray.createNestedObject();
+          port["port"] = i + 1;
+          port["breaker"] = kBreakerStateNames[health.state()];
+          port["score"] = health.score();
+          port["valid"] = ports[i]->valid;
+          port["consecutiveFailures"] = health.consecutiveFailures();
+          port["retryInMs"] = health.retryIn(now);
+          port["samples"] = stats.samples;
+          port["failures"] = stats.failures;
+          port["skipped"] = stats.skipped;
+          port["trips"] = stats.trips;
+          port["lastError"] = kSW35xxResultNames[stats.lastError < SW35xx::RESULT_COUNT ? stats.lastError : 0];
+          port["lastFailureAgoMs"] = stats.failures > 0 ? now - stats.lastFailureAt : 0;
+          port["transfers"] = driver.transfers;
+          port["transferFailures"] = driver.failures;
+          port["retries"] = driver.retries;
+        }
+
+        String response;
+        serializeJson(doc, response);
+        request->send(200, "application/json", response); });
+
+  server->on("/info", HTTP_GET, [](AsyncWebServerRequest *request)
+             {
+        StaticJsonDocument<128> doc;
+        doc["firmware"] = FWVersion;
+        doc["serverName"] = config->getServerName();
+
+        String response;
+        serializeJson(doc, response);
+        request->send(200, "application/json", response); });
+
+  server->on("/state", HTTP_GET, [](AsyncWebServerRequest *request)
+             {
+        StaticJsonDocument<128> doc;
+        doc["state"] = config->getState();
+
+        String response;
+        serializeJson(doc, response);
+        request->send(200, "application/json", response); });
+
+  server->on("/state", HTTP_POST, [](AsyncWebServerRequest *request)
+             {
+        String state = request->arg("state");
+        if (state == "on") {
+          config->setState(true);
+        } else if (state == "off") {
+          config->setState(false);
+        }
+
+        needUpdateState = true;
+        request->send(200, "application/json", "State updated"); });
+
+  server->on("/reset_energy", HTTP_POST, [](AsyncWebServerRequest *request)
+             {
+        int portIndex = request->arg("port").toInt();
+        config->resetTotalEnergy(portIndex - 1);
+        logMessage("Reset total energy of port " + String(portIndex));
+        request->send(200, "application/json", "State updated"); });
+
+  server->on("/edit", HTTP_GET, [](AsyncWebServerRequest *request)
+             { request->send(LittleFS, "/edit.html", "text/html"); });
+
+  server->on("/edit_content", HTTP_GET, [](AsyncWebServerRequest *request)
+             { request->send(LittleFS, "/index.html", "text/html"); });
 
   server->on("/edit", HTTP_POST, [](AsyncWebServerRequest *request)
-             { request->send(200, "text/plain", "File written successfully"); }, handleTextUpload);
+             { uploadSink.sendResult(request, "File written successfully"); }, handleTextUpload);
   emoticons->addListener(server.get());
 
   /*
@@ -689,9 +1269,13 @@ void buildServer()
   webSocket.begin();
 }
 
-void setupDisplay() {
-  // Init OLED display on bus number 0
-  tcaselect(0);
+// Init the OLED, run on mux channel 0 like every other display job
+void beginDisplay(uint8_t, bool selected)
+{
+  if (!selected)
+  {
+    return;
+  }
 #ifdef OLED_SSD1306
     display.begin(SSD1306_SWITCHCAPVCC, SCREEN_ADDRESS);
 #else
@@ -699,16 +1283,26 @@ void setupDisplay() {
 #endif
 }
 
+// Queued after boot: a charger also answers at SCREEN_ADDRESS, so the bus is only driven from the queue
+void setupDisplay() {
+  if (!i2cQueue.submit(I2C_PRIORITY_DISPLAY, 0, I2C_TARGET_DISPLAY, beginDisplay))
+  {
+    logMessage("Display init dropped, the bus queue is full", true);
+  }
+}
+
 void setupI2C()
 {
   // Start I2C communication with the Multiplexer
-  Wire.begin();
+  i2cBus.begin();
 
-  setupDisplay();
+  infoPage.begin();
+  // Nothing else uses the bus yet, the display is set up before the queue runs
+  beginDisplay(0, i2cBus.select(0, I2C_TARGET_DISPLAY));
   
   for (uint i = 0; i < 4; i++)
   {
-    tcaselect(i + 1);
+    i2cBus.select(i + 1, I2C_TARGET_CHARGER);
     auto item = std::make_unique<PortItem>();
     item->update();
     ports.push_back(std::move(item));
@@ -716,29 +1310,235 @@ void setupI2C()
 }
 
 // Updating port values
-float powerInterval = 1000.0 / 3600000.0;
-void updatePortValues()
+void publishSampleGeneration()
 {
-  for (int i = 0; i < 4; i++)
+  if (!udpTelemetry.isEnabled())
+  {
+    return;
+  }
+
+  TelemetryPacket packet = {};
+  packet.temperature = lastTemperature * 100;
+  packet.fanDuty = fanSpeed;
+  packet.state = config->getState();
+  for (uint8_t i = 0; i < kTelemetryPorts && i < ports.size(); i++)
+  {
+    TelemetryPortSample &sample = packet.ports[i];
+    sample.voltage_mV = ports[i]->voltage * 1000;
+    sample.current_mA = ports[i]->current * 1000;
+    sample.inputVoltage_mV = ports[i]->inputVoltage * 1000;
+    sample.protocol = ports[i]->sw->fastChargeType;
+    sample.pdVersion = ports[i]->sw->PDVersion;
+    sample.flags = (ports[i]->isActive ? TELEMETRY_PORT_ACTIVE : 0) | (ports[i]->valid ? 0 : TELEMETRY_PORT_INVALID);
+    sample.energy = config->totalEnergyOf(i);
+  }
+
+  udpTelemetry.send(packet);
+}
+
+void publishSnapshot()
+{
+  MonitorSnapshot snapshot;
+  memset(&snapshot, 0, sizeof(snapshot));
+  snapshot.generation = monitorSnapshot.published() + 1;
+  snapshot.uptimeMs = millis();
+  for (uint8_t i = 0; i < kSnapshotPorts && i < ports.size(); i++)
+  {
+    PortSnapshot &sample = snapshot.ports[i];
+    sample.voltage = ports[i]->voltage;
+    sample.current = ports[i]->current;
+    sample.inputVoltage = ports[i]->inputVoltage;
+    sample.temperature = ports[i]->temperature;
+    sample.power = ports[i]->getPower();
+    sample.energy = config->totalEnergyOf(i);
+    sample.fastChargeType = ports[i]->sw->fastChargeType;
+    sample.pdVersion = ports[i]->sw->PDVersion;
+    sample.active = ports[i]->isActive;
+    sample.valid = ports[i]->valid;
+    sample.breaker = ports[i]->health.state();
+    sample.health = ports[i]->health.score();
+    strlcpy(sample.protocol, ports[i]->protocol.c_str(), sizeof(sample.protocol));
+    // Because all port using same input source, so we just need first active port
+    if (sample.active)
+    {
+      snapshot.inputVoltage = sample.inputVoltage;
+    }
+  }
+  snapshot.moduleTemperature = lastTemperature;
+  snapshot.fanSpeed = fanSpeed;
+  snapshot.state = config->getState();
+  monitorSnapshot.publish(snapshot);
+}
+
+// Only buffers in RAM, the "history" task writes the blocks out
+void recordHistory()
+{
+  uint16_t voltage_mV[kHistoryPorts] = {0};
+  uint16_t current_mA[kHistoryPorts] = {0};
+  for (uint8_t i = 0; i < kHistoryPorts && i < ports.size(); i++)
+  {
+    if (ports[i]->isActive)
+    {
+      voltage_mV[i] = ports[i]->voltage * 1000;
+      current_mA[i] = ports[i]->current * 1000;
+    }
+  }
+  historyStore.record(voltage_mV, current_mA);
+}
+
+// Closes a sample generation, from the reads queued by updatePortValues() to the last port done
+void accountSampleGeneration()
+{
+  uint32_t runUs = micros() - sampleQueuedUs;
+  uint32_t lateness = scheduler.task(sampleTask).stats.lastLatenessMs;
+  sampleGeneration.runs++;
+  sampleGeneration.lastRunUs = runUs;
+  sampleGeneration.maxRunUs = max(sampleGeneration.maxRunUs, runUs);
+  sampleGeneration.totalRunUs += runUs;
+  sampleGeneration.lastLatenessMs = lateness;
+  sampleGeneration.maxLatenessMs = max(sampleGeneration.maxLatenessMs, lateness);
+  if (lateness + runUs / 1000 > kSampleDeadline)
+  {
+    sampleGeneration.overruns++;
+  }
+}
+
+void samplePort(uint8_t i, bool selected)
+{
+  // A port answered or was seen unplugged in this generation, so it says something about the ports
+  static bool generationSampled = false;
+  PortItem &port = *ports[i];
+  uint32_t now = millis();
+  // A full queue or a mux that did not switch says nothing about the port: it keeps its last
+  // values and counts no failure, the queue and bus stats account for those. With the breaker
+  // open the channel is left alone until the next probe
+  if (selected && port.sampleAllowed(now))
   {
-    tcaselect(i + 1);
-    Wire.beginTransmission(SCREEN_ADDRESS); // WS3518 have same address with OLED
-    if (Wire.endTransmission() == 0)
+    // WS3518 have same address with OLED
+    bool present = i2cBus.probe(SCREEN_ADDRESS);
+    SW35xx::result_t result = SW35xx::RESULT_ADDRESS_NACK;
+    if (present)
+    {
+      result = port.update();
+    }
+    if (present)
+    {
+      registerCapture.record(i, result, port.sw->rawRegisters());
+    }
+    else
     {
+      registerCapture.record(i, kCapturePortAbsent, nullptr);
+    }
+
+    float energy = 0;
+    SampleOutcome outcome = port.applySample(present, result, now, powerInterval, energy);
+    switch (outcome)
+    {
+    case SAMPLE_OK:
+      generationSampled = true;
       logMessage("\nPort " + String(i + 1) + " is active");
-      ports[i]->update();
-      ports[i]->isActive = true;
-      float power = ports[i]->getPower();
-      if (power > 0.0)
+      sessionTracker.update(i, true, port.voltage, port.current, port.sw->fastChargeType, port.sw->PDVersion);
+      if (energy > 0.0)
+      {
+        config->updateTotalEnergy(energy, i);
+      }
+      mqttExporter.record(i, true, port.voltage * 1000, port.current * 1000, port.protocol, config->totalEnergyOf(i));
+      break;
+    case SAMPLE_ABSENT:
+      generationSampled = true;
+      sessionTracker.update(i, false, 0, 0, 0, 0);
+      logMessage("Port " + String(i + 1) + " is deactive");
+      mqttExporter.record(i, false, port.voltage * 1000, port.current * 1000, port.protocol, config->totalEnergyOf(i));
+      break;
+    default:
+      // Invalid sample, no energy is counted and the last good values are kept
+      logMessage("Port " + String(i + 1) + " read failed with error " + String(result) + ", " + String(port.health.consecutiveFailures()) + " in a row");
+      if (outcome == SAMPLE_TRIPPED)
       {
-        float enegy = power * powerInterval;
-        config->updateTotalEnergy(enegy, i);
+        logMessage("Port " + String(i + 1) + " breaker open", true);
+        sessionTracker.update(i, false, 0, 0, 0, 0);
       }
+      break;
     }
-    else
+  }
+
+  // Ports are queued in order, so the last one closes the sample generation
+  if (i == ports.size() - 1)
+  {
+    accountSampleGeneration();
+    // A generation of failed or skipped reads is not the first sample yet
+    if (generationSampled)
     {
-      ports[i]->isActive = false;
-      logMessage("Port " + String(i + 1) + " is deactive");
+      boot.markFirstSample();
+    }
+    generationSampled = false;
+    publishSnapshot();
+    publishSampleGeneration();
+    recordHistory();
+  }
+}
+
+void updatePortValues()
+{
+  sampleQueuedUs = micros();
+  for (int i = 0; i < 4; i++)
+  {
+    // A full queue skips the port but still has to close the generation
+    if (!i2cQueue.submit(I2C_PRIORITY_CHARGER, i + 1, I2C_TARGET_CHARGER, samplePort, i))
+    {
+      samplePort(i, false);
+    }
+  }
+}
+
+void oledCommands(const uint8_t *commands, uint8_t count)
+{
+  Wire.beginTransmission(SCREEN_ADDRESS);
+  Wire.write((uint8_t)0x00); // Co = 0, D/C = 0: command stream
+  Wire.write(commands, count);
+  i2cBus.record(Wire.endTransmission());
+}
+
+// Write one page (8 rows) of the frame buffer, the preemptible unit of flushDisplay()
+void writeDisplayPage(uint8_t page, bool selected)
+{
+  queuedPages &= ~(1 << page);
+  if (!selected)
+  {
+    return;
+  }
+
+#ifdef OLED_SSD1306
+  // Horizontal addressing mode is set up by display.begin()
+  const uint8_t commands[] = {0x22, page, page, 0x21, 0, SCREEN_WIDTH - 1}; // PAGEADDR, COLUMNADDR
+#else
+  // SH1106 RAM is 132 columns wide, the visible area starts at column 2
+  const uint8_t commands[] = {(uint8_t)(0xB0 + page), 0x02, 0x10}; // Page, low column, high column
+#endif
+  oledCommands(commands, sizeof(commands));
+
+  const uint8_t *data = display.getBuffer() + page * SCREEN_WIDTH;
+  for (int offset = 0; offset < SCREEN_WIDTH; offset += kOledChunkSize)
+  {
+    Wire.beginTransmission(SCREEN_ADDRESS);
+    Wire.write((uint8_t)0x40); // Co = 0, D/C = 1: data stream
+    Wire.write(data + offset, min(kOledChunkSize, SCREEN_WIDTH - offset));
+    i2cBus.record(Wire.endTransmission());
+  }
+}
+
+void flushDisplay()
+{
+  for (uint8_t page = 0; page < SCREEN_HEIGHT / 8; page++)
+  {
+    // A page still queued sends the current buffer when it runs, it does not need a second job
+    if (queuedPages & (1 << page))
+    {
+      continue;
+    }
+    if (i2cQueue.submit(I2C_PRIORITY_DISPLAY, 0, I2C_TARGET_DISPLAY, writeDisplayPage, page))
+    {
+      queuedPages |= 1 << page;
     }
   }
 }
@@ -757,79 +1557,382 @@ void logMessage(const String &message, bool sendToSerial)
   }
 }
 
-void updateSwitch()
+// Dim or restore the panel, a display job so the commands cannot reach a charger at the same address
+void writeDisplayDim(uint8_t dim, bool selected)
 {
-
-  bool needDim = !config->getState();
-
-  if (needDim) {
-    display.clearDisplay();
-    display.setTextSize(1);
-    display.setTextColor(PX_COLOR_WHITE);
-    display.setCursor(4, 14);
-    display.println("Bye bye...");
-    display.display();
-    delay(1000);
+  if (!selected)
+  {
+    return;
   }
-
 #ifdef OLED_SSD1306
-  display.dim(needDim);
+  display.dim(dim);
 #else
-  display.setContrast(needDim ? 0 : 0x7F);
+  display.setContrast(dim ? 0 : 0x7F);
 #endif
+}
+
+void applySwitchState()
+{
+  bool needDim = !config->getState();
+  i2cQueue.submit(I2C_PRIORITY_DISPLAY, 0, I2C_TARGET_DISPLAY, writeDisplayDim, needDim);
 
   digitalWrite(SWITCH_PIN, config->getState());
   String stateStr = config->getState() ? "On" : "Off";
   logMessage("Update state to => " + stateStr);
   if (config->getState())
   {
-    delay(150);
-    setupDisplay();
-    buildWelcome();
+    // The chargers lost power with the rail and are back at their power-on configuration
+    for (uint8_t i = 0; i < ports.size(); i++)
+    {
+      ports[i]->sw->invalidateConfigCache();
+    }
+    // Give the switched rail 150ms to settle before initializing the display again
+    scenes.show(Scene::Welcome, 150, []
+                {
+      setupDisplay();
+      buildWelcome(); });
   }
-  
+}
+
+void updateSwitch()
+{
+  if (!config->getState()) {
+    sessionTracker.closeAll(SESSION_END_SWITCHED_OFF);
+    display.clearDisplay();
+    display.setTextSize(1);
+    display.setTextColor(PX_COLOR_WHITE);
+    display.setCursor(4, 14);
+    display.println("Bye bye...");
+    flushDisplay();
+    scenes.show(Scene::Bye, 1000, applySwitchState);
+    return;
+  }
+
+  applySwitchState();
 }
 
 // Handle large file upload
 void handleTextUpload(AsyncWebServerRequest *request, String filename, size_t index, uint8_t *data, size_t len, bool final)
 {
-  if (index == 0)
+  uploadSink.handleChunk(request, "/index.html", index, data, len, final);
+}
+
+const char *const kSessionProtocolNames[] = {"None", "QC2.0", "QC3.0", "FCP", "SCP", "PD FIX", "PD PPS", "PE1.1", "PE2.0", "LVDC", "SFCP", "AFC"};
+const char *const kSessionEndReasons[] = {"idle", "unplugged", "switchedOff"};
+
+String sessionProtocolsJson(uint16_t protocols)
+{
+  String json = "[";
+  for (uint8_t bit = 0; bit < sizeof(kSessionProtocolNames) / sizeof(kSessionProtocolNames[0]); bit++)
   {
-    // First chunk of data, open the file
-    logMessage("Starting text upload");
-    if (LittleFS.exists("/index.html"))
+    if (protocols & (1 << bit))
     {
-      LittleFS.remove("/index.html"); // Remove the existing file if it exists
+      json += json.length() > 1 ? ",\"" : "\"";
+      json += kSessionProtocolNames[bit];
+      json += "\"";
     }
-    uploadFile = LittleFS.open("/index.html", "w");
-    if (!uploadFile)
+  }
+  return json + "]";
+}
+
+String sessionRecordJson(const SessionRecord &record)
+{
+  String json = "{\"id\":" + String(record.id);
+  json += ",\"port\":" + String(record.port);
+  json += ",\"start\":" + String(record.startTime);
+  json += ",\"uptime\":" + String(record.startUptime);
+  json += ",\"duration\":" + String(record.duration);
+  json += ",\"energy\":" + String(record.energy, 3);
+  json += ",\"peakPower\":" + String(record.peakPower / 100.0, 2);
+  json += ",\"averagePower\":" + String(record.averagePower / 100.0, 2);
+  json += ",\"peakCurrent\":" + String(record.peakCurrent_mA / 1000.0, 3);
+  json += ",\"protocols\":" + sessionProtocolsJson(record.protocols);
+  json += ",\"pd2\":";
+  json += (record.pdVersions & (1 << 2)) ? "true" : "false";
+  json += ",\"pd3\":";
+  json += (record.pdVersions & (1 << 3)) ? "true" : "false";
+  json += ",\"reason\":\"";
+  json += record.reason < 3 ? kSessionEndReasons[record.reason] : "unknown";
+  return json + "\"}";
+}
+
+// State of a streamed /history response
+struct HistoryQueryState
+{
+  HistoryCursor cursor;
+  HistoryQuery query;
+  HistoryQueryMode mode;
+  uint32_t rows = 0;
+  bool started = false;
+  bool exhausted = false;
+  bool finished = false;
+  String pending;
+  size_t pendingPos = 0;
+
+  HistoryQueryState(uint32_t from, uint32_t to) : cursor(historyStore, from, to) {}
+};
+
+/**
+ * @brief GET /history?port=&from=&to=&points=&mode=minmax|lttb&series=voltage|current|power
+ *
+ * Downsamples one port of the stored history while the chunked response drains, so the
+ * response size follows `points` and not the length of the range. Times are Unix seconds,
+ * the default range is the last 24 hours.
+ */
+void handleHistoryQuery(AsyncWebServerRequest *request)
+{
+  uint32_t to = request->hasParam("to") ? strtoul(request->getParam("to")->value().c_str(), nullptr, 10) : time(nullptr);
+  uint32_t from = request->hasParam("from") ? strtoul(request->getParam("from")->value().c_str(), nullptr, 10) : to - 86400;
+  long port = request->hasParam("port") ? request->getParam("port")->value().toInt() : 0;
+  long points = request->hasParam("points") ? request->getParam("points")->value().toInt() : kHistoryQueryDefaultPoints;
+  if (from >= to || port < 0 || port >= kHistoryPorts || points < 1)
+  {
+    request->send(400, "application/json", "{\"status\":\"error\",\"message\":\"invalid range, port or points\"}");
+    return;
+  }
+
+  HistoryQueryMode mode = HISTORY_QUERY_MINMAX;
+  if (request->hasParam("mode") && request->getParam("mode")->value() == "lttb")
+  {
+    mode = HISTORY_QUERY_LTTB;
+  }
+  HistorySeries series = HISTORY_SERIES_POWER;
+  if (request->hasParam("series"))
+  {
+    String name = request->getParam("series")->value();
+    series = name == "voltage" ? HISTORY_SERIES_VOLTAGE : name == "current" ? HISTORY_SERIES_CURRENT : HISTORY_SERIES_POWER;
+  }
+
+  auto state = std::make_shared<HistoryQueryState>(from, to);
+  state->mode = mode;
+  state->query.begin(port, from, to, min(points, (long)kHistoryQueryMaxPoints), mode, series);
+
+  AsyncWebServerResponse *response = request->beginChunkedResponse("application/json", [state, port, from, to](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+    size_t written = 0;
+    uint16_t decoded = 0;
+    while (written < maxLen)
     {
-      logMessage("Failed to open file for writing");
-      request->send(500, "text/plain", "Failed to open file for writing");
-      return;
+      if (state->pendingPos >= state->pending.length())
+      {
+        if (state->finished)
+        {
+          break;
+        }
+
+        state->pending = "";
+        state->pendingPos = 0;
+        HistoryRow row;
+        if (!state->started)
+        {
+          state->started = true;
+          state->pending = "{\"port\":" + String(port);
+          state->pending += ",\"from\":" + String(from);
+          state->pending += ",\"to\":" + String(to);
+          state->pending += ",\"bucket\":" + String(state->query.bucketSeconds());
+          state->pending += state->mode == HISTORY_QUERY_LTTB
+                                ? ",\"mode\":\"lttb\",\"columns\":[\"t\",\"value\"],\"points\":["
+                                : ",\"mode\":\"minmax\",\"columns\":[\"t\",\"n\",\"vMin\",\"vAvg\",\"vMax\",\"iMin\",\"iAvg\",\"iMax\",\"pAvg\"],\"points\":[";
+        }
+        else if (state->query.pop(row))
+        {
+          state->pending = state->rows++ > 0 ? ",[" : "[";
+          state->pending += String(row.time);
+          if (state->mode == HISTORY_QUERY_MINMAX)
+          {
+            state->pending += "," + String(row.count);
+            state->pending += "," + String(row.voltageMin);
+            state->pending += "," + String(row.voltageAvg);
+            state->pending += "," + String(row.voltageMax);
+            state->pending += "," + String(row.currentMin);
+            state->pending += "," + String(row.currentAvg);
+            state->pending += "," + String(row.currentMax);
+          }
+          state->pending += "," + String(row.value) + "]";
+        }
+        else if (!state->exhausted)
+        {
+          // A wide bucket can take days of points, those are decoded over several callbacks
+          if (decoded++ == kHistoryPointsPerChunk)
+          {
+            // JSON allows whitespace here. RESPONSE_TRY_AGAIN would idle until the next TCP poll
+            if (written == 0)
+            {
+              buffer[written++] = ' ';
+            }
+            break;
+          }
+
+          // Feed points until the query has a row to emit
+          HistoryPoint point;
+          if (state->cursor.next(point))
+          {
+            state->query.add(point);
+          }
+          else
+          {
+            state->query.finish();
+            state->exhausted = true;
+          }
+        }
+        else
+        {
+          state->pending = "],\"count\":" + String(state->rows) + "}";
+          state->finished = true;
+        }
+        continue;
+      }
+
+      size_t length = min(maxLen - written, state->pending.length() - state->pendingPos);
+      memcpy(buffer + written, state->pending.c_str() + state->pendingPos, length);
+      state->pendingPos += length;
+      written += length;
     }
-  }
+    return written;
+  });
+  request->send(response);
+}
 
-  // Write the current chunk to the file
-  if (uploadFile)
+// State of a streamed /sessions response
+struct SessionListState
+{
+  uint32_t offset = 0;
+  uint32_t limit = kSessionPageDefault;
+  uint32_t total = 0;
+  uint32_t emitted = 0;
+  // Next index to read, and the id every emitted record has to stay below
+  uint32_t index = 0;
+  uint32_t below = UINT32_MAX;
+  bool started = false;
+  bool finished = false;
+  String pending;
+  size_t pendingPos = 0;
+};
+
+/**
+ * @brief GET /sessions?before=&offset=&limit= lists logged sessions newest first, plus the open ones.
+ *
+ * Records are read from flash one at a time while the chunked response drains. A session that
+ * closes meanwhile moves every index up by one, so a record is only emitted when its id is below
+ * the last one: ids only grow, and a record seen twice is skipped. For the next page pass the
+ * returned "next" as before=, offset= skips that many records more.
+ */
+void handleSessionList(AsyncWebServerRequest *request)
+{
+  auto state = std::make_shared<SessionListState>();
+  if (request->hasParam("offset"))
   {
-    uploadFile.write(data, len);
-    logMessage("Written " + String(len) + " bytes");
+    state->offset = max(request->getParam("offset")->value().toInt(), 0L);
   }
-  else
+  if (request->hasParam("limit"))
   {
-    logMessage("File not open during write");
+    state->limit = constrain(request->getParam("limit")->value().toInt(), 1, kSessionPageMax);
   }
+  state->total = sessionTracker.count();
 
-  if (final)
+  SessionRecord record;
+  if (request->hasParam("before"))
   {
-    // All chunks received
-    logMessage("Html upload complete");
-    if (uploadFile)
+    state->below = max(request->getParam("before")->value().toInt(), 0L);
+  }
+  else if (sessionTracker.read(0, record))
+  {
+    state->below = record.id + 1;
+  }
+  // Ids fall with the index, find the first record below the cursor
+  uint32_t low = 0;
+  uint32_t high = state->total;
+  while (low < high)
+  {
+    uint32_t middle = (low + high) / 2;
+    if (sessionTracker.read(middle, record) && record.id >= state->below)
+    {
+      low = middle + 1;
+    }
+    else
     {
-      uploadFile.close();
+      high = middle;
     }
   }
+  state->index = low + state->offset;
+
+  AsyncWebServerResponse *response = request->beginChunkedResponse("application/json", [state](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+    size_t written = 0;
+    while (written < maxLen)
+    {
+      if (state->pendingPos >= state->pending.length())
+      {
+        if (state->finished)
+        {
+          break;
+        }
+
+        state->pending = "";
+        state->pendingPos = 0;
+        SessionRecord record;
+        if (!state->started)
+        {
+          state->started = true;
+          uint32_t now = millis();
+          state->pending = "{\"active\":[";
+          bool first = true;
+          for (uint8_t i = 0; i < ports.size(); i++)
+          {
+            const ActiveSession &session = sessionTracker.active(i);
+            if (!session.open)
+            {
+              continue;
+            }
+            state->pending += first ? "{\"port\":" : ",{\"port\":";
+            first = false;
+            state->pending += String(i);
+            state->pending += ",\"start\":" + String(session.startTime);
+            state->pending += ",\"duration\":" + String((now - session.startMs) / 1000);
+            state->pending += ",\"energy\":" + String(session.energy, 3);
+            state->pending += ",\"peakPower\":" + String(session.peakPower, 2);
+            state->pending += ",\"protocols\":" + sessionProtocolsJson(session.protocols) + "}";
+          }
+          state->pending += "],\"sessions\":[";
+        }
+        else if (sessionTracker.read(state->index, record) && (record.id >= state->below || state->emitted < state->limit))
+        {
+          state->index++;
+          if (record.id >= state->below)
+          {
+            // Already emitted before a new session pushed it down
+            continue;
+          }
+          if (state->emitted > 0)
+          {
+            state->pending = ",";
+          }
+          state->pending += sessionRecordJson(record);
+          state->emitted++;
+          state->below = record.id;
+        }
+        else
+        {
+          // Stopped on a record past the page, or at the end of the log
+          bool more = state->emitted == state->limit && sessionTracker.read(state->index, record);
+          state->pending = "],\"offset\":" + String(state->offset);
+          state->pending += ",\"count\":" + String(state->emitted);
+          state->pending += ",\"total\":" + String(state->total);
+          state->pending += ",\"next\":" + String(state->below);
+          state->pending += ",\"more\":";
+          state->pending += more ? "true" : "false";
+          state->pending += "}";
+          state->finished = true;
+        }
+        continue;
+      }
+
+      size_t length = min(maxLen - written, state->pending.length() - state->pendingPos);
+      memcpy(buffer + written, state->pending.c_str() + state->pendingPos, length);
+      state->pendingPos += length;
+      written += length;
+    }
+    return written;
+  });
+  request->send(response);
 }
 
 File root = LittleFS.open("/*.emo", "r");
@@ -841,13 +1944,14 @@ bool drawFunnyEmotion()
     return false;
   }
 
-  static unsigned long lastDrawTime = 0;
-  if (millis() - lastDrawTime < 2000)
+  if (!emoticons->draw(&display, SCREEN_WIDTH, SCREEN_HEIGHT, PX_COLOR_WHITE, PX_COLOR_BLACK))
   {
-    return true;
+    return false;
   }
-  lastDrawTime = millis();
-  return emoticons->draw(&display, SCREEN_WIDTH, SCREEN_HEIGHT, PX_COLOR_WHITE, PX_COLOR_BLACK);
+  flushDisplay();
+
+  scenes.show(Scene::Emoticon, 2000);
+  return true;
 }
 
 unsigned long lastActivityTime = 0;
@@ -883,7 +1987,6 @@ void drawUpdateProgress()
     return;
   }
 
-  tcaselect(0);
   display.clearDisplay();
   display.setTextSize(1);
   display.setTextColor(PX_COLOR_WHITE);
@@ -892,11 +1995,16 @@ void drawUpdateProgress()
 
   if (isUpdateSuccess)
   {
+    if (scenes.isHolding())
+    {
+      return;
+    }
+
     display.println("Update successful!");
     display.println("Rebooting...");
-    display.display();
-    delay(2000);
-    ESP.restart();
+    flushDisplay();
+    scenes.show(Scene::OtaProgress, 2000, []
+                { ESP.restart(); });
     return;
   }
 
@@ -914,7 +2022,7 @@ void drawUpdateProgress()
 
   display.fillRect(progressX, progressY, progressWidth, progressHeight, PX_COLOR_BLACK);
   display.fillRect(progressX, progressY, progressValue, progressHeight, PX_COLOR_WHITE);
-  display.display();
+  flushDisplay();
 }
 
 void buildWelcome() {
@@ -923,62 +2031,159 @@ void buildWelcome() {
   display.setTextColor(PX_COLOR_WHITE);
   display.setCursor(4, 14);
   display.println("Hello from:\n NguyenHungA5!!!"); // I hope you keep this message ^^!!
-  display.display();
-  delay(2000);
+  flushDisplay();
+  scenes.show(Scene::Welcome, 2000);
 }
 
-void handleFileList(AsyncWebServerRequest *request) {
-  String path = "/";
-  if (request->hasParam("dir")) {
-    path = request->getParam("dir")->value();
-  }
+// State of a streamed /list response, kept alive by the chunked response filler
+struct FileListState
+{
+  String base;
+  std::vector<Dir> dirs;
+  std::vector<String> prefixes;
+  String ext;
+  size_t offset = 0;
+  size_t limit = kFileListDefaultLimit;
+  size_t matched = 0;
+  size_t emitted = 0;
+  bool more = false;
+  bool started = false;
+  bool finished = false;
+  String pending;
+  size_t pendingPos = 0;
+};
+
+// Advance to the next matching entry and append it to state.pending, false when the listing is exhausted
+bool nextFileListEntry(FileListState &state)
+{
+  while (!state.dirs.empty())
+  {
+    // By index, the push_back below may move the vector and a reference would dangle
+    size_t current = state.dirs.size() - 1;
+    if (!state.dirs[current].next())
+    {
+      state.dirs.pop_back();
+      state.prefixes.pop_back();
+      continue;
+    }
+
+    String name = state.prefixes[current] + state.dirs[current].fileName();
+    bool isDir = state.dirs[current].isDirectory();
+    if (isDir && state.dirs.size() < kFileListMaxDepth)
+    {
+      state.dirs.push_back(LittleFS.openDir(state.base + name));
+      state.prefixes.push_back(name + "/");
+    }
 
-  Dir dir = LittleFS.openDir(path);
-  String output = "[";
-  String fileName = "";
-  while (dir.next()) {
-    File entry = dir.openFile("r");
-    fileName = String(entry.name());
-    if (fileName == "config.json") {
+    if (name == "config.json")
+    {
       continue;
     }
 
-    if (output != "[")
+    if (state.ext.length() > 0 && (isDir || !name.endsWith("." + state.ext)))
     {
-      output += ',';
+      continue;
     }
-    bool isDir = false;
-    output += "{\"type\":\"";
-    output += (isDir) ? "dir" : "file";
-    output += "\",\"name\":\"";
-    output += fileName;
-    output += "\"}";
-    entry.close();
-  }
-  output += "]";
-  request->send(200, "application/json", output);
-}
 
-void handleFileUpload(AsyncWebServerRequest *request, String filename, size_t index, uint8_t *data, size_t len, bool final) {
-  if (!index) {
-    if (!filename.startsWith("/")) {
-      filename = "/" + filename;
+    if (state.matched++ < state.offset)
+    {
+      continue;
+    }
+
+    if (state.emitted == state.limit)
+    {
+      // One entry past the page proves there is another page
+      state.more = true;
+      state.dirs.clear();
+      state.prefixes.clear();
+      return false;
     }
 
-    if (LittleFS.exists(filename))
+    if (state.emitted > 0)
     {
-      LittleFS.remove(filename); // Remove the existing file if it exists
+      state.pending += ',';
     }
+    state.emitted++;
+    state.pending += "{\"type\":\"";
+    state.pending += isDir ? "dir" : "file";
+    state.pending += "\",\"name\":\"";
+    state.pending += name;
+    state.pending += "\",\"size\":";
+    state.pending += String(isDir ? 0 : state.dirs[current].fileSize());
+    state.pending += "}";
+    return true;
+  }
 
-    request->_tempFile = LittleFS.open(filename, "w");
+  return false;
+}
+
+void handleFileList(AsyncWebServerRequest *request) {
+  auto state = std::make_shared<FileListState>();
+  String path = "/";
+  if (request->hasParam("dir")) {
+    path = request->getParam("dir")->value();
+  }
+  // toInt() gives 0 or a negative number for junk, which must not wrap around in size_t
+  if (request->hasParam("offset")) {
+    state->offset = max(request->getParam("offset")->value().toInt(), 0L);
   }
-  if (len) {
-    request->_tempFile.write(data, len);
+  if (request->hasParam("limit")) {
+    state->limit = constrain(request->getParam("limit")->value().toInt(), 1, kFileListMaxLimit);
   }
-  if (final) {
-    request->_tempFile.close();
-    request->send(200, "text/plain", "File Uploaded!");
+  if (request->hasParam("ext")) {
+    state->ext = request->getParam("ext")->value();
   }
+
+  // Names are reported relative to the listed directory, like before
+  state->base = path.endsWith("/") ? path : path + "/";
+  state->dirs.push_back(LittleFS.openDir(path));
+  state->prefixes.push_back("");
+
+  AsyncWebServerResponse *response = request->beginChunkedResponse("application/json", [state](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+    size_t written = 0;
+    while (written < maxLen)
+    {
+      if (state->pendingPos >= state->pending.length())
+      {
+        if (state->finished)
+        {
+          break;
+        }
+
+        state->pending = "";
+        state->pendingPos = 0;
+        if (!state->started)
+        {
+          state->started = true;
+          state->pending = "{\"files\":[";
+        }
+        else if (!nextFileListEntry(*state))
+        {
+          FSInfo info;
+          LittleFS.info(info);
+          state->pending = "],\"offset\":" + String(state->offset);
+          state->pending += ",\"count\":" + String(state->emitted);
+          state->pending += ",\"more\":";
+          state->pending += state->more ? "true" : "false";
+          state->pending += ",\"totalBytes\":" + String(info.totalBytes);
+          state->pending += ",\"usedBytes\":" + String(info.usedBytes) + "}";
+          state->finished = true;
+        }
+        continue;
+      }
+
+      size_t length = min(maxLen - written, state->pending.length() - state->pendingPos);
+      memcpy(buffer + written, state->pending.c_str() + state->pendingPos, length);
+      state->pendingPos += length;
+      written += length;
+    }
+    return written;
+  });
+  request->send(response);
+}
+
+void handleFileUpload(AsyncWebServerRequest *request, String filename, size_t index, uint8_t *data, size_t len, bool final) {
+  uploadSink.handleChunk(request, filename, index, data, len, final);
 }
 
 void handleFileDelete(AsyncWebServerRequest *request) {
@@ -1056,7 +2261,7 @@ void handleGetFileRequest(AsyncWebServerRequest *request) {
 void setupFileManagement() {
   server->on("/list", HTTP_GET, handleFileList);
   server->on("/upload", HTTP_POST, [](AsyncWebServerRequest *request) {
-    request->send(200);
+    uploadSink.sendResult(request, "File Uploaded!");
   }, handleFileUpload);
   server->on("/delete", HTTP_POST, handleFileDelete);
   server->on("/create", HTTP_POST, handleFileCreate);
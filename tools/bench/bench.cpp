@@ -0,0 +1,488 @@
+// Host timings for the code that runs on every sample, render and request on the device.
+//
+//   ./firmware_bench                                 print a table
+//   ./firmware_bench --out results.json              also write machine-readable results
+//   ./firmware_bench --baseline baseline.json        exit 1 when a benchmark is slower than its
+//                                                    baseline by more than --tolerance percent
+//   ./firmware_bench --write-baseline baseline.json  store this run as the new baseline
+//   ./firmware_bench --filter sw35xx                 only names containing the text
+//
+// Every benchmark runs in batches of at least --min-batch-ms, the reported time per operation is
+// the median of --repeats batches. The firmware sources are compiled unchanged against the stubs
+// in stubs/: flash, the bus and the display are RAM fakes, so the numbers are CPU cost only and
+// only comparable with a baseline taken on the same machine.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <Wire.h>
+#include <h1_SW35xx.h>
+
+#include "Emoticons.hpp"
+#include "InfoPage.h"
+#include "Thermistor.h"
+#ifdef BENCH_JSON
+#include "Config.h"
+#include "MonitorJson.h"
+#endif
+
+namespace
+{
+
+constexpr int kScreenWidth = 128;
+constexpr int kScreenHeight = 64;
+
+struct Benchmark
+{
+    std::string name;
+    std::function<void()> run;
+    bool json = false; // Built only with JSON=1
+};
+
+struct Result
+{
+    std::string name;
+    double nsPerOp;
+    uint64_t iterations;
+};
+
+struct Options
+{
+    std::string out;
+    std::string baseline;
+    std::string writeBaseline;
+    std::string filter;
+    double tolerance = 25;
+    int repeats = 7;
+    int minBatchMs = 20;
+};
+
+// Keeps results alive so the optimizer cannot drop the work
+volatile uint32_t sink = 0;
+
+double nowNs()
+{
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+Result measure(const Benchmark &benchmark, const Options &options)
+{
+    // Grow the batch until it is long enough to time reliably
+    uint64_t batch = 1;
+    double elapsed = 0;
+    while (true)
+    {
+        double start = nowNs();
+        for (uint64_t i = 0; i < batch; i++)
+        {
+            benchmark.run();
+        }
+        elapsed = nowNs() - start;
+        if (elapsed >= options.minBatchMs * 1e6 || batch >= (1ull << 32))
+        {
+            break;
+        }
+        batch *= elapsed < options.minBatchMs * 1e5 ? 10 : 2;
+    }
+
+    std::vector<double> samples;
+    for (int r = 0; r < options.repeats; r++)
+    {
+        double start = nowNs();
+        for (uint64_t i = 0; i < batch; i++)
+        {
+            benchmark.run();
+        }
+        samples.push_back((nowNs() - start) / batch);
+    }
+    std::sort(samples.begin(), samples.end());
+    return {benchmark.name, samples[samples.size() / 2], batch * options.repeats};
+}
+
+// Flat {"name": nsPerOp, ...} object as written by --write-baseline, plus kJsonKey
+std::map<std::string, double> readBaseline(const std::string &path)
+{
+    std::map<std::string, double> baseline;
+    std::ifstream in(path);
+    if (!in)
+    {
+        fprintf(stderr, "cannot read %s\n", path.c_str());
+        exit(2);
+    }
+    std::stringstream buffer;
+    buffer << in.rdbuf();
+    std::string text = buffer.str();
+
+    size_t position = 0;
+    while ((position = text.find('"', position)) != std::string::npos)
+    {
+        size_t end = text.find('"', position + 1);
+        if (end == std::string::npos)
+        {
+            break;
+        }
+        std::string key = text.substr(position + 1, end - position - 1);
+        size_t colon = text.find(':', end);
+        if (colon == std::string::npos)
+        {
+            break;
+        }
+        baseline[key] = strtod(text.c_str() + colon + 1, nullptr);
+        position = text.find_first_of(",}", colon);
+    }
+    return baseline;
+}
+
+// Whether the run that wrote the baseline had the JSON benchmarks, a baseline taken with JSON=0
+// cannot have their entries and a check run with JSON=1 only reports them
+const char *const kJsonKey = "_json-benchmarks";
+
+void writeBaseline(const std::string &path, const std::vector<Result> &results)
+{
+    FILE *out = fopen(path.c_str(), "w");
+    if (!out)
+    {
+        fprintf(stderr, "cannot write %s\n", path.c_str());
+        exit(2);
+    }
+    fprintf(out, "{\n");
+    for (const Result &result : results)
+    {
+        fprintf(out, "  \"%s\": %.1f,\n", result.name.c_str(), result.nsPerOp);
+    }
+#ifdef BENCH_JSON
+    fprintf(out, "  \"%s\": 1\n}\n", kJsonKey);
+#else
+    fprintf(out, "  \"%s\": 0\n}\n", kJsonKey);
+#endif
+    fclose(out);
+}
+
+void writeResults(const std::string &path, const std::vector<Result> &results, const std::map<std::string, double> &baseline)
+{
+    FILE *out = fopen(path.c_str(), "w");
+    if (!out)
+    {
+        fprintf(stderr, "cannot write %s\n", path.c_str());
+        exit(2);
+    }
+    fprintf(out, "{\n  \"benchmarks\": [\n");
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const Result &result = results[i];
+        fprintf(out, "    {\"name\": \"%s\", \"nsPerOp\": %.1f, \"iterations\": %llu", result.name.c_str(), result.nsPerOp,
+                (unsigned long long)result.iterations);
+        auto it = baseline.find(result.name);
+        if (it != baseline.end())
+        {
+            fprintf(out, ", \"baselineNsPerOp\": %.1f", it->second);
+        }
+        fprintf(out, "}%s\n", i + 1 < results.size() ? "," : "");
+    }
+    fprintf(out, "  ]\n}\n");
+    fclose(out);
+}
+
+// Registers a SW35xx would return while charging at 20 V, 2.5 A over PD 3.0
+void loadChargingRegisters(TwoWire &bus)
+{
+    memset(bus.registers, 0, sizeof(bus.registers));
+    uint16_t vin = 20500 / 10;
+    uint16_t vout = 20000 / 6;
+    uint16_t iout = 2500 * 2 / 5;
+    bus.registers[0x30] = vin >> 4;
+    bus.registers[0x31] = vout >> 4;
+    bus.registers[0x32] = ((vin & 0x0F) << 4) | (vout & 0x0F);
+    bus.registers[0x33] = iout >> 4;
+    bus.registers[0x34] = 0;
+    bus.registers[0x35] = (iout & 0x0F) << 4;
+    bus.registers[0x06] = 0x20 | 5; // PD 3.0, PD_FIX
+}
+
+std::vector<Benchmark> makeBenchmarks()
+{
+    std::vector<Benchmark> benchmarks;
+
+#ifdef BENCH_JSON
+    static MonitorSnapshot snapshot;
+    memset(&snapshot, 0, sizeof(snapshot));
+    for (uint8_t i = 0; i < kSnapshotPorts; i++)
+    {
+        PortSnapshot &port = snapshot.ports[i];
+        port.voltage = 20.01f - i;
+        port.current = 2.345f;
+        port.inputVoltage = 20.5f;
+        port.power = port.voltage * port.current;
+        port.energy = 1234.5f + i;
+        port.active = i < 3;
+        port.valid = true;
+        port.health = 100;
+        strcpy(port.protocol, "PD3.0 PPS");
+    }
+    snapshot.generation = 123456;
+    snapshot.moduleTemperature = 41.3f;
+    snapshot.inputVoltage = 20.5f;
+    snapshot.fanSpeed = 120;
+    snapshot.state = true;
+
+    benchmarks.push_back({"monitor-json", []
+                          {
+                              String response;
+                              writeMonitorJson(snapshot, response);
+                              sink += response.length();
+                          },
+                          true});
+#endif
+
+    // The TextLayer primitives under every page: one port line of text and values, and an
+    // 86 column marquee window advancing one glyph per frame
+    static Adafruit_SH1106G display(kScreenWidth, kScreenHeight);
+    static GlyphAtlas glyphs;
+    static TextStrip marquee;
+    static uint16_t marqueeOffset = 0;
+    glyphs.begin();
+    marquee.setText(glyphs, "SW3518X 1.1 by NguyenHungA5 IP: 192.168.100.123    ");
+    benchmarks.push_back({"text-draw", []
+                          {
+                              FrameBuffer frame = {display.getBuffer(), kScreenWidth, kScreenHeight};
+                              glyphs.draw(frame, 0, 18, "P1");
+                              glyphs.drawValue(frame, 18, 18, 20.0f, 'V');
+                              glyphs.drawValue(frame, 55, 18, 2.34f, 'A');
+                              glyphs.drawValue(frame, 90, 18, 46.8f, 'W');
+                              sink += display.getBuffer()[300];
+                          }});
+    benchmarks.push_back({"text-marquee", []
+                          {
+                              FrameBuffer frame = {display.getBuffer(), kScreenWidth, kScreenHeight};
+                              marquee.blit(frame, 0, 4, 86, marqueeOffset);
+                              marqueeOffset = (marqueeOffset + kGlyphWidth) % marquee.width();
+                              sink += display.getBuffer()[40];
+                          }});
+
+    // The frame displayInfo() composes: header marquee, temperature, separator and a line per
+    // port. Three ports charge, one with a protocol long enough to scroll on the second page.
+    static InfoPage infoPage;
+    static PortItem pagePorts[4];
+    infoPage.begin();
+    infoPage.setHeader("SW3518X 1.1 by NguyenHungA5 IP: 192.168.100.123 | http://sw351xmonitor-14968829.local");
+    for (int i = 0; i < 4; i++)
+    {
+        pagePorts[i].isActive = i < 3;
+        pagePorts[i].voltage = 20.0f - i;
+        pagePorts[i].current = 2.34f;
+        pagePorts[i].inputVoltage = 20.5f;
+        pagePorts[i].protocol = i == 0 ? "PD3.0 PPS" : "QC3.0";
+    }
+    benchmarks.push_back({"display-page", []
+                          {
+                              display.clearDisplay();
+                              FrameBuffer frame = {display.getBuffer(), kScreenWidth, kScreenHeight};
+                              infoPage.drawHeader(frame, 41.3f);
+                              for (int i = 0; i < 4; i++)
+                              {
+                                  infoPage.drawPort(frame, i, pagePorts[i]);
+                              }
+                              sink += display.getBuffer()[200];
+                          }});
+
+    static std::unique_ptr<Emoticons> emoticons;
+    auto emoticon = std::make_shared<std::vector<uint8_t>>(kScreenWidth * kScreenHeight / 8);
+    for (size_t i = 0; i < emoticon->size(); i++)
+    {
+        (*emoticon)[i] = (uint8_t)(i * 37);
+    }
+    LittleFS.files["/smile.emo"] = emoticon;
+    emoticons.reset(new Emoticons());
+    benchmarks.push_back({"emoticon-draw", []
+                          {
+                              sink += emoticons->draw(&display, kScreenWidth, kScreenHeight, SH110X_WHITE, SH110X_BLACK);
+                          }});
+
+    // One "ntc" tick and one "temperature" tick, over a noisy reading around 40 C
+    static Thermistor thermistor;
+    static const int adc[] = {180, 183, 179, 240, 181, 182, 178, 184};
+    hostAnalogSequence(adc, sizeof(adc) / sizeof(adc[0]));
+    benchmarks.push_back({"thermistor", []
+                          {
+                              thermistor.sample();
+                              float celsius = thermistor.temperature();
+                              sink += (uint32_t)celsius;
+                          }});
+
+#ifdef BENCH_JSON
+    static std::unique_ptr<Config> config;
+    config.reset(new Config());
+    config->mqttHost = "homeassistant.local";
+    config->udpAddress = "239.1.2.3";
+    config->saveConfig();
+    benchmarks.push_back({"config-save", []
+                          {
+                              config->updateTotalEnergy(0.001f, 0);
+                              config->saveConfig();
+                          },
+                          true});
+    benchmarks.push_back({"config-load", []
+                          {
+                              sink += config->loadConfig();
+                          },
+                          true});
+#endif
+
+    static h1_SW35xx::SW35xx charger(Wire);
+    loadChargingRegisters(Wire);
+    benchmarks.push_back({"sw35xx-read-status", []
+                          {
+                              charger.readStatus(false);
+                              sink += charger.vout_mV + charger.iout_usbc_mA;
+                          }});
+
+    // Power budget refresh of all four ports where nothing changed, served from the shadow
+    static h1_SW35xx::SW35xx budgets[4] = {Wire, Wire, Wire, Wire};
+    benchmarks.push_back({"sw35xx-apply-budget", []
+                          {
+                              for (h1_SW35xx::SW35xx &port : budgets)
+                              {
+                                  port.beginConfig();
+                                  port.setMaxCurrentsFixed(3000, 3000, 3000, 3000, 2250);
+                                  port.setMaxCurrentsPPS(3000, 2250);
+                                  sink += port.endConfig();
+                              }
+                          }});
+
+    return benchmarks;
+}
+
+void usage()
+{
+    fprintf(stderr, "usage: firmware_bench [--out file] [--baseline file] [--tolerance percent] [--write-baseline file]\n"
+                    "                      [--filter text] [--repeats n] [--min-batch-ms n]\n");
+    exit(2);
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    Options options;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        auto value = [&]() -> std::string
+        {
+            if (i + 1 >= argc)
+            {
+                usage();
+            }
+            return argv[++i];
+        };
+
+        if (arg == "--out")
+        {
+            options.out = value();
+        }
+        else if (arg == "--baseline")
+        {
+            options.baseline = value();
+        }
+        else if (arg == "--write-baseline")
+        {
+            options.writeBaseline = value();
+        }
+        else if (arg == "--tolerance")
+        {
+            options.tolerance = atof(value().c_str());
+        }
+        else if (arg == "--filter")
+        {
+            options.filter = value();
+        }
+        else if (arg == "--repeats")
+        {
+            options.repeats = std::max(1, atoi(value().c_str()));
+        }
+        else if (arg == "--min-batch-ms")
+        {
+            options.minBatchMs = std::max(1, atoi(value().c_str()));
+        }
+        else
+        {
+            usage();
+        }
+    }
+
+    std::map<std::string, double> baseline;
+    if (!options.baseline.empty())
+    {
+        baseline = readBaseline(options.baseline);
+    }
+
+    std::vector<Result> results;
+    int regressions = 0;
+    int unchecked = 0;
+    printf("%-22s %12s %12s %8s\n", "benchmark", "ns/op", "baseline", "change");
+    for (const Benchmark &benchmark : makeBenchmarks())
+    {
+        if (!options.filter.empty() && benchmark.name.find(options.filter) == std::string::npos)
+        {
+            continue;
+        }
+
+        Result result = measure(benchmark, options);
+        results.push_back(result);
+
+        auto it = baseline.find(result.name);
+        if (it == baseline.end() || it->second <= 0)
+        {
+            // A benchmark nobody compares against is not checked, so that fails a check run unless
+            // the baseline was written by a build that did not have it
+            bool missing = !options.baseline.empty();
+            bool neverRun = benchmark.json && baseline.count(kJsonKey) && baseline[kJsonKey] == 0;
+            unchecked += missing && !neverRun;
+            printf("%-22s %12.1f %12s %8s%s\n", result.name.c_str(), result.nsPerOp, "-", "",
+                   !missing ? "" : neverRun ? "  NO BASELINE (baseline taken with JSON=0)" : "  NO BASELINE");
+            continue;
+        }
+
+        double change = (result.nsPerOp / it->second - 1) * 100;
+        bool regressed = change > options.tolerance;
+        regressions += regressed;
+        printf("%-22s %12.1f %12.1f %+7.1f%%%s\n", result.name.c_str(), result.nsPerOp, it->second, change, regressed ? "  REGRESSED" : "");
+    }
+#ifndef BENCH_JSON
+    printf("monitor-json, config-save and config-load were left out (JSON=0)\n");
+#endif
+
+    if (!options.out.empty())
+    {
+        writeResults(options.out, results, baseline);
+    }
+    if (!options.writeBaseline.empty())
+    {
+        writeBaseline(options.writeBaseline, results);
+    }
+
+    if (unchecked > 0)
+    {
+        fprintf(stderr, "%d benchmark(s) missing from %s, run `make baseline`\n", unchecked, options.baseline.c_str());
+    }
+    if (regressions > 0)
+    {
+        fprintf(stderr, "%d benchmark(s) slower than baseline by more than %.0f%%\n", regressions, options.tolerance);
+    }
+    if (regressions > 0 || unchecked > 0)
+    {
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,144 @@
+// Stress test of SnapshotBuffer: one writer publishes as fast as it can while readers copy.
+//
+//   make test
+//
+// Every published MonitorSnapshot is stamped from a single sequence number, in the generation,
+// in every float and in the protocol strings, so a copy that mixes two publishes is caught by
+// comparing its fields. Readers also check that the generations they see never go backwards.
+// Stamping is kept cheap so the writer laps the readers often: with the generation recheck in
+// read() removed, every run reports torn copies. On the device the writer is the sample path
+// and the readers are async web handlers, which interleave far less than host threads.
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "PortSnapshot.h"
+
+namespace
+{
+
+constexpr int kReaders = 3;
+constexpr auto kDuration = std::chrono::milliseconds(1500);
+
+SnapshotBuffer<MonitorSnapshot> buffer;
+std::atomic<bool> running{true};
+
+void stamp(MonitorSnapshot &snapshot, uint32_t sequence)
+{
+    memset(&snapshot, 0, sizeof(snapshot));
+    snapshot.generation = sequence;
+    snapshot.uptimeMs = sequence;
+    for (PortSnapshot &port : snapshot.ports)
+    {
+        port.voltage = sequence;
+        port.current = sequence;
+        port.inputVoltage = sequence;
+        port.temperature = sequence;
+        port.power = sequence;
+        port.energy = sequence;
+        port.fastChargeType = sequence & 0xFF;
+        port.pdVersion = sequence & 0xFF;
+        port.active = sequence & 1;
+        port.valid = sequence & 2;
+        port.breaker = sequence & 0xFF;
+        port.health = sequence & 0xFF;
+        memset(port.protocol, 'A' + sequence % 26, sizeof(port.protocol) - 1);
+    }
+    snapshot.moduleTemperature = sequence;
+    snapshot.inputVoltage = sequence;
+    snapshot.fanSpeed = sequence;
+    snapshot.state = sequence & 1;
+}
+
+// True if every field carries the same sequence number as the first one
+bool consistent(const MonitorSnapshot &snapshot)
+{
+    MonitorSnapshot expected;
+    stamp(expected, snapshot.generation);
+    return memcmp(&expected, &snapshot, sizeof(snapshot)) == 0;
+}
+
+struct ReaderStats
+{
+    uint64_t reads = 0;
+    uint64_t failed = 0;
+    uint64_t torn = 0;
+    uint64_t backwards = 0;
+};
+
+void reader(ReaderStats &stats)
+{
+    MonitorSnapshot copy;
+    uint32_t last = 0;
+    while (running.load(std::memory_order_relaxed))
+    {
+        if (!buffer.read(copy))
+        {
+            stats.failed++;
+            continue;
+        }
+        stats.reads++;
+        if (!consistent(copy))
+        {
+            stats.torn++;
+        }
+        if (copy.generation < last)
+        {
+            stats.backwards++;
+        }
+        last = copy.generation;
+    }
+}
+
+} // namespace
+
+int main()
+{
+    // The snapshot generation follows the buffer's own, as publishSnapshot() does in the firmware
+    MonitorSnapshot snapshot;
+    stamp(snapshot, 1);
+    buffer.publish(snapshot);
+
+    std::vector<ReaderStats> stats(kReaders);
+    std::vector<std::thread> readers;
+    for (int i = 0; i < kReaders; i++)
+    {
+        readers.emplace_back(reader, std::ref(stats[i]));
+    }
+
+    uint32_t published = 1;
+    auto end = std::chrono::steady_clock::now() + kDuration;
+    while (std::chrono::steady_clock::now() < end)
+    {
+        for (int i = 0; i < 1000; i++)
+        {
+            stamp(snapshot, buffer.published() + 1);
+            buffer.publish(snapshot);
+            published++;
+        }
+    }
+    running = false;
+    for (std::thread &thread : readers)
+    {
+        thread.join();
+    }
+
+    ReaderStats total;
+    for (const ReaderStats &reader : stats)
+    {
+        total.reads += reader.reads;
+        total.failed += reader.failed;
+        total.torn += reader.torn;
+        total.backwards += reader.backwards;
+    }
+
+    bool ok = total.torn == 0 && total.backwards == 0 && total.reads > 0;
+    printf("%-4s snapshot buffer              %u publishes, %llu reads, %llu gave up, %llu torn, %llu backwards\n",
+           ok ? "ok" : "FAIL", published, (unsigned long long)total.reads, (unsigned long long)total.failed,
+           (unsigned long long)total.torn, (unsigned long long)total.backwards);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,47 @@
+#pragma once
+// Only the pixel path is real; glyph shapes are a placeholder pattern, the atlas is built
+// once and benchmarks only time the column copies done with it
+#include <Arduino.h>
+
+class Adafruit_GFX
+{
+public:
+    Adafruit_GFX(int16_t width, int16_t height) : _width(width), _height(height) {}
+    virtual ~Adafruit_GFX() {}
+    virtual void drawPixel(int16_t x, int16_t y, uint16_t color) = 0;
+
+    void drawChar(int16_t x, int16_t y, unsigned char c, uint16_t color, uint16_t bg, uint8_t)
+    {
+        for (int16_t i = 0; i < 6; i++)
+        {
+            for (int16_t j = 0; j < 8; j++)
+            {
+                bool on = i < 5 && j < 7 && ((c >> ((i + j) % 7)) & 1);
+                drawPixel(x + i, y + j, on ? color : bg);
+            }
+        }
+    }
+
+    void drawFastHLine(int16_t x, int16_t y, int16_t width, uint16_t color)
+    {
+        for (int16_t i = 0; i < width; i++)
+        {
+            drawPixel(x + i, y, color);
+        }
+    }
+
+    void fillRect(int16_t x, int16_t y, int16_t width, int16_t height, uint16_t color)
+    {
+        for (int16_t j = 0; j < height; j++)
+        {
+            drawFastHLine(x, y + j, width, color);
+        }
+    }
+
+    int16_t width() const { return _width; }
+    int16_t height() const { return _height; }
+
+protected:
+    int16_t _width;
+    int16_t _height;
+};
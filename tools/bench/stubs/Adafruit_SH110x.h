@@ -0,0 +1,39 @@
+#pragma once
+// Frame buffer only, display() counts flushes instead of writing the bus
+#include <Adafruit_GFX.h>
+#include <vector>
+
+#define SH110X_WHITE 1
+#define SH110X_BLACK 0
+
+class Adafruit_SH1106G : public Adafruit_GFX
+{
+public:
+    Adafruit_SH1106G(int16_t width, int16_t height) : Adafruit_GFX(width, height), buffer(width * height / 8) {}
+
+    void drawPixel(int16_t x, int16_t y, uint16_t color) override
+    {
+        if (x < 0 || x >= _width || y < 0 || y >= _height)
+        {
+            return;
+        }
+        uint8_t &cell = buffer[x + (y / 8) * _width];
+        if (color)
+        {
+            cell |= 1 << (y & 7);
+        }
+        else
+        {
+            cell &= ~(1 << (y & 7));
+        }
+    }
+
+    void clearDisplay() { std::fill(buffer.begin(), buffer.end(), 0); }
+    void display() { flushes++; }
+    uint8_t *getBuffer() { return buffer.data(); }
+
+    uint32_t flushes = 0;
+
+private:
+    std::vector<uint8_t> buffer;
+};
@@ -0,0 +1,227 @@
+#pragma once
+// Host stand-ins for the parts of the Arduino core the benchmarked modules use.
+// Timing, flash and the bus are fake; only CPU work is meant to be measured.
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+#include <algorithm>
+#include <string>
+
+using std::max;
+using std::min;
+
+#define PROGMEM
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#define pgm_read_word(addr) (*(const uint16_t *)(addr))
+#define pgm_read_dword(addr) (*(const uint32_t *)(addr))
+#define memcpy_P memcpy
+#define F(text) (text)
+
+#define INPUT 0
+#define OUTPUT 1
+#define HIGH 1
+#define LOW 0
+#define A0 17
+#define LED_BUILTIN 2
+
+typedef unsigned int uint;
+
+uint32_t millis();
+uint32_t micros();
+void delay(uint32_t ms);
+void yield();
+void pinMode(uint8_t pin, uint8_t mode);
+int digitalRead(uint8_t pin);
+void digitalWrite(uint8_t pin, uint8_t value);
+void analogWrite(uint8_t pin, int value);
+// Returns the values queued with hostAnalogSequence(), cycling
+int analogRead(uint8_t pin);
+void hostAnalogSequence(const int *values, size_t count);
+long random(long howbig);
+long random(long howsmall, long howbig);
+char *dtostrf(double value, signed char width, unsigned char precision, char *buffer);
+
+#if defined(__GLIBC__) && (__GLIBC__ < 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ < 38))
+// Part of the ESP8266 libc, glibc only has it since 2.38
+inline size_t strlcpy(char *destination, const char *source, size_t size)
+{
+    size_t length = strlen(source);
+    if (size > 0)
+    {
+        size_t count = std::min(length, size - 1);
+        memcpy(destination, source, count);
+        destination[count] = '\0';
+    }
+    return length;
+}
+#endif
+
+class String
+{
+public:
+    String() {}
+    String(const char *text) : s(text ? text : "") {}
+    String(const std::string &text) : s(text) {}
+    String(char c) : s(1, c) {}
+    String(int v) : s(std::to_string(v)) {}
+    String(unsigned int v) : s(std::to_string(v)) {}
+    String(long v) : s(std::to_string(v)) {}
+    String(unsigned long v) : s(std::to_string(v)) {}
+    String(double v, unsigned char decimals = 2)
+    {
+        char buffer[48];
+        snprintf(buffer, sizeof(buffer), "%.*f", decimals, v);
+        s = buffer;
+    }
+    String(float v, unsigned char decimals = 2) : String((double)v, decimals) {}
+
+    const char *c_str() const { return s.c_str(); }
+    unsigned int length() const { return s.size(); }
+    bool reserve(unsigned int size)
+    {
+        s.reserve(size);
+        return true;
+    }
+    bool concat(const char *text)
+    {
+        s += text ? text : "";
+        return true;
+    }
+    bool concat(const char *text, unsigned int length)
+    {
+        s.append(text, length);
+        return true;
+    }
+    bool concat(char c)
+    {
+        s += c;
+        return true;
+    }
+    bool startsWith(const String &prefix) const { return s.compare(0, prefix.s.size(), prefix.s) == 0; }
+    bool endsWith(const String &suffix) const
+    {
+        return s.size() >= suffix.s.size() && s.compare(s.size() - suffix.s.size(), suffix.s.size(), suffix.s) == 0;
+    }
+    int indexOf(char c, unsigned int from = 0) const
+    {
+        size_t position = s.find(c, from);
+        return position == std::string::npos ? -1 : (int)position;
+    }
+    String substring(unsigned int from, unsigned int to = (unsigned int)-1) const
+    {
+        return String(s.substr(from, to == (unsigned int)-1 ? std::string::npos : to - from));
+    }
+    void toLowerCase()
+    {
+        for (char &c : s)
+        {
+            c = tolower(c);
+        }
+    }
+    long toInt() const { return atol(s.c_str()); }
+    float toFloat() const { return atof(s.c_str()); }
+    char operator[](unsigned int index) const { return s[index]; }
+
+    String &operator+=(const String &other)
+    {
+        s += other.s;
+        return *this;
+    }
+    String &operator+=(const char *other)
+    {
+        s += other;
+        return *this;
+    }
+    String &operator+=(char c)
+    {
+        s += c;
+        return *this;
+    }
+    bool operator==(const String &other) const { return s == other.s; }
+    bool operator==(const char *other) const { return s == other; }
+    bool operator!=(const String &other) const { return s != other.s; }
+    bool operator<(const String &other) const { return s < other.s; }
+
+    std::string s;
+};
+
+// ArduinoJson recognises Arduino strings by this type as well
+class StringSumHelper : public String
+{
+public:
+    using String::String;
+    StringSumHelper(const String &other) : String(other) {}
+};
+
+inline StringSumHelper operator+(const String &a, const String &b) { return StringSumHelper(a.s + b.s); }
+inline StringSumHelper operator+(const String &a, const char *b) { return StringSumHelper(a.s + b); }
+inline StringSumHelper operator+(const char *a, const String &b) { return StringSumHelper(a + b.s); }
+
+class Print
+{
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t *buffer, size_t size)
+    {
+        size_t written = 0;
+        while (size--)
+        {
+            written += write(*buffer++);
+        }
+        return written;
+    }
+    size_t print(const char *text) { return write((const uint8_t *)text, strlen(text)); }
+    size_t print(const String &text) { return print(text.c_str()); }
+    size_t print(long value, int base = 10)
+    {
+        char buffer[24];
+        snprintf(buffer, sizeof(buffer), base == 16 ? "%lX" : "%ld", value);
+        return print(buffer);
+    }
+    size_t println(const char *text = "") { return print(text) + print("\n"); }
+    size_t println(const String &text) { return println(text.c_str()); }
+    size_t println(long value, int base = 10) { return print(value, base) + print("\n"); }
+};
+
+class Stream : public Print
+{
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual size_t readBytes(char *buffer, size_t length)
+    {
+        size_t count = 0;
+        int c;
+        while (count < length && (c = read()) >= 0)
+        {
+            buffer[count++] = (char)c;
+        }
+        return count;
+    }
+};
+
+class HardwareSerial : public Stream
+{
+public:
+    void begin(unsigned long) {}
+    size_t write(uint8_t) override { return 1; }
+    size_t write(const uint8_t *, size_t size) override { return size; }
+    int available() override { return 0; }
+    int read() override { return -1; }
+};
+extern HardwareSerial Serial;
+
+// A fixed 40000 unless a test defines its own to follow its allocations
+uint32_t hostFreeHeap();
+
+class EspClass
+{
+public:
+    uint32_t getChipId() { return 0x00E4A5C3; }
+    uint32_t getFreeHeap() { return hostFreeHeap(); }
+};
+extern EspClass ESP;
@@ -0,0 +1,27 @@
+#pragma once
+// Enough of the server API for handler registration to compile, nothing is served
+#include <Arduino.h>
+#include <FS.h>
+
+enum WebRequestMethod
+{
+    HTTP_GET = 1,
+    HTTP_POST = 2,
+    HTTP_DELETE = 4
+};
+
+class AsyncWebServerRequest
+{
+public:
+    template <typename... Args>
+    void send(Args &&...) {}
+    bool hasArg(const char *) const { return false; }
+    String arg(const char *) const { return String(); }
+};
+
+class AsyncWebServer
+{
+public:
+    template <typename... Args>
+    void on(const char *, Args &&...) {}
+};
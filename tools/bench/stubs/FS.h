@@ -0,0 +1,64 @@
+#pragma once
+// RAM filesystem with the fs::File surface the benchmarked modules use
+#include <Arduino.h>
+#include <map>
+#include <memory>
+#include <vector>
+
+enum SeekMode
+{
+    SeekSet = 0,
+    SeekCur = 1,
+    SeekEnd = 2
+};
+
+class File : public Stream
+{
+public:
+    File() {}
+    File(const std::string &path, std::shared_ptr<std::vector<uint8_t>> data, bool append);
+    // Directory handle iterating over children
+    File(const std::string &path, std::vector<std::string> children);
+
+    explicit operator bool() const { return data || isDir; }
+    const char *name() const;
+    size_t size() const { return data ? data->size() : 0; }
+    size_t position() const { return offset; }
+
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t *buffer, size_t length) override;
+    int available() override { return data ? (int)(data->size() - offset) : 0; }
+    int read() override;
+    size_t read(uint8_t *buffer, size_t length);
+    size_t readBytes(char *buffer, size_t length) override { return read((uint8_t *)buffer, length); }
+    bool seek(uint32_t position, SeekMode mode = SeekSet);
+    void close();
+
+    File openNextFile();
+
+private:
+    std::string path;
+    std::shared_ptr<std::vector<uint8_t>> data;
+    size_t offset = 0;
+    bool isDir = false;
+    std::vector<std::string> children;
+    size_t child = 0;
+};
+
+class MemoryFS
+{
+public:
+    bool begin() { return true; }
+    File open(const String &path, const char *mode);
+    File open(const char *path, const char *mode) { return open(String(path), mode); }
+    bool exists(const String &path) const { return files.count(path.s) > 0; }
+    bool remove(const String &path) { return files.erase(path.s) > 0; }
+    bool rename(const String &from, const String &to);
+
+    std::map<std::string, std::shared_ptr<std::vector<uint8_t>>> files;
+};
+
+namespace fs
+{
+using ::File;
+} // namespace fs
@@ -0,0 +1,3 @@
+#pragma once
+#include <FS.h>
+extern MemoryFS LittleFS;
@@ -0,0 +1,16 @@
+#pragma once
+#include <Arduino.h>
+
+typedef void (*callbackFunction)(void);
+typedef void (*parameterizedCallbackFunction)(void *);
+
+class OneButton
+{
+public:
+    OneButton(int, bool, bool) {}
+    void attachClick(parameterizedCallbackFunction, void *) {}
+    void attachDoubleClick(parameterizedCallbackFunction, void *) {}
+    void attachLongPressStart(parameterizedCallbackFunction, void *) {}
+    void setLongPressIntervalMs(unsigned int) {}
+    void tick() {}
+};
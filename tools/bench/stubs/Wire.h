@@ -0,0 +1,86 @@
+#pragma once
+// Mock I2C bus: one device with a 256 byte register file, addressed like the SW35xx
+// (first written byte sets the register pointer, reads auto-increment it)
+#include <Arduino.h>
+
+class TwoWire
+{
+public:
+    void begin() {}
+    void setClock(uint32_t) {}
+
+    void beginTransmission(uint8_t address)
+    {
+        target = address;
+        started = false;
+        transactions++;
+    }
+
+    size_t write(uint8_t value)
+    {
+        if (!started)
+        {
+            pointer = value;
+            started = true;
+        }
+        else
+        {
+            registers[pointer++] = value;
+        }
+        return 1;
+    }
+
+    size_t write(const uint8_t *data, size_t length)
+    {
+        for (size_t i = 0; i < length; i++)
+        {
+            write(data[i]);
+        }
+        return length;
+    }
+
+    uint8_t endTransmission(bool stop = true)
+    {
+        (void)stop;
+        // 2 is the Arduino "address NACK" code
+        return target == deviceAddress ? 0 : 2;
+    }
+
+    uint8_t requestFrom(int address, int count)
+    {
+        transactions++;
+        if (address != deviceAddress)
+        {
+            return 0;
+        }
+        pending = count;
+        return count;
+    }
+
+    int available()
+    {
+        return pending;
+    }
+
+    int read()
+    {
+        if (pending == 0)
+        {
+            return -1;
+        }
+        pending--;
+        return registers[pointer++];
+    }
+
+    uint8_t deviceAddress = 0x3c;
+    uint8_t registers[256] = {0};
+    uint32_t transactions = 0;
+
+private:
+    uint8_t target = 0;
+    uint8_t pointer = 0;
+    bool started = false;
+    int pending = 0;
+};
+
+extern TwoWire Wire;
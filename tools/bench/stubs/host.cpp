@@ -0,0 +1,201 @@
+// Definitions behind the host stubs
+#include <Arduino.h>
+#include <FS.h>
+#include <LittleFS.h>
+#include <Wire.h>
+#include <chrono>
+#include <vector>
+#include "UploadSink.h"
+
+HardwareSerial Serial;
+EspClass ESP;
+MemoryFS LittleFS;
+TwoWire Wire;
+
+static const auto hostStart = std::chrono::steady_clock::now();
+
+uint32_t millis()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - hostStart).count();
+}
+
+uint32_t micros()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - hostStart).count();
+}
+
+__attribute__((weak)) uint32_t hostFreeHeap()
+{
+    return 40000;
+}
+
+void delay(uint32_t) {}
+void yield() {}
+void pinMode(uint8_t, uint8_t) {}
+int digitalRead(uint8_t) { return HIGH; }
+void digitalWrite(uint8_t, uint8_t) {}
+void analogWrite(uint8_t, int) {}
+
+static std::vector<int> analogValues = {512};
+static size_t analogIndex = 0;
+
+void hostAnalogSequence(const int *values, size_t count)
+{
+    analogValues.assign(values, values + count);
+    analogIndex = 0;
+}
+
+int analogRead(uint8_t)
+{
+    int value = analogValues[analogIndex];
+    analogIndex = (analogIndex + 1) % analogValues.size();
+    return value;
+}
+
+long random(long howbig)
+{
+    return howbig > 0 ? rand() % howbig : 0;
+}
+
+long random(long howsmall, long howbig)
+{
+    return howsmall + random(howbig - howsmall);
+}
+
+char *dtostrf(double value, signed char width, unsigned char precision, char *buffer)
+{
+    sprintf(buffer, "%*.*f", width, precision, value);
+    return buffer;
+}
+
+void logMessage(const String &, bool) {}
+
+File::File(const std::string &path, std::shared_ptr<std::vector<uint8_t>> data, bool append)
+    : path(path), data(data), offset(append ? data->size() : 0)
+{
+}
+
+File::File(const std::string &path, std::vector<std::string> children)
+    : path(path), isDir(true), children(children)
+{
+}
+
+const char *File::name() const
+{
+    size_t slash = path.rfind('/');
+    return path.c_str() + (slash == std::string::npos ? 0 : slash + 1);
+}
+
+size_t File::write(const uint8_t *buffer, size_t length)
+{
+    if (!data)
+    {
+        return 0;
+    }
+    if (offset + length > data->size())
+    {
+        data->resize(offset + length);
+    }
+    memcpy(data->data() + offset, buffer, length);
+    offset += length;
+    return length;
+}
+
+int File::read()
+{
+    uint8_t c;
+    return read(&c, 1) == 1 ? c : -1;
+}
+
+size_t File::read(uint8_t *buffer, size_t length)
+{
+    if (!data || offset >= data->size())
+    {
+        return 0;
+    }
+    size_t count = std::min(length, data->size() - offset);
+    memcpy(buffer, data->data() + offset, count);
+    offset += count;
+    return count;
+}
+
+bool File::seek(uint32_t position, SeekMode mode)
+{
+    size_t target = mode == SeekSet ? position : mode == SeekCur ? offset + position : size() + position;
+    if (!data || target > data->size())
+    {
+        return false;
+    }
+    offset = target;
+    return true;
+}
+
+void File::close()
+{
+    data.reset();
+    isDir = false;
+}
+
+File File::openNextFile()
+{
+    while (isDir && child < children.size())
+    {
+        const std::string &childPath = children[child++];
+        auto it = LittleFS.files.find(childPath);
+        if (it != LittleFS.files.end())
+        {
+            return File(childPath, it->second, false);
+        }
+    }
+    return File();
+}
+
+File MemoryFS::open(const String &path, const char *mode)
+{
+    auto it = files.find(path.s);
+    if (mode[0] == 'r')
+    {
+        if (it != files.end())
+        {
+            return File(path.s, it->second, false);
+        }
+
+        // Directories are implied by the paths of the files below them
+        std::string prefix = path.s == "/" ? "/" : path.s + "/";
+        std::vector<std::string> children;
+        for (const auto &file : files)
+        {
+            if (file.first.compare(0, prefix.size(), prefix) == 0 && file.first.find('/', prefix.size()) == std::string::npos)
+            {
+                children.push_back(file.first);
+            }
+        }
+        return children.empty() && path.s != "/" ? File() : File(path.s, children);
+    }
+
+    if (mode[0] == 'w' || it == files.end())
+    {
+        files[path.s] = std::make_shared<std::vector<uint8_t>>();
+        it = files.find(path.s);
+    }
+    return File(path.s, it->second, mode[0] == 'a');
+}
+
+bool MemoryFS::rename(const String &from, const String &to)
+{
+    auto it = files.find(from.s);
+    if (it == files.end())
+    {
+        return false;
+    }
+    files[to.s] = it->second;
+    files.erase(it);
+    return true;
+}
+
+// Emoticons owns an UploadSink, uploads are not part of the benchmarks
+UploadSink::UploadSink() {}
+UploadSink::~UploadSink() {}
+void UploadSink::handleChunk(AsyncWebServerRequest *, const String &, size_t, uint8_t *, size_t, bool) {}
+void UploadSink::sendResult(AsyncWebServerRequest *, const String &) {}
+bool UploadSink::succeeded() const { return false; }
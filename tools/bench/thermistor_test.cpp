@@ -0,0 +1,92 @@
+// Checks the NTC lookup tables against the Steinhart-Hart function the firmware used before them.
+//
+//   make test
+//
+// Every ADC count from 1 to 1023 goes through Thermistor::toCelsius() (the constexpr flash table)
+// and through setCircuit() tables for other dividers, and has to stay within kTolerance of the
+// original Thermister() evaluated with libm, saturated at the int16 limit of the table. Between
+// two table points (every count to 64, every 8th past it, and the fractional counts the filter
+// yields) the table interpolates linearly, which is checked up to kInterpolatedMax only: past it
+// the curve bends too fast for the step, and nothing in the firmware acts on such readings.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+#include "Thermistor.h"
+
+namespace
+{
+
+constexpr double kTolerance = 0.1;
+// The ceiling of the maxTemperature parameter, the hottest reading the fan logic compares against
+constexpr double kInterpolatedMax = 120;
+constexpr double kSaturated = INT16_MAX / 100.0;
+
+// Thermister() as it was in main.cpp, with the divider as parameters
+double thermister(double val, double rs, double vcc)
+{
+    double vNtc = val / 1024;
+    double rNtc = (rs * vNtc) / (vcc - vNtc);
+    rNtc = log(rNtc);
+    double temp = 1 / (0.001129148 + (0.000234125 + (0.0000000876741 * rNtc * rNtc)) * rNtc);
+    return temp - 273.15;
+}
+
+struct Circuit
+{
+    uint32_t rs;
+    float vcc;
+};
+
+// Worst absolute error over the ADC range, half counts included to cover the interpolation
+bool check(const char *name, Circuit circuit, float (*convert)(uint32_t adcFixed))
+{
+    double worst = 0;
+    uint32_t worstAt = 0;
+    constexpr uint32_t half = 1 << (kThermistorFracBits - 1);
+    for (uint32_t adcFixed = 1 << kThermistorFracBits; adcFixed < (1024u << kThermistorFracBits); adcFixed += half)
+    {
+        // The table saturates at the int16 limit, which small series resistors reach at low counts
+        double expected = thermister((double)adcFixed / (1 << kThermistorFracBits), circuit.rs, circuit.vcc);
+        expected = std::min(expected, kSaturated);
+        uint32_t adc = adcFixed >> kThermistorFracBits;
+        bool between = adcFixed % (1 << kThermistorFracBits) != 0 ||
+                       (adc > kThermistorFineLimit && (adc - kThermistorFineLimit) % kThermistorCoarseStep != 0);
+        if (between && expected > kInterpolatedMax)
+        {
+            continue;
+        }
+        double error = fabs(convert(adcFixed) - expected);
+        if (error > worst)
+        {
+            worst = error;
+            worstAt = adcFixed;
+        }
+    }
+
+    bool ok = worst <= kTolerance;
+    printf("%-4s %-28s worst %.3f C at ADC %.1f\n", ok ? "ok" : "FAIL", name, worst,
+           (double)worstAt / (1 << kThermistorFracBits));
+    return ok;
+}
+
+Thermistor custom;
+
+} // namespace
+
+int main()
+{
+    bool ok = check("flash table", {kThermistorRs, (float)kThermistorVcc}, Thermistor::toCelsius);
+
+    const Circuit circuits[] = {{100000, 3.3f}, {47000, 3.3f}, {157000, 3.0f}, {1000, 3.3f}};
+    for (const Circuit &circuit : circuits)
+    {
+        custom.setCircuit(circuit.rs, circuit.vcc);
+        char name[40];
+        snprintf(name, sizeof(name), "setCircuit(%u, %.1f)", circuit.rs, circuit.vcc);
+        ok &= check(name, circuit, [](uint32_t adcFixed) { return custom.celsiusOf(adcFixed); });
+    }
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,257 @@
+#ifndef FLEET_JSON_H
+#define FLEET_JSON_H
+
+#pragma once
+#include <cstdlib>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Just enough JSON to read the /monitor and /info documents, no external dependency.
+struct JsonValue
+{
+    enum Type
+    {
+        Null,
+        Bool,
+        Number,
+        String,
+        Array,
+        Object
+    };
+
+    Type type = Null;
+    bool boolean = false;
+    double number = 0;
+    std::string string;
+    std::vector<JsonValue> items;
+    std::vector<std::pair<std::string, JsonValue>> members;
+
+    const JsonValue *get(const char *key) const
+    {
+        for (const auto &member : members)
+        {
+            if (member.first == key)
+            {
+                return &member.second;
+            }
+        }
+        return nullptr;
+    }
+
+    double numberOf(const char *key, double fallback = 0) const
+    {
+        const JsonValue *value = get(key);
+        return value && value->type == Number ? value->number : fallback;
+    }
+
+    bool boolOf(const char *key, bool fallback = false) const
+    {
+        const JsonValue *value = get(key);
+        return value && value->type == Bool ? value->boolean : fallback;
+    }
+
+    std::string stringOf(const char *key) const
+    {
+        const JsonValue *value = get(key);
+        return value && value->type == String ? value->string : std::string();
+    }
+};
+
+class JsonParser
+{
+public:
+    JsonParser(const char *begin, const char *end) : p(begin), end(end) {}
+
+    bool parse(JsonValue &value)
+    {
+        return parseValue(value, 0) && (skip(), p == end);
+    }
+
+private:
+    static constexpr int kMaxDepth = 16;
+
+    const char *p;
+    const char *end;
+
+    void skip()
+    {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n'))
+        {
+            p++;
+        }
+    }
+
+    bool literal(const char *word)
+    {
+        const char *q = p;
+        for (; *word; word++, q++)
+        {
+            if (q >= end || *q != *word)
+            {
+                return false;
+            }
+        }
+        p = q;
+        return true;
+    }
+
+    bool parseString(std::string &out)
+    {
+        if (p >= end || *p != '"')
+        {
+            return false;
+        }
+        p++;
+        while (p < end && *p != '"')
+        {
+            if (*p == '\\')
+            {
+                if (++p >= end)
+                {
+                    return false;
+                }
+                switch (*p)
+                {
+                case 'n':
+                    out += '\n';
+                    break;
+                case 't':
+                    out += '\t';
+                    break;
+                case 'r':
+                    out += '\r';
+                    break;
+                case 'b':
+                    out += '\b';
+                    break;
+                case 'f':
+                    out += '\f';
+                    break;
+                case 'u':
+                    // Device strings are ASCII, keep a placeholder for anything else
+                    if (end - p < 5)
+                    {
+                        return false;
+                    }
+                    out += '?';
+                    p += 4;
+                    break;
+                default:
+                    out += *p;
+                }
+                p++;
+                continue;
+            }
+            out += *p++;
+        }
+        if (p >= end)
+        {
+            return false;
+        }
+        p++;
+        return true;
+    }
+
+    bool parseValue(JsonValue &value, int depth)
+    {
+        skip();
+        if (p >= end || depth > kMaxDepth)
+        {
+            return false;
+        }
+
+        switch (*p)
+        {
+        case '{':
+        {
+            value.type = JsonValue::Object;
+            p++;
+            skip();
+            if (p < end && *p == '}')
+            {
+                p++;
+                return true;
+            }
+            for (;;)
+            {
+                std::pair<std::string, JsonValue> member;
+                skip();
+                if (!parseString(member.first))
+                {
+                    return false;
+                }
+                skip();
+                if (p >= end || *p++ != ':' || !parseValue(member.second, depth + 1))
+                {
+                    return false;
+                }
+                value.members.push_back(std::move(member));
+                skip();
+                if (p < end && *p == ',')
+                {
+                    p++;
+                    continue;
+                }
+                return p < end && *p++ == '}';
+            }
+        }
+        case '[':
+        {
+            value.type = JsonValue::Array;
+            p++;
+            skip();
+            if (p < end && *p == ']')
+            {
+                p++;
+                return true;
+            }
+            for (;;)
+            {
+                value.items.emplace_back();
+                if (!parseValue(value.items.back(), depth + 1))
+                {
+                    return false;
+                }
+                skip();
+                if (p < end && *p == ',')
+                {
+                    p++;
+                    continue;
+                }
+                return p < end && *p++ == ']';
+            }
+        }
+        case '"':
+            value.type = JsonValue::String;
+            return parseString(value.string);
+        case 't':
+            value.type = JsonValue::Bool;
+            value.boolean = true;
+            return literal("true");
+        case 'f':
+            value.type = JsonValue::Bool;
+            return literal("false");
+        case 'n':
+            return literal("null");
+        default:
+        {
+            std::string number;
+            while (p < end && (isdigit((unsigned char)*p) || *p == '-' || *p == '+' || *p == '.' || *p == 'e' || *p == 'E'))
+            {
+                number += *p++;
+            }
+            if (number.empty())
+            {
+                return false;
+            }
+            char *last = nullptr;
+            value.type = JsonValue::Number;
+            value.number = strtod(number.c_str(), &last);
+            return *last == '\0';
+        }
+        }
+    }
+};
+
+#endif
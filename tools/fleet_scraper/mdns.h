@@ -0,0 +1,258 @@
+#ifndef FLEET_MDNS_H
+#define FLEET_MDNS_H
+
+#pragma once
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+struct Endpoint
+{
+    std::string name;
+    std::string host;
+    uint16_t port = 80;
+};
+
+namespace mdns_detail
+{
+
+constexpr uint16_t kTypeA = 1;
+constexpr uint16_t kTypePtr = 12;
+constexpr uint16_t kTypeSrv = 33;
+
+struct Reader
+{
+    const uint8_t *data;
+    size_t length;
+    size_t pos = 0;
+    bool ok = true;
+
+    uint16_t u16()
+    {
+        if (pos + 2 > length)
+        {
+            ok = false;
+            return 0;
+        }
+        uint16_t value = (data[pos] << 8) | data[pos + 1];
+        pos += 2;
+        return value;
+    }
+
+    uint32_t u32()
+    {
+        uint32_t high = u16();
+        return (high << 16) | u16();
+    }
+
+    // Reads a possibly compressed name starting at offset, returns the offset after it
+    size_t name(size_t offset, std::string &out, int jumps = 0)
+    {
+        while (ok && offset < length)
+        {
+            uint8_t len = data[offset];
+            if (len == 0)
+            {
+                return offset + 1;
+            }
+            if ((len & 0xC0) == 0xC0)
+            {
+                if (offset + 1 >= length || jumps > 8)
+                {
+                    ok = false;
+                    return length;
+                }
+                name(((len & 0x3F) << 8) | data[offset + 1], out, jumps + 1);
+                return offset + 2;
+            }
+            if (offset + 1 + len > length)
+            {
+                break;
+            }
+            if (!out.empty())
+            {
+                out += '.';
+            }
+            out.append(reinterpret_cast<const char *>(data + offset + 1), len);
+            offset += 1 + len;
+        }
+        ok = false;
+        return length;
+    }
+};
+
+inline void appendName(std::vector<uint8_t> &packet, const char *name)
+{
+    while (*name)
+    {
+        const char *dot = strchr(name, '.');
+        size_t len = dot ? (size_t)(dot - name) : strlen(name);
+        packet.push_back(len);
+        packet.insert(packet.end(), name, name + len);
+        name += len + (dot ? 1 : 0);
+    }
+    packet.push_back(0);
+}
+
+inline bool startsWith(const std::string &value, const std::string &prefix)
+{
+    if (value.size() < prefix.size())
+    {
+        return false;
+    }
+    for (size_t i = 0; i < prefix.size(); i++)
+    {
+        if (tolower((unsigned char)value[i]) != tolower((unsigned char)prefix[i]))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace mdns_detail
+
+/**
+ * @brief Browse _http._tcp.local and keep the instances whose name starts with prefix
+ *
+ * The query is sent from an ephemeral port, which makes it a legacy unicast query (RFC 6762 6.7):
+ * responders answer straight to us, so this works next to a running avahi/Bonjour daemon.
+ */
+inline std::vector<Endpoint> discoverEndpoints(const std::string &prefix, int timeoutMs)
+{
+    using namespace mdns_detail;
+    std::vector<Endpoint> endpoints;
+
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0)
+    {
+        return endpoints;
+    }
+
+    std::vector<uint8_t> query = {0x12, 0x34, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0};
+    appendName(query, "_http._tcp.local");
+    query.insert(query.end(), {0, kTypePtr, 0, 1});
+
+    sockaddr_in group = {};
+    group.sin_family = AF_INET;
+    group.sin_port = htons(5353);
+    inet_pton(AF_INET, "224.0.0.251", &group.sin_addr);
+
+    std::map<std::string, std::string> instances; // instance -> SRV target
+    std::map<std::string, uint16_t> ports;        // instance -> SRV port
+    std::map<std::string, std::string> addresses; // host -> IPv4
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    auto nextQuery = std::chrono::steady_clock::now();
+    uint8_t buffer[9000];
+    for (;;)
+    {
+        auto now = std::chrono::steady_clock::now();
+        if (now >= deadline)
+        {
+            break;
+        }
+        // Repeat the query a few times, a busy ESP8266 drops the odd packet
+        if (now >= nextQuery)
+        {
+            sendto(fd, query.data(), query.size(), 0, reinterpret_cast<sockaddr *>(&group), sizeof(group));
+            nextQuery = now + std::chrono::milliseconds(timeoutMs / 3 + 1);
+        }
+
+        pollfd pfd = {fd, POLLIN, 0};
+        auto wait = std::min(deadline, nextQuery) - now;
+        if (poll(&pfd, 1, std::chrono::duration_cast<std::chrono::milliseconds>(wait).count() + 1) <= 0)
+        {
+            continue;
+        }
+
+        ssize_t length = recv(fd, buffer, sizeof(buffer), 0);
+        if (length < 12)
+        {
+            continue;
+        }
+
+        Reader reader{buffer, (size_t)length};
+        reader.pos = 4;
+        uint16_t questions = reader.u16();
+        uint16_t records = reader.u16();
+        records += reader.u16();
+        records += reader.u16();
+        for (uint16_t i = 0; i < questions && reader.ok; i++)
+        {
+            std::string ignored;
+            reader.pos = reader.name(reader.pos, ignored) + 4;
+        }
+
+        for (uint16_t i = 0; i < records && reader.ok; i++)
+        {
+            std::string owner;
+            reader.pos = reader.name(reader.pos, owner);
+            uint16_t type = reader.u16();
+            reader.u16(); // class
+            reader.u32(); // ttl
+            uint16_t rdlength = reader.u16();
+            size_t rdata = reader.pos;
+            if (!reader.ok || rdata + rdlength > reader.length)
+            {
+                break;
+            }
+
+            if (type == kTypePtr)
+            {
+                std::string instance;
+                reader.name(rdata, instance);
+                if (startsWith(instance, prefix) && !instances.count(instance))
+                {
+                    instances[instance] = "";
+                }
+            }
+            else if (type == kTypeSrv && rdlength > 6)
+            {
+                std::string target;
+                reader.pos = rdata + 4;
+                ports[owner] = reader.u16();
+                reader.name(rdata + 6, target);
+                instances[owner] = target;
+            }
+            else if (type == kTypeA && rdlength == 4)
+            {
+                char ip[INET_ADDRSTRLEN];
+                inet_ntop(AF_INET, buffer + rdata, ip, sizeof(ip));
+                addresses[owner] = ip;
+            }
+            reader.pos = rdata + rdlength;
+        }
+    }
+    close(fd);
+
+    for (const auto &instance : instances)
+    {
+        if (!startsWith(instance.first, prefix))
+        {
+            continue;
+        }
+        auto address = addresses.find(instance.second);
+        if (address == addresses.end())
+        {
+            continue;
+        }
+        Endpoint endpoint;
+        endpoint.name = instance.first.substr(0, instance.first.find('.'));
+        endpoint.host = address->second;
+        endpoint.port = ports.count(instance.first) ? ports[instance.first] : 80;
+        endpoints.push_back(endpoint);
+    }
+    return endpoints;
+}
+
+#endif
@@ -0,0 +1,778 @@
+// Scrapes /monitor and /info from a fleet of SW351x monitors and prints a fleet-wide summary.
+//
+//   ./fleet_scraper --mdns [--prefix sw351xmonitor] [--discover-ms 2000]
+//   ./fleet_scraper --hosts hosts.txt          (one host[:port] per line, # comments)
+//   ./fleet_scraper --host 192.168.1.50 --host 192.168.1.51:8080
+//
+// Common options:
+//   --concurrency N   requests in flight (default 256)
+//   --timeout MS      per request timeout (default 3000)
+//   --slow MS         laggard threshold, default 3x the median /monitor latency (min 200 ms)
+//   --rounds N        scrape N times, --interval MS apart (default 1 round)
+//   --json            print one JSON document per round instead of the text report
+//
+// One non-blocking HTTP/1.0 request per socket on a single epoll loop, so hundreds of devices
+// are scraped in roughly the time of the slowest one. tools/fleet_scraper/standin.py serves
+// emulated devices on localhost for testing.
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "json.h"
+#include "mdns.h"
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int kPorts = 4;
+
+struct Options
+{
+    std::vector<Endpoint> endpoints;
+    bool mdns = false;
+    std::string prefix = "sw351xmonitor";
+    int discoverMs = 2000;
+    size_t concurrency = 256;
+    int timeoutMs = 3000;
+    int slowMs = 0;
+    int rounds = 1;
+    int intervalMs = 10000;
+    bool json = false;
+};
+
+struct PortSample
+{
+    bool active = false;
+    double voltage = 0;
+    double current = 0;
+    double power = 0;
+    double energy = 0;
+    std::string protocol;
+};
+
+struct DeviceSample
+{
+    bool monitorOk = false;
+    bool infoOk = false;
+    double monitorMs = 0;
+    double infoMs = 0;
+    std::string error;
+
+    PortSample ports[kPorts];
+    double moduleTemp = 0;
+    double inputVoltage = 0;
+    int state = 0;
+    int fanSpeed = 0;
+    std::string firmware;
+    std::string serverName;
+};
+
+struct Device
+{
+    Endpoint endpoint;
+    sockaddr_in address = {};
+    bool resolved = false;
+    DeviceSample sample;
+};
+
+struct Request
+{
+    size_t device;
+    bool info;
+    bool connected = false;
+    std::string out;
+    size_t sent = 0;
+    std::string in;
+    Clock::time_point start;
+    Clock::time_point deadline;
+};
+
+double elapsedMs(Clock::time_point since)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - since).count();
+}
+
+bool parseEndpoint(const std::string &text, Endpoint &endpoint)
+{
+    std::string value = text;
+    size_t hash = value.find('#');
+    if (hash != std::string::npos)
+    {
+        value.erase(hash);
+    }
+    value.erase(0, value.find_first_not_of(" \t\r"));
+    value.erase(value.find_last_not_of(" \t\r") + 1);
+    if (value.empty())
+    {
+        return false;
+    }
+
+    size_t colon = value.rfind(':');
+    endpoint.host = value.substr(0, colon);
+    endpoint.port = colon == std::string::npos ? 80 : atoi(value.c_str() + colon + 1);
+    endpoint.name = value;
+    return endpoint.port != 0;
+}
+
+bool resolve(Device &device)
+{
+    device.address.sin_family = AF_INET;
+    device.address.sin_port = htons(device.endpoint.port);
+    if (inet_pton(AF_INET, device.endpoint.host.c_str(), &device.address.sin_addr) == 1)
+    {
+        return true;
+    }
+
+    addrinfo hints = {};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo *result = nullptr;
+    if (getaddrinfo(device.endpoint.host.c_str(), nullptr, &hints, &result) != 0 || !result)
+    {
+        return false;
+    }
+    device.address.sin_addr = reinterpret_cast<sockaddr_in *>(result->ai_addr)->sin_addr;
+    freeaddrinfo(result);
+    return true;
+}
+
+// Returns the body of a 200 response, handling both Content-Length/EOF and chunked bodies
+bool extractBody(const std::string &response, std::string &body, std::string &error)
+{
+    size_t headerEnd = response.find("\r\n\r\n");
+    if (headerEnd == std::string::npos || response.compare(0, 5, "HTTP/") != 0)
+    {
+        error = "malformed response";
+        return false;
+    }
+
+    int status = atoi(response.c_str() + response.find(' ') + 1);
+    if (status != 200)
+    {
+        error = "HTTP " + std::to_string(status);
+        return false;
+    }
+
+    std::string headers = response.substr(0, headerEnd);
+    std::transform(headers.begin(), headers.end(), headers.begin(), ::tolower);
+    size_t pos = headerEnd + 4;
+    if (headers.find("transfer-encoding: chunked") == std::string::npos)
+    {
+        body = response.substr(pos);
+        return true;
+    }
+
+    body.clear();
+    for (;;)
+    {
+        size_t lineEnd = response.find("\r\n", pos);
+        if (lineEnd == std::string::npos)
+        {
+            error = "truncated chunk";
+            return false;
+        }
+        size_t size = strtoul(response.c_str() + pos, nullptr, 16);
+        pos = lineEnd + 2;
+        if (size == 0)
+        {
+            return true;
+        }
+        if (pos + size > response.size())
+        {
+            error = "truncated chunk";
+            return false;
+        }
+        body.append(response, pos, size);
+        pos += size + 2;
+    }
+}
+
+void decodeMonitor(const JsonValue &doc, DeviceSample &sample)
+{
+    const JsonValue *ports = doc.get("ports");
+    for (int i = 0; ports && i < kPorts && i < (int)ports->items.size(); i++)
+    {
+        const JsonValue &port = ports->items[i];
+        PortSample &out = sample.ports[i];
+        out.active = port.boolOf("isActive");
+        out.voltage = port.numberOf("voltage");
+        out.current = port.numberOf("current");
+        out.power = port.numberOf("power");
+        out.energy = port.numberOf("totalPower");
+        out.protocol = port.stringOf("protocol");
+    }
+    sample.moduleTemp = doc.numberOf("moduleTemp");
+    sample.inputVoltage = doc.numberOf("inputVoltage");
+    sample.state = (int)doc.numberOf("state");
+    sample.fanSpeed = (int)doc.numberOf("fanSpeed");
+}
+
+class Scraper
+{
+public:
+    Scraper(std::vector<Device> &devices, const Options &options) : devices(devices), options(options)
+    {
+        epollFd = epoll_create1(0);
+    }
+
+    ~Scraper()
+    {
+        close(epollFd);
+    }
+
+    void run()
+    {
+        std::vector<std::pair<size_t, bool>> queue;
+        for (size_t i = 0; i < devices.size(); i++)
+        {
+            devices[i].sample = DeviceSample();
+            if (!devices[i].resolved)
+            {
+                devices[i].sample.error = "unresolved host";
+                continue;
+            }
+            queue.emplace_back(i, false);
+            queue.emplace_back(i, true);
+        }
+
+        size_t next = 0;
+        epoll_event events[256];
+        while (next < queue.size() || !active.empty())
+        {
+            while (next < queue.size() && active.size() < options.concurrency)
+            {
+                start(queue[next].first, queue[next].second);
+                next++;
+            }
+
+            int count = epoll_wait(epollFd, events, 256, waitMs());
+            for (int i = 0; i < count; i++)
+            {
+                handle(events[i].data.fd, events[i].events);
+            }
+            expire();
+        }
+    }
+
+private:
+    std::vector<Device> &devices;
+    const Options &options;
+    int epollFd;
+    std::unordered_map<int, Request> active;
+
+    void start(size_t device, bool info)
+    {
+        Request request;
+        request.device = device;
+        request.info = info;
+        request.start = Clock::now();
+        request.deadline = request.start + std::chrono::milliseconds(options.timeoutMs);
+        request.out = std::string("GET ") + (info ? "/info" : "/monitor") + " HTTP/1.0\r\nHost: " +
+                      devices[device].endpoint.host + "\r\nConnection: close\r\n\r\n";
+
+        int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0)
+        {
+            finish(request, std::string("socket: ") + strerror(errno));
+            return;
+        }
+
+        const sockaddr_in &address = devices[device].address;
+        if (connect(fd, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) < 0 && errno != EINPROGRESS)
+        {
+            close(fd);
+            finish(request, std::string("connect: ") + strerror(errno));
+            return;
+        }
+
+        epoll_event event = {};
+        event.events = EPOLLOUT | EPOLLIN | EPOLLRDHUP;
+        event.data.fd = fd;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+        active.emplace(fd, std::move(request));
+    }
+
+    int waitMs() const
+    {
+        if (active.empty())
+        {
+            return 0;
+        }
+        Clock::time_point earliest = Clock::time_point::max();
+        for (const auto &entry : active)
+        {
+            earliest = std::min(earliest, entry.second.deadline);
+        }
+        auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(earliest - Clock::now()).count();
+        return wait < 0 ? 0 : (int)wait + 1;
+    }
+
+    void handle(int fd, uint32_t events)
+    {
+        auto it = active.find(fd);
+        if (it == active.end())
+        {
+            return;
+        }
+        Request &request = it->second;
+
+        if (!request.connected && (events & (EPOLLOUT | EPOLLERR | EPOLLHUP)))
+        {
+            int error = 0;
+            socklen_t length = sizeof(error);
+            getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &length);
+            if (error)
+            {
+                fail(fd, std::string("connect: ") + strerror(error));
+                return;
+            }
+            request.connected = true;
+        }
+
+        if (request.connected && request.sent < request.out.size())
+        {
+            ssize_t written = send(fd, request.out.data() + request.sent, request.out.size() - request.sent, MSG_NOSIGNAL);
+            if (written < 0 && errno != EAGAIN)
+            {
+                fail(fd, std::string("send: ") + strerror(errno));
+                return;
+            }
+            if (written > 0)
+            {
+                request.sent += written;
+            }
+            if (request.sent == request.out.size())
+            {
+                epoll_event event = {};
+                event.events = EPOLLIN | EPOLLRDHUP;
+                event.data.fd = fd;
+                epoll_ctl(epollFd, EPOLL_CTL_MOD, fd, &event);
+            }
+        }
+
+        if (events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP))
+        {
+            char buffer[4096];
+            for (;;)
+            {
+                ssize_t received = recv(fd, buffer, sizeof(buffer), 0);
+                if (received > 0)
+                {
+                    request.in.append(buffer, received);
+                    continue;
+                }
+                if (received == 0)
+                {
+                    // HTTP/1.0 with Connection: close, EOF ends the response
+                    complete(fd);
+                    return;
+                }
+                if (errno != EAGAIN)
+                {
+                    fail(fd, std::string("recv: ") + strerror(errno));
+                }
+                return;
+            }
+        }
+    }
+
+    void expire()
+    {
+        Clock::time_point now = Clock::now();
+        std::vector<int> expired;
+        for (const auto &entry : active)
+        {
+            if (entry.second.deadline <= now)
+            {
+                expired.push_back(entry.first);
+            }
+        }
+        for (int fd : expired)
+        {
+            fail(fd, "timeout");
+        }
+    }
+
+    Request release(int fd)
+    {
+        auto it = active.find(fd);
+        Request request = std::move(it->second);
+        active.erase(it);
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+        close(fd);
+        return request;
+    }
+
+    void fail(int fd, const std::string &error)
+    {
+        Request request = release(fd);
+        finish(request, error);
+    }
+
+    void complete(int fd)
+    {
+        Request request = release(fd);
+        std::string body;
+        std::string error;
+        JsonValue doc;
+        if (!extractBody(request.in, body, error))
+        {
+            finish(request, error);
+            return;
+        }
+        if (!JsonParser(body.data(), body.data() + body.size()).parse(doc) || doc.type != JsonValue::Object)
+        {
+            finish(request, "invalid JSON");
+            return;
+        }
+
+        DeviceSample &sample = devices[request.device].sample;
+        if (request.info)
+        {
+            sample.infoOk = true;
+            sample.firmware = doc.stringOf("firmware");
+            sample.serverName = doc.stringOf("serverName");
+        }
+        else
+        {
+            sample.monitorOk = true;
+            decodeMonitor(doc, sample);
+        }
+        finish(request, "");
+    }
+
+    void finish(const Request &request, const std::string &error)
+    {
+        DeviceSample &sample = devices[request.device].sample;
+        (request.info ? sample.infoMs : sample.monitorMs) = elapsedMs(request.start);
+        if (!error.empty() && sample.error.empty())
+        {
+            sample.error = std::string(request.info ? "/info " : "/monitor ") + error;
+        }
+    }
+};
+
+double percentile(std::vector<double> values, double p)
+{
+    if (values.empty())
+    {
+        return 0;
+    }
+    std::sort(values.begin(), values.end());
+    return values[std::min(values.size() - 1, (size_t)(p * (values.size() - 1) + 0.5))];
+}
+
+std::string jsonEscape(const std::string &value)
+{
+    std::string out;
+    for (char c : value)
+    {
+        if (c == '"' || c == '\\')
+        {
+            out += '\\';
+        }
+        if ((unsigned char)c >= 0x20)
+        {
+            out += c;
+        }
+    }
+    return out;
+}
+
+void report(const std::vector<Device> &devices, const Options &options, double roundMs)
+{
+    size_t ok = 0;
+    size_t activePorts = 0;
+    double power = 0;
+    double energy = 0;
+    double maxTemp = 0;
+    double sumTemp = 0;
+    std::map<std::string, size_t> protocols;
+    std::map<std::string, size_t> firmwares;
+    std::map<int, size_t> states;
+    std::vector<double> latencies;
+
+    for (const Device &device : devices)
+    {
+        const DeviceSample &sample = device.sample;
+        if (!sample.monitorOk)
+        {
+            continue;
+        }
+        ok++;
+        latencies.push_back(sample.monitorMs);
+        sumTemp += sample.moduleTemp;
+        maxTemp = std::max(maxTemp, sample.moduleTemp);
+        states[sample.state]++;
+        if (sample.infoOk)
+        {
+            firmwares[sample.firmware]++;
+        }
+        for (const PortSample &port : sample.ports)
+        {
+            energy += port.energy;
+            if (port.active)
+            {
+                activePorts++;
+                power += port.power;
+                protocols[port.protocol.empty() ? "NONE" : port.protocol]++;
+            }
+        }
+    }
+
+    double median = percentile(latencies, 0.5);
+    double slowMs = options.slowMs > 0 ? options.slowMs : std::max(200.0, median * 3);
+    std::vector<const Device *> laggards;
+    std::vector<const Device *> failed;
+    for (const Device &device : devices)
+    {
+        if (!device.sample.monitorOk || !device.sample.error.empty())
+        {
+            failed.push_back(&device);
+        }
+        else if (device.sample.monitorMs > slowMs)
+        {
+            laggards.push_back(&device);
+        }
+    }
+    std::sort(laggards.begin(), laggards.end(), [](const Device *a, const Device *b)
+              { return a->sample.monitorMs > b->sample.monitorMs; });
+
+    if (options.json)
+    {
+        printf("{\"devices\":%zu,\"ok\":%zu,\"failed\":%zu,\"roundMs\":%.1f,\"activePorts\":%zu,\"powerW\":%.3f,\"energyWh\":%.3f,",
+               devices.size(), ok, failed.size(), roundMs, activePorts, power, energy);
+        printf("\"moduleTemp\":{\"avg\":%.2f,\"max\":%.2f},", ok ? sumTemp / ok : 0, maxTemp);
+        printf("\"latencyMs\":{\"p50\":%.1f,\"p95\":%.1f,\"max\":%.1f,\"slow\":%.1f},", median, percentile(latencies, 0.95),
+               percentile(latencies, 1), slowMs);
+        const char *separator = "";
+        printf("\"protocols\":{");
+        for (const auto &entry : protocols)
+        {
+            printf("%s\"%s\":%zu", separator, jsonEscape(entry.first).c_str(), entry.second);
+            separator = ",";
+        }
+        separator = "";
+        printf("},\"firmware\":{");
+        for (const auto &entry : firmwares)
+        {
+            printf("%s\"%s\":%zu", separator, jsonEscape(entry.first).c_str(), entry.second);
+            separator = ",";
+        }
+        separator = "";
+        printf("},\"laggards\":[");
+        for (const Device *device : laggards)
+        {
+            printf("%s{\"name\":\"%s\",\"host\":\"%s\",\"port\":%u,\"ms\":%.1f}", separator, jsonEscape(device->endpoint.name).c_str(),
+                   jsonEscape(device->endpoint.host).c_str(), device->endpoint.port, device->sample.monitorMs);
+            separator = ",";
+        }
+        separator = "";
+        printf("],\"failures\":[");
+        for (const Device *device : failed)
+        {
+            printf("%s{\"name\":\"%s\",\"host\":\"%s\",\"port\":%u,\"error\":\"%s\"}", separator, jsonEscape(device->endpoint.name).c_str(),
+                   jsonEscape(device->endpoint.host).c_str(), device->endpoint.port, jsonEscape(device->sample.error).c_str());
+            separator = ",";
+        }
+        printf("]}\n");
+        fflush(stdout);
+        return;
+    }
+
+    printf("devices     %zu scraped, %zu ok, %zu failed in %.0f ms\n", devices.size(), ok, failed.size(), roundMs);
+    printf("power       %.2f W on %zu active ports\n", power, activePorts);
+    printf("energy      %.2f Wh lifetime\n", energy);
+    printf("module temp avg %.1f C, max %.1f C\n", ok ? sumTemp / ok : 0, maxTemp);
+    printf("latency     p50 %.0f ms, p95 %.0f ms, max %.0f ms\n", median, percentile(latencies, 0.95), percentile(latencies, 1));
+    printf("protocols  ");
+    for (const auto &entry : protocols)
+    {
+        printf(" %s=%zu", entry.first.c_str(), entry.second);
+    }
+    printf("\nstates     ");
+    for (const auto &entry : states)
+    {
+        printf(" %d=%zu", entry.first, entry.second);
+    }
+    printf("\nfirmware   ");
+    for (const auto &entry : firmwares)
+    {
+        printf(" %s=%zu", entry.first.c_str(), entry.second);
+    }
+    printf("\n");
+
+    if (!laggards.empty())
+    {
+        printf("laggards (> %.0f ms):\n", slowMs);
+        for (const Device *device : laggards)
+        {
+            printf("  %-32s %s:%u %.0f ms\n", device->endpoint.name.c_str(), device->endpoint.host.c_str(), device->endpoint.port,
+                   device->sample.monitorMs);
+        }
+    }
+    if (!failed.empty())
+    {
+        printf("failed:\n");
+        for (const Device *device : failed)
+        {
+            printf("  %-32s %s:%u %s\n", device->endpoint.name.c_str(), device->endpoint.host.c_str(), device->endpoint.port,
+                   device->sample.error.c_str());
+        }
+    }
+    printf("\n");
+    fflush(stdout);
+}
+
+void usage(const char *name)
+{
+    fprintf(stderr,
+            "usage: %s (--mdns [--prefix P] [--discover-ms N] | --hosts FILE | --host H[:P]...)\n"
+            "          [--concurrency N] [--timeout MS] [--slow MS] [--rounds N] [--interval MS] [--json]\n",
+            name);
+}
+
+bool parseOptions(int argc, char **argv, Options &options)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--mdns")
+        {
+            options.mdns = true;
+        }
+        else if (arg == "--json")
+        {
+            options.json = true;
+        }
+        else if (!hasValue)
+        {
+            return false;
+        }
+        else if (arg == "--host")
+        {
+            Endpoint endpoint;
+            if (!parseEndpoint(argv[++i], endpoint))
+            {
+                return false;
+            }
+            options.endpoints.push_back(endpoint);
+        }
+        else if (arg == "--hosts")
+        {
+            std::ifstream file(argv[++i]);
+            if (!file)
+            {
+                fprintf(stderr, "cannot read %s\n", argv[i]);
+                return false;
+            }
+            std::string line;
+            Endpoint endpoint;
+            while (std::getline(file, line))
+            {
+                if (parseEndpoint(line, endpoint))
+                {
+                    options.endpoints.push_back(endpoint);
+                }
+            }
+        }
+        else if (arg == "--prefix")
+        {
+            options.prefix = argv[++i];
+        }
+        else if (arg == "--discover-ms")
+        {
+            options.discoverMs = atoi(argv[++i]);
+        }
+        else if (arg == "--concurrency")
+        {
+            options.concurrency = std::max(1, atoi(argv[++i]));
+        }
+        else if (arg == "--timeout")
+        {
+            options.timeoutMs = atoi(argv[++i]);
+        }
+        else if (arg == "--slow")
+        {
+            options.slowMs = atoi(argv[++i]);
+        }
+        else if (arg == "--rounds")
+        {
+            options.rounds = atoi(argv[++i]);
+        }
+        else if (arg == "--interval")
+        {
+            options.intervalMs = atoi(argv[++i]);
+        }
+        else
+        {
+            return false;
+        }
+    }
+    return options.mdns || !options.endpoints.empty();
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    Options options;
+    if (!parseOptions(argc, argv, options))
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+    if (options.mdns)
+    {
+        std::vector<Endpoint> found = discoverEndpoints(options.prefix, options.discoverMs);
+        fprintf(stderr, "mDNS: %zu devices matching '%s'\n", found.size(), options.prefix.c_str());
+        options.endpoints.insert(options.endpoints.end(), found.begin(), found.end());
+    }
+    if (options.endpoints.empty())
+    {
+        fprintf(stderr, "no devices to scrape\n");
+        return 1;
+    }
+
+    std::vector<Device> devices(options.endpoints.size());
+    for (size_t i = 0; i < devices.size(); i++)
+    {
+        devices[i].endpoint = options.endpoints[i];
+        devices[i].resolved = resolve(devices[i]);
+    }
+
+    Scraper scraper(devices, options);
+    for (int round = 0; round < options.rounds || options.rounds <= 0; round++)
+    {
+        if (round > 0)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(options.intervalMs));
+        }
+        Clock::time_point start = Clock::now();
+        scraper.run();
+        report(devices, options, elapsedMs(start));
+    }
+    return 0;
+}
@@ -0,0 +1,104 @@
+#!/usr/bin/env python3
+# Emulates a fleet of SW351x monitors on localhost for testing fleet_scraper.
+#
+#   ./standin.py --count 300 --base-port 18000 --slow 5 --delay 800 --broken 2 --hosts-file hosts.txt
+#   ./fleet_scraper --hosts hosts.txt
+#
+# Every device serves /monitor and /info with the same schema as the firmware. The last
+# --slow devices answer after --delay ms and the --broken ones before them return HTTP 500.
+
+import argparse
+import asyncio
+import json
+import random
+
+PROTOCOLS = ["NONE", "QC2.0", "QC3.0", "FCP", "SCP", "PD FIX", "PD PPS", "PE1.1", "PE2.0", "LVDC", "SFCP", "AFC"]
+
+
+def monitor_document(rng):
+    ports = []
+    for _ in range(4):
+        active = rng.random() < 0.6
+        voltage = rng.choice([5.0, 9.0, 12.0, 15.0, 20.0]) if active else 0.0
+        current = round(rng.uniform(0.1, 3.0), 3) if active else 0.0
+        ports.append({
+            "voltage": voltage,
+            "current": current,
+            "temperature": round(rng.uniform(25, 45), 1),
+            "protocol": rng.choice(PROTOCOLS) if active else "NONE",
+            "isActive": active,
+            "power": round(voltage * current, 3),
+            "totalPower": round(rng.uniform(0, 500), 3),
+        })
+    return {
+        "ports": ports,
+        "moduleTemp": round(rng.uniform(30, 60), 1),
+        "inputVoltage": 20.0,
+        "state": rng.choice([0, 1]),
+        "fanSpeed": rng.randint(0, 255),
+    }
+
+
+def make_handler(index, args):
+    rng = random.Random(index)
+    name = "sw351xmonitor-%d" % (1000000 + index)
+    slow = index >= args.count - args.slow
+    broken = not slow and index >= args.count - args.slow - args.broken
+
+    async def handle(reader, writer):
+        try:
+            request = await reader.readuntil(b"\r\n\r\n")
+        except (asyncio.IncompleteReadError, asyncio.LimitOverrunError, ConnectionError):
+            writer.close()
+            return
+
+        path = request.split(b" ", 2)[1].decode(errors="replace")
+        if slow:
+            await asyncio.sleep(args.delay / 1000)
+
+        if broken:
+            status, body = "500 Internal Server Error", b"{}"
+        elif path == "/monitor":
+            status, body = "200 OK", json.dumps(monitor_document(rng)).encode()
+        elif path == "/info":
+            status, body = "200 OK", json.dumps({"firmware": args.firmware, "serverName": name}).encode()
+        else:
+            status, body = "404 Not Found", b"Not found"
+
+        writer.write(("HTTP/1.1 %s\r\nContent-Type: application/json\r\nContent-Length: %d\r\nConnection: close\r\n\r\n"
+                      % (status, len(body))).encode() + body)
+        try:
+            await writer.drain()
+        finally:
+            writer.close()
+
+    return handle
+
+
+async def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("--count", type=int, default=100)
+    parser.add_argument("--host", default="127.0.0.1")
+    parser.add_argument("--base-port", type=int, default=18000)
+    parser.add_argument("--slow", type=int, default=0, help="number of devices that answer late")
+    parser.add_argument("--delay", type=int, default=1000, help="delay of the slow devices in ms")
+    parser.add_argument("--broken", type=int, default=0, help="number of devices that return HTTP 500")
+    parser.add_argument("--firmware", default="1.0.0")
+    parser.add_argument("--hosts-file", help="write a host list for fleet_scraper --hosts")
+    args = parser.parse_args()
+
+    servers = []
+    for index in range(args.count):
+        servers.append(await asyncio.start_server(make_handler(index, args), args.host, args.base_port + index, backlog=64))
+
+    if args.hosts_file:
+        with open(args.hosts_file, "w") as hosts:
+            for index in range(args.count):
+                hosts.write("%s:%d\n" % (args.host, args.base_port + index))
+
+    print("serving %d devices on %s:%d-%d" % (args.count, args.host, args.base_port, args.base_port + args.count - 1), flush=True)
+    await asyncio.gather(*(server.serve_forever() for server in servers))
+
+
+if __name__ == "__main__":
+    asyncio.run(main())
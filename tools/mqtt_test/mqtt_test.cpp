@@ -0,0 +1,237 @@
+// Runs MqttExporter against standin.py, a Mosquitto stand-in, and measures what publishing costs.
+//
+//   make test                                   (starts the stand-in and stops it after)
+//   ./standin.py --ack-delay 20 & ./mqtt_test --port 18830 --generations 200
+//
+// The exporter connects, publishes its 20 discovery configs and then the states of four ports
+// over a number of sample generations, each port crossing the voltage threshold every time.
+// Last the connection is dropped between a publish and its PUBACK, and the exporter has to
+// reconnect and go on measuring.
+// Latency is publish to PUBACK, as the client sees it and as MqttStats reports it. Heap is the
+// glibc usable size of every live block, so the numbers are the exporter's own allocations:
+// the Strings it keeps, the discovery document and payload, the topic of every state. The TCP
+// and client buffers of the device are not part of it, neither is Wi-Fi in the latency.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <malloc.h>
+#include <vector>
+
+#include <ESP8266WiFi.h>
+
+#include "Config.h"
+#include "MqttExporter.h"
+
+extern "C" void *__libc_malloc(size_t size);
+extern "C" void *__libc_calloc(size_t count, size_t size);
+extern "C" void *__libc_realloc(void *pointer, size_t size);
+extern "C" void __libc_free(void *pointer);
+
+namespace
+{
+
+size_t live = 0;
+size_t peak = 0;
+
+void *tracked(void *pointer)
+{
+    if (pointer)
+    {
+        live += malloc_usable_size(pointer);
+        peak = std::max(peak, live);
+    }
+    return pointer;
+}
+
+void untrack(void *pointer)
+{
+    if (pointer)
+    {
+        live -= malloc_usable_size(pointer);
+    }
+}
+
+} // namespace
+
+extern "C" void *malloc(size_t size)
+{
+    return tracked(__libc_malloc(size));
+}
+
+extern "C" void *calloc(size_t count, size_t size)
+{
+    return tracked(__libc_calloc(count, size));
+}
+
+extern "C" void *realloc(void *pointer, size_t size)
+{
+    untrack(pointer);
+    return tracked(__libc_realloc(pointer, size));
+}
+
+extern "C" void free(void *pointer)
+{
+    untrack(pointer);
+    __libc_free(pointer);
+}
+
+// ESP.getFreeHeap() follows the test's allocations, so MqttStats::heapCost is measured too
+static size_t liveAtStart = 0;
+
+uint32_t hostFreeHeap()
+{
+    return 40000 - (int32_t)(live - liveAtStart);
+}
+
+AsyncMqttClient *AsyncMqttClient::last = nullptr;
+ESP8266WiFiClass WiFi;
+
+// Config.cpp needs ArduinoJson for load and save, the exporter only reads the fields
+Config::Config() {}
+Config::~Config() {}
+String Config::getServerName() { return serverName; }
+
+namespace
+{
+
+Config config;
+MqttExporter exporter;
+
+struct Phase
+{
+    uint32_t ticks = 0;
+    size_t worstTransient = 0;
+};
+
+// One scheduler pass: the exporter's loop(), then the client's TCP callbacks
+void tick(Phase &phase)
+{
+    size_t before = live;
+    peak = live;
+    exporter.loop();
+    phase.ticks++;
+    phase.worstTransient = std::max(phase.worstTransient, peak - before);
+    AsyncMqttClient::last->poll();
+}
+
+template <typename Done>
+bool runUntil(Phase &phase, Done done, uint32_t timeoutMs = 10000)
+{
+    uint32_t start = millis();
+    while (!done())
+    {
+        if (millis() - start > timeoutMs)
+        {
+            return false;
+        }
+        tick(phase);
+    }
+    return true;
+}
+
+uint32_t percentile(std::vector<uint32_t> &values, int percent)
+{
+    if (values.empty())
+    {
+        return 0;
+    }
+    std::sort(values.begin(), values.end());
+    return values[std::min(values.size() - 1, values.size() * percent / 100)];
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    const char *host = "127.0.0.1";
+    int port = 18830;
+    int generations = 200;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        String option = argv[i];
+        if (option == "--host")
+        {
+            host = argv[i + 1];
+        }
+        else if (option == "--port")
+        {
+            port = atoi(argv[i + 1]);
+        }
+        else if (option == "--generations")
+        {
+            generations = atoi(argv[i + 1]);
+        }
+    }
+
+    config.mqttEnabled = true;
+    config.mqttHost = host;
+    config.mqttPort = port;
+
+    liveAtStart = live;
+    exporter.begin(&config);
+    size_t resident = live - liveAtStart;
+    AsyncMqttClient &client = *AsyncMqttClient::last;
+
+    bool ok = true;
+    Phase connect;
+    uint32_t connectStart = micros();
+    if (!runUntil(connect, [&]() { return exporter.isConnected(); }, 3000))
+    {
+        printf("FAIL no broker on %s:%d, start ./standin.py first\n", host, port);
+        return 1;
+    }
+    uint32_t connectUs = micros() - connectStart;
+
+    // "online" and one discovery config per tick, all of them retained
+    const uint32_t discoveries = 1 + 4 * 5;
+    Phase discovery;
+    ok &= runUntil(discovery, [&]() { return client.retainedPublishes == discoveries && client.acks == discoveries; });
+    size_t stateAcks = client.acks;
+
+    Phase states;
+    for (int generation = 0; generation < generations && ok; generation++)
+    {
+        for (uint8_t i = 0; i < 4; i++)
+        {
+            uint16_t voltage = generation % 2 ? 9000 : 5000;
+            exporter.record(i, true, voltage, 1500 + i * 100, generation % 2 ? "PD 9V" : "PD 5V", generation * 0.01f);
+        }
+        // Samples are far apart on the device, each generation is acknowledged before the next
+        uint32_t expected = discoveries + (generation + 1) * 4;
+        ok &= runUntil(states, [&]() { return exporter.queued() == 0 && client.acks == expected; });
+    }
+
+    // Drop the connection between a publish and its PUBACK, the latency figures must go on
+    // updating after the reconnect instead of waiting for a packet id that never comes back
+    uint32_t latencyBefore = exporter.stats().lastLatencyUs;
+    exporter.record(0, true, 12000, 1500, "PD 12V", 0);
+    exporter.loop();
+    client.disconnect(true);
+    Phase reconnect;
+    ok &= runUntil(reconnect, [&]() { return exporter.isConnected(); }, 5000);
+    size_t acksAfterReconnect = client.acks;
+    exporter.record(0, true, 5000, 1500, "PD 5V", 0);
+    ok &= runUntil(reconnect, [&]() { return exporter.queued() == 0 && client.acks >= acksAfterReconnect + 2; });
+    bool latencyResumed = exporter.stats().lastLatencyUs != latencyBefore;
+    ok &= latencyResumed;
+
+    std::vector<uint32_t> discoveryRtt(client.ackUs, client.ackUs + stateAcks);
+    std::vector<uint32_t> stateRtt(client.ackUs + stateAcks, client.ackUs + client.acks);
+    const MqttStats &stats = exporter.stats();
+    ok &= stats.published == (uint32_t)generations * 4 + 2 && stats.dropped == 0;
+
+    printf("%-4s mqtt exporter                %u states, %u dropped, %u connects, connected in %uus\n",
+           ok ? "ok" : "FAIL", stats.published, stats.dropped, stats.connects, connectUs);
+    printf("     reconnect                    latency %s after a lost PUBACK\n", latencyResumed ? "resumed" : "FROZE");
+    printf("     discovery PUBACK             median %uus, p95 %uus, max %uus\n", percentile(discoveryRtt, 50),
+           percentile(discoveryRtt, 95), percentile(discoveryRtt, 100));
+    printf("     state PUBACK                 median %uus, p95 %uus, max %uus, exporter max %uus\n",
+           percentile(stateRtt, 50), percentile(stateRtt, 95), percentile(stateRtt, 100), stats.maxLatencyUs);
+    // The stand-in client is not the size of the real one, only the exporter's own fields count
+    printf("     heap                         %u B of fields, %u B resident after begin(), heapCost %d B\n",
+           (unsigned)(sizeof(MqttExporter) - sizeof(AsyncMqttClient)), (unsigned)resident, stats.heapCost);
+    printf("     transient heap per tick      connect %u B, discovery %u B, states %u B\n",
+           (unsigned)connect.worstTransient, (unsigned)discovery.worstTransient, (unsigned)states.worstTransient);
+    return ok ? 0 : 1;
+}
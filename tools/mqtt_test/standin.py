@@ -0,0 +1,145 @@
+#!/usr/bin/env python3
+# Stands in for Mosquitto when testing MqttExporter: a single-process MQTT 3.1.1 broker.
+#
+#   ./standin.py --port 18830 --ack-delay 20
+#   ./mqtt_test --port 18830
+#
+# Accepts CONNECT, PUBLISH at QoS 0/1, SUBSCRIBE, PINGREQ and DISCONNECT; PUBACKs are held back
+# by --ack-delay ms to model the Wi-Fi round trip. Retained messages and the last will are kept
+# like a real broker, and a summary of what each client published is printed when it leaves.
+
+import argparse
+import asyncio
+import collections
+import struct
+import time
+
+CONNECT, CONNACK, PUBLISH, PUBACK = 1, 2, 3, 4
+SUBSCRIBE, SUBACK, PINGREQ, PINGRESP, DISCONNECT = 8, 9, 12, 13, 14
+
+
+async def read_packet(reader):
+    header = (await reader.readexactly(1))[0]
+    length, shift = 0, 0
+    while True:
+        byte = (await reader.readexactly(1))[0]
+        length |= (byte & 0x7F) << shift
+        shift += 7
+        if not byte & 0x80:
+            break
+    return header >> 4, header & 0x0F, await reader.readexactly(length)
+
+
+def encode_packet(kind, flags, body):
+    length, encoded = len(body), bytearray()
+    while True:
+        byte = length & 0x7F
+        length >>= 7
+        encoded.append(byte | (0x80 if length else 0))
+        if not length:
+            break
+    return bytes([kind << 4 | flags]) + bytes(encoded) + body
+
+
+def read_string(data, offset):
+    (length,) = struct.unpack_from(">H", data, offset)
+    return data[offset + 2:offset + 2 + length].decode(errors="replace"), offset + 2 + length
+
+
+class Broker:
+    def __init__(self, args):
+        self.args = args
+        self.retained = {}
+        self.subscribers = []
+
+    async def handle(self, reader, writer):
+        client, will = "?", None
+        topics = collections.Counter()
+        published = 0
+        started = time.monotonic()
+        try:
+            kind, _, body = await read_packet(reader)
+            if kind != CONNECT:
+                return
+            _, offset = read_string(body, 0)
+            connect_flags = body[offset + 1]
+            client, offset = read_string(body, offset + 4)
+            if connect_flags & 0x04:
+                will_topic, offset = read_string(body, offset)
+                will_payload, offset = read_string(body, offset)
+                will = (will_topic, will_payload.encode(), bool(connect_flags & 0x20))
+            writer.write(encode_packet(CONNACK, 0, b"\x00\x00"))
+
+            while True:
+                kind, flags, body = await read_packet(reader)
+                if kind == PUBLISH:
+                    topic, offset = read_string(body, 0)
+                    qos = (flags >> 1) & 3
+                    if qos:
+                        (packet_id,) = struct.unpack_from(">H", body, offset)
+                        offset += 2
+                        asyncio.get_running_loop().call_later(self.args.ack_delay / 1000, writer.write,
+                                                              encode_packet(PUBACK, 0, struct.pack(">H", packet_id)))
+                    self.deliver(topic, body[offset:], bool(flags & 1))
+                    topics[topic.rsplit("/", 2)[-2] if topic.startswith("homeassistant/") else topic] += 1
+                    published += 1
+                elif kind == SUBSCRIBE:
+                    (packet_id,) = struct.unpack_from(">H", body, 0)
+                    topic, _ = read_string(body, 2)
+                    self.subscribers.append((topic, writer))
+                    writer.write(encode_packet(SUBACK, 0, struct.pack(">HB", packet_id, 0)))
+                    for retained_topic, payload in self.retained.items():
+                        if self.matches(topic, retained_topic):
+                            writer.write(self.publish_packet(retained_topic, payload, True))
+                elif kind == PINGREQ:
+                    writer.write(encode_packet(PINGRESP, 0, b""))
+                elif kind == DISCONNECT:
+                    will = None
+                    break
+        except (asyncio.IncompleteReadError, ConnectionError):
+            pass
+        finally:
+            if will:
+                self.deliver(*will)
+            self.subscribers = [entry for entry in self.subscribers if entry[1] is not writer]
+            writer.close()
+            if self.args.verbose or published:
+                print("%s: %d publishes in %.1fs, %s" % (client, published, time.monotonic() - started,
+                                                       ", ".join("%s %d" % item for item in sorted(topics.items()))),
+                      flush=True)
+
+    def deliver(self, topic, payload, retain):
+        if retain:
+            self.retained[topic] = payload
+        for pattern, writer in self.subscribers:
+            if self.matches(pattern, topic):
+                writer.write(self.publish_packet(topic, payload, False))
+
+    @staticmethod
+    def publish_packet(topic, payload, retain):
+        encoded = topic.encode()
+        return encode_packet(PUBLISH, 1 if retain else 0, struct.pack(">H", len(encoded)) + encoded + payload)
+
+    @staticmethod
+    def matches(pattern, topic):
+        if pattern == "#" or pattern == topic:
+            return True
+        return pattern.endswith("/#") and topic.startswith(pattern[:-1])
+
+
+async def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("--host", default="127.0.0.1")
+    parser.add_argument("--port", type=int, default=18830)
+    parser.add_argument("--ack-delay", type=float, default=0, help="PUBACK delay in ms")
+    parser.add_argument("--verbose", action="store_true")
+    args = parser.parse_args()
+
+    broker = Broker(args)
+    server = await asyncio.start_server(broker.handle, args.host, args.port)
+    print("broker on %s:%d, PUBACK after %gms" % (args.host, args.port, args.ack_delay), flush=True)
+    await server.serve_forever()
+
+
+if __name__ == "__main__":
+    asyncio.run(main())
@@ -0,0 +1,391 @@
+#pragma once
+// The part of ArduinoJson 6 that MqttExporter uses, for hosts without `pio pkg install`.
+// The Makefile puts the real library ahead of this one when it is there.
+//
+// Like the real one, a document is a fixed pool: DynamicJsonDocument allocates it once and
+// StaticJsonDocument keeps it inline, so the heap the test measures is the heap the firmware
+// sees. Slots hold two pointers, so pools are scaled by the host pointer width. Linked
+// const char* values are not copied; String and char* values are, and members that do not fit
+// are dropped as ArduinoJson does.
+#include <Arduino.h>
+#include <type_traits>
+
+namespace json_subset
+{
+
+enum SlotType : uint8_t
+{
+    SLOT_NULL,
+    SLOT_BOOL,
+    SLOT_FLOAT,
+    SLOT_DOUBLE,
+    SLOT_SIGNED,
+    SLOT_UNSIGNED,
+    SLOT_STRING,
+    SLOT_OBJECT,
+    SLOT_ARRAY,
+};
+
+struct Slot
+{
+    const char *key;
+    Slot *next;
+    union
+    {
+        bool boolean;
+        double number;
+        long long integer;
+        unsigned long long unsignedInteger;
+        const char *text;
+        Slot *child;
+    };
+    SlotType type;
+};
+
+// Pools are sized for ESP8266 pointers
+constexpr size_t scaled(size_t capacity) { return capacity * sizeof(void *) / 4; }
+
+class Pool
+{
+public:
+    char *start = nullptr;
+    size_t capacity = 0;
+    size_t used = 0;
+    bool overflowed = false;
+
+    Slot *slot()
+    {
+        Slot *slot = (Slot *)take(sizeof(Slot), alignof(Slot));
+        if (slot)
+        {
+            memset(slot, 0, sizeof(Slot));
+        }
+        return slot;
+    }
+
+    const char *copy(const char *text)
+    {
+        size_t length = strlen(text) + 1;
+        char *copy = (char *)take(length, 1);
+        if (copy)
+        {
+            memcpy(copy, text, length);
+        }
+        return copy;
+    }
+
+private:
+    void *take(size_t size, size_t align)
+    {
+        size_t offset = (used + align - 1) & ~(align - 1);
+        if (offset + size > capacity)
+        {
+            overflowed = true;
+            return nullptr;
+        }
+        used = offset + size;
+        return start + offset;
+    }
+};
+
+} // namespace json_subset
+
+class JsonVariant
+{
+public:
+    JsonVariant(json_subset::Pool *pool, json_subset::Slot *slot) : pool(pool), slot(slot) {}
+
+    JsonVariant operator[](const char *key) const
+    {
+        using namespace json_subset;
+        if (!become(SLOT_OBJECT))
+        {
+            return JsonVariant(pool, nullptr);
+        }
+        Slot **tail = &slot->child;
+        for (; *tail; tail = &(*tail)->next)
+        {
+            if (strcmp((*tail)->key, key) == 0)
+            {
+                return JsonVariant(pool, *tail);
+            }
+        }
+        *tail = pool->slot();
+        if (*tail)
+        {
+            (*tail)->key = key;
+        }
+        return JsonVariant(pool, *tail);
+    }
+
+    JsonVariant operator[](int index) const
+    {
+        using namespace json_subset;
+        if (!become(SLOT_ARRAY))
+        {
+            return JsonVariant(pool, nullptr);
+        }
+        Slot **tail = &slot->child;
+        for (int i = 0;; i++, tail = &(*tail)->next)
+        {
+            if (!*tail && !(*tail = pool->slot()))
+            {
+                return JsonVariant(pool, nullptr);
+            }
+            if (i == index)
+            {
+                return JsonVariant(pool, *tail);
+            }
+        }
+    }
+
+    JsonVariant createNestedObject(const char *key) const
+    {
+        JsonVariant member = (*this)[key];
+        member.become(json_subset::SLOT_OBJECT);
+        return member;
+    }
+
+    const JsonVariant &operator=(const char *value) const
+    {
+        if (slot)
+        {
+            set(json_subset::SLOT_STRING);
+            slot->text = value;
+        }
+        return *this;
+    }
+    const JsonVariant &operator=(char *value) const { return setCopy(value); }
+    const JsonVariant &operator=(const String &value) const { return setCopy(value.c_str()); }
+    const JsonVariant &operator=(bool value) const
+    {
+        if (set(json_subset::SLOT_BOOL))
+        {
+            slot->boolean = value;
+        }
+        return *this;
+    }
+    const JsonVariant &operator=(double value) const
+    {
+        if (set(json_subset::SLOT_DOUBLE))
+        {
+            slot->number = value;
+        }
+        return *this;
+    }
+    const JsonVariant &operator=(float value) const
+    {
+        if (set(json_subset::SLOT_FLOAT))
+        {
+            slot->number = value;
+        }
+        return *this;
+    }
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value, const JsonVariant &>::type
+    operator=(T value) const
+    {
+        if (std::is_signed<T>::value ? set(json_subset::SLOT_SIGNED) : set(json_subset::SLOT_UNSIGNED))
+        {
+            slot->integer = value;
+        }
+        return *this;
+    }
+
+    bool isNull() const { return !slot || slot->type == json_subset::SLOT_NULL; }
+
+    // Writes up to size - 1 characters and always terminates, returns the full length
+    size_t write(char *out, size_t size, size_t length = 0) const { return write(slot, out, size, length); }
+
+protected:
+    json_subset::Pool *pool;
+    json_subset::Slot *slot;
+
+    bool set(json_subset::SlotType type) const
+    {
+        if (!slot)
+        {
+            return false;
+        }
+        slot->type = type;
+        return true;
+    }
+
+    bool become(json_subset::SlotType type) const
+    {
+        if (!slot || (slot->type != type && slot->type != json_subset::SLOT_NULL))
+        {
+            return false;
+        }
+        if (slot->type == json_subset::SLOT_NULL)
+        {
+            slot->type = type;
+            slot->child = nullptr;
+        }
+        return true;
+    }
+
+    const JsonVariant &setCopy(const char *value) const
+    {
+        const char *copy = slot ? pool->copy(value) : nullptr;
+        if (copy)
+        {
+            set(json_subset::SLOT_STRING);
+            slot->text = copy;
+        }
+        return *this;
+    }
+
+    static size_t put(char *out, size_t size, size_t length, const char *text, size_t count)
+    {
+        for (size_t i = 0; i < count; i++, length++)
+        {
+            if (length + 1 < size)
+            {
+                out[length] = text[i];
+            }
+        }
+        return length;
+    }
+
+    static size_t putString(char *out, size_t size, size_t length, const char *text)
+    {
+        length = put(out, size, length, "\"", 1);
+        for (; *text; text++)
+        {
+            char escaped[8];
+            if (*text == '"' || *text == '\\')
+            {
+                escaped[0] = '\\';
+                escaped[1] = *text;
+                length = put(out, size, length, escaped, 2);
+            }
+            else if ((uint8_t)*text < 0x20)
+            {
+                length = put(out, size, length, escaped, snprintf(escaped, sizeof(escaped), "\\u%04x", *text));
+            }
+            else
+            {
+                length = put(out, size, length, text, 1);
+            }
+        }
+        return put(out, size, length, "\"", 1);
+    }
+
+    static size_t write(const json_subset::Slot *slot, char *out, size_t size, size_t length)
+    {
+        using namespace json_subset;
+        char number[32];
+        switch (slot ? slot->type : SLOT_NULL)
+        {
+        case SLOT_NULL:
+            return put(out, size, length, "null", 4);
+        case SLOT_BOOL:
+            return slot->boolean ? put(out, size, length, "true", 4) : put(out, size, length, "false", 5);
+        case SLOT_FLOAT:
+            return put(out, size, length, number, snprintf(number, sizeof(number), "%.7g", slot->number));
+        case SLOT_DOUBLE:
+            return put(out, size, length, number, snprintf(number, sizeof(number), "%.9g", slot->number));
+        case SLOT_SIGNED:
+            return put(out, size, length, number, snprintf(number, sizeof(number), "%lld", slot->integer));
+        case SLOT_UNSIGNED:
+            return put(out, size, length, number, snprintf(number, sizeof(number), "%llu", slot->unsignedInteger));
+        case SLOT_STRING:
+            return putString(out, size, length, slot->text);
+        case SLOT_OBJECT:
+        case SLOT_ARRAY:
+        {
+            bool object = slot->type == SLOT_OBJECT;
+            length = put(out, size, length, object ? "{" : "[", 1);
+            for (const Slot *child = slot->child; child; child = child->next)
+            {
+                if (child != slot->child)
+                {
+                    length = put(out, size, length, ",", 1);
+                }
+                if (object)
+                {
+                    length = putString(out, size, length, child->key);
+                    length = put(out, size, length, ":", 1);
+                }
+                length = write(child, out, size, length);
+            }
+            return put(out, size, length, object ? "}" : "]", 1);
+        }
+        }
+        return length;
+    }
+};
+
+typedef JsonVariant JsonObject;
+
+class JsonDocument
+{
+public:
+    JsonDocument(const JsonDocument &) = delete;
+    JsonDocument &operator=(const JsonDocument &) = delete;
+
+    JsonVariant operator[](const char *key) { return root()[key]; }
+    JsonObject createNestedObject(const char *key) { return root().createNestedObject(key); }
+    JsonVariant as() { return root(); }
+
+    size_t capacity() const { return pool.capacity; }
+    size_t memoryUsage() const { return pool.used; }
+    bool overflowed() const { return pool.overflowed; }
+
+protected:
+    JsonDocument() { memset(&top, 0, sizeof(top)); }
+
+    json_subset::Pool pool;
+    json_subset::Slot top;
+
+    JsonVariant root() { return JsonVariant(&pool, &top); }
+};
+
+class DynamicJsonDocument : public JsonDocument
+{
+public:
+    explicit DynamicJsonDocument(size_t capacity)
+    {
+        pool.capacity = json_subset::scaled(capacity);
+        pool.start = (char *)malloc(pool.capacity);
+        if (!pool.start)
+        {
+            pool.capacity = 0;
+        }
+    }
+    ~DynamicJsonDocument() { free(pool.start); }
+};
+
+template <size_t N>
+class StaticJsonDocument : public JsonDocument
+{
+public:
+    StaticJsonDocument()
+    {
+        pool.start = buffer;
+        pool.capacity = sizeof(buffer);
+    }
+
+private:
+    alignas(json_subset::Slot) char buffer[json_subset::scaled(N)];
+};
+
+inline size_t serializeJson(JsonDocument &doc, char *out, size_t size)
+{
+    size_t length = doc.as().write(out, size);
+    if (size > 0)
+    {
+        out[min(length, size - 1)] = '\0';
+    }
+    return min(length, size > 0 ? size - 1 : 0);
+}
+
+inline size_t serializeJson(JsonDocument &doc, String &out)
+{
+    size_t length = doc.as().write(nullptr, 0);
+    out.s.resize(length + 1);
+    doc.as().write(&out.s[0], length + 1);
+    out.s.resize(length);
+    return length;
+}
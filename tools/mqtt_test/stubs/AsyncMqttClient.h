@@ -0,0 +1,275 @@
+#pragma once
+// Host stand-in for AsyncMqttClient: MQTT 3.1.1 over a plain socket. poll() plays the part of
+// the TCP callbacks, reading CONNACK and PUBACK and firing the handlers the exporter set.
+// Packets are built in a fixed buffer so the client adds nothing to the measured heap.
+#include <Arduino.h>
+#include <arpa/inet.h>
+#include <functional>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+enum class AsyncMqttClientDisconnectReason : uint8_t
+{
+    TCP_DISCONNECTED = 0,
+};
+
+class AsyncMqttClient
+{
+public:
+    typedef std::function<void(bool sessionPresent)> OnConnectUserCallback;
+    typedef std::function<void(AsyncMqttClientDisconnectReason reason)> OnDisconnectUserCallback;
+    typedef std::function<void(uint16_t packetId)> OnPublishUserCallback;
+
+    // Publish to PUBACK times of QoS 1 packets, in ack order
+    static constexpr size_t kMaxAcks = 4096;
+    uint32_t ackUs[kMaxAcks];
+    size_t acks = 0;
+    uint32_t publishes = 0;
+    uint32_t retainedPublishes = 0;
+
+    static AsyncMqttClient *last;
+
+    AsyncMqttClient() { last = this; }
+    ~AsyncMqttClient()
+    {
+        // The owner is going away, it must not hear about this disconnect
+        disconnectCallback = nullptr;
+        disconnect();
+    }
+
+    AsyncMqttClient &onConnect(OnConnectUserCallback callback)
+    {
+        connectCallback = callback;
+        return *this;
+    }
+    AsyncMqttClient &onDisconnect(OnDisconnectUserCallback callback)
+    {
+        disconnectCallback = callback;
+        return *this;
+    }
+    AsyncMqttClient &onPublish(OnPublishUserCallback callback)
+    {
+        publishCallback = callback;
+        return *this;
+    }
+    AsyncMqttClient &setServer(const char *host, uint16_t port)
+    {
+        this->host = host;
+        this->port = port;
+        return *this;
+    }
+    AsyncMqttClient &setClientId(const char *clientId)
+    {
+        this->clientId = clientId;
+        return *this;
+    }
+    AsyncMqttClient &setCredentials(const char *user, const char *password)
+    {
+        this->user = user;
+        this->password = password;
+        return *this;
+    }
+    AsyncMqttClient &setWill(const char *topic, uint8_t qos, bool retain, const char *payload, size_t length = 0)
+    {
+        willTopic = topic;
+        willPayload = payload;
+        willFlags = 0x04 | (qos & 3) << 3 | (retain ? 0x20 : 0);
+        return *this;
+    }
+
+    bool connected() const { return isConnected; }
+
+    void connect()
+    {
+        disconnect();
+        sock = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(port);
+        inet_pton(AF_INET, host, &address.sin_addr);
+        if (::connect(sock, (sockaddr *)&address, sizeof(address)) != 0)
+        {
+            disconnect();
+            return;
+        }
+        int one = 1;
+        setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        uint8_t flags = 0x02 | willFlags | (user ? 0xC0 : 0);
+        size_t length = 0;
+        length += putString(body + length, "MQTT");
+        body[length++] = 4;
+        body[length++] = flags;
+        body[length++] = 0;
+        body[length++] = 15; // keep alive, seconds
+        length += putString(body + length, clientId);
+        if (willFlags)
+        {
+            length += putString(body + length, willTopic);
+            length += putString(body + length, willPayload);
+        }
+        if (user)
+        {
+            length += putString(body + length, user);
+            length += putString(body + length, password);
+        }
+        send(0x10, length);
+    }
+
+    void disconnect(bool force = false)
+    {
+        if (sock >= 0)
+        {
+            if (isConnected && !force)
+            {
+                send(0xE0, 0);
+            }
+            close(sock);
+        }
+        bool wasConnected = isConnected;
+        sock = -1;
+        isConnected = false;
+        if (wasConnected && disconnectCallback)
+        {
+            disconnectCallback(AsyncMqttClientDisconnectReason::TCP_DISCONNECTED);
+        }
+    }
+
+    uint16_t publish(const char *topic, uint8_t qos, bool retain, const char *payload = nullptr, size_t length = 0,
+                     bool dup = false, uint16_t messageId = 0)
+    {
+        if (!isConnected)
+        {
+            return 0;
+        }
+        if (payload && length == 0)
+        {
+            length = strlen(payload);
+        }
+
+        size_t size = putString(body, topic);
+        uint16_t packetId = 1;
+        if (qos > 0)
+        {
+            packetId = nextPacketId++;
+            if (nextPacketId == 0)
+            {
+                nextPacketId = 1;
+            }
+            body[size++] = packetId >> 8;
+            body[size++] = packetId & 0xFF;
+            sentUs[packetId % kInFlight] = micros();
+        }
+        if (size + length > sizeof(body))
+        {
+            return 0;
+        }
+        memcpy(body + size, payload, length);
+        if (!send(0x30 | (qos & 3) << 1 | (retain ? 1 : 0), size + length))
+        {
+            return 0;
+        }
+        publishes++;
+        retainedPublishes += retain;
+        return packetId;
+    }
+
+    // Read what the broker sent and fire the callbacks
+    void poll()
+    {
+        while (sock >= 0)
+        {
+            ssize_t received = recv(sock, input + inputLength, sizeof(input) - inputLength, MSG_DONTWAIT);
+            if (received == 0)
+            {
+                disconnect(true);
+                return;
+            }
+            if (received < 0)
+            {
+                return;
+            }
+            inputLength += received;
+
+            // CONNACK and PUBACK are the only packets the exporter expects, both 4 bytes
+            size_t offset = 0;
+            while (inputLength - offset >= 4)
+            {
+                uint8_t type = input[offset] >> 4;
+                uint16_t value = input[offset + 2] << 8 | input[offset + 3];
+                offset += 2 + input[offset + 1];
+                if (type == 2 && (value & 0xFF) == 0)
+                {
+                    isConnected = true;
+                    if (connectCallback)
+                    {
+                        connectCallback(false);
+                    }
+                }
+                else if (type == 4)
+                {
+                    if (acks < kMaxAcks)
+                    {
+                        ackUs[acks++] = micros() - sentUs[value % kInFlight];
+                    }
+                    if (publishCallback)
+                    {
+                        publishCallback(value);
+                    }
+                }
+            }
+            memmove(input, input + offset, inputLength - offset);
+            inputLength -= offset;
+        }
+    }
+
+private:
+    static constexpr size_t kInFlight = 256;
+
+    OnConnectUserCallback connectCallback;
+    OnDisconnectUserCallback disconnectCallback;
+    OnPublishUserCallback publishCallback;
+    const char *host = "127.0.0.1";
+    uint16_t port = 1883;
+    const char *clientId = "";
+    const char *user = nullptr;
+    const char *password = nullptr;
+    const char *willTopic = nullptr;
+    const char *willPayload = nullptr;
+    uint8_t willFlags = 0;
+    int sock = -1;
+    bool isConnected = false;
+    uint16_t nextPacketId = 1;
+    uint32_t sentUs[kInFlight] = {0};
+    uint8_t packet[2048];
+    uint8_t body[2040];
+    uint8_t input[256];
+    size_t inputLength = 0;
+
+    static size_t putString(uint8_t *out, const char *text)
+    {
+        size_t length = strlen(text);
+        out[0] = length >> 8;
+        out[1] = length & 0xFF;
+        memcpy(out + 2, text, length);
+        return length + 2;
+    }
+
+    bool send(uint8_t header, size_t length)
+    {
+        size_t size = 0;
+        packet[size++] = header;
+        size_t remaining = length;
+        do
+        {
+            uint8_t byte = remaining & 0x7F;
+            remaining >>= 7;
+            packet[size++] = byte | (remaining ? 0x80 : 0);
+        } while (remaining);
+        memcpy(packet + size, body, length);
+        size += length;
+        return ::send(sock, packet, size, MSG_NOSIGNAL) == (ssize_t)size;
+    }
+};
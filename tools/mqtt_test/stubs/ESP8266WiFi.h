@@ -0,0 +1,12 @@
+#pragma once
+// The link is always up on the host, the broker stand-in decides what happens next
+#include <Arduino.h>
+
+#define WL_CONNECTED 3
+
+class ESP8266WiFiClass
+{
+public:
+    int status() { return WL_CONNECTED; }
+};
+extern ESP8266WiFiClass WiFi;
@@ -0,0 +1,99 @@
+#!/usr/bin/env python3
+# Host test of the image compression in platformio_upload.py, run with `make test`.
+#
+#   ./test_upload.py [image ...]
+#
+# Loads the upload script with stand-ins for SCons and the HTTP modules, then checks that
+# firmware images are gzipped and inflate back to the same bytes within the 32 KB window
+# eboot uses, and that filesystem and already gzipped images go out untouched. Every image
+# given (by default the firmware.bin of each built PlatformIO env) is measured: bytes sent
+# and the transfer time they take at --rate KB/s.
+
+import argparse
+import gzip
+import os
+import random
+import sys
+import types
+import zlib
+
+ROOT = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "..")
+
+
+class StandinEnv:
+    def Replace(self, **kwargs):
+        pass
+
+    def Execute(self, command):
+        pass
+
+    def GetProjectOption(self, name, default=None):
+        return default
+
+
+def load_upload_script():
+    for name in ("requests", "requests.auth", "requests_toolbelt", "tqdm"):
+        sys.modules.setdefault(name, types.ModuleType(name))
+    sys.modules["requests.auth"].HTTPDigestAuth = object
+    sys.modules["requests_toolbelt"].MultipartEncoder = object
+    sys.modules["requests_toolbelt"].MultipartEncoderMonitor = object
+    sys.modules["tqdm"].tqdm = object
+
+    script = {"__name__": "platformio_upload"}
+    script["Import"] = lambda name: script.__setitem__(name, StandinEnv())
+    path = os.path.join(ROOT, "platformio_upload.py")
+    with open(path) as source:
+        exec(compile(source.read(), path, "exec"), script)
+    return script["prepare_image"]
+
+
+def inflate(data):
+    # eboot inflates with a 32 KB dictionary, the largest window deflate may reference
+    inflater = zlib.decompressobj(16 + 15)
+    return inflater.decompress(data) + inflater.flush()
+
+
+# Code-like bytes: a small vocabulary of words repeated with noise, plus a random tail
+def synthetic_image(size):
+    rng = random.Random(1)
+    words = [rng.randbytes(4) for _ in range(512)]
+    body = b"".join(rng.choice(words) for _ in range(size * 3 // 16))
+    return body + rng.randbytes(size - len(body))
+
+
+def check(name, condition):
+    print(f"{'ok' if condition else 'FAIL':4} {name}")
+    return condition
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("images", nargs="*")
+    parser.add_argument("--rate", type=float, default=40, help="OTA throughput in KB/s")
+    args = parser.parse_args()
+
+    prepare_image = load_upload_script()
+    image = synthetic_image(400 * 1024)
+    sent, mode = prepare_image("firmware.bin", image)
+    ok = check("firmware is gzipped", mode == "fr" and sent[:2] == b"\x1f\x8b")
+    ok &= check("firmware inflates to the image", inflate(sent) == image)
+    ok &= check("gzipped firmware is sent as is", prepare_image("firmware.bin", sent)[0] == sent)
+    ok &= check("custom_upload_compress = no", prepare_image("firmware.bin", image, False)[0] == image)
+    for name in ("littlefs.bin", "spiffs.bin"):
+        ok &= check(f"{name} is sent raw", prepare_image(name, image) == (image, "fs"))
+
+    for path in args.images:
+        with open(path, "rb") as file:
+            raw = file.read()
+        sent, _ = prepare_image(os.path.basename(path), raw)
+        ok &= check(f"{path} inflates to the image", inflate(sent) == raw)
+        print(f"     {len(raw)} -> {len(sent)} bytes ({100 * len(sent) / len(raw):.1f}%), "
+              f"{len(raw) / 1024 / args.rate:.1f}s -> {len(sent) / 1024 / args.rate:.1f}s at {args.rate:g} KB/s")
+    if not args.images:
+        print("     no image given, nothing measured")
+
+    return 0 if ok else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,339 @@
+// Replays a /capture/download file through the firmware sampling path on the host.
+//
+//   ./capture_replay capture.bin                 per-port summary and replay timing
+//   ./capture_replay capture.bin --csv out.csv   also every derived sample, one line per record
+//   ./capture_replay capture.bin --repeat 100    replay the file n times for steadier timing
+//
+// Each record's register bytes are loaded into the mock TwoWire from ../bench/stubs, then
+// PortItem::update() and PortItem::applySample(), which takes samplePort()'s breaker and energy
+// decisions, run unchanged and InfoPage draws the port line, as fast as the host allows. Reads
+// that failed on the device are replayed as NACKs, so the breaker sees the same failures.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <Adafruit_SH110x.h>
+#include <Arduino.h>
+#include <Wire.h>
+
+#include "CaptureFormat.h"
+#include "InfoPage.h"
+#include "PortItem.h"
+
+namespace
+{
+
+constexpr int kScreenWidth = 128;
+constexpr int kScreenHeight = 64;
+constexpr uint8_t kChargerAddress = 0x3c;
+// Nothing answers here, every transfer is NACKed
+constexpr uint8_t kNoDevice = 0x7f;
+
+struct Options
+{
+    std::string capture;
+    std::string csv;
+    int repeat = 1;
+};
+
+struct PortSummary
+{
+    uint32_t records = 0;
+    uint32_t valid = 0;
+    uint32_t failed = 0;
+    uint32_t absent = 0;
+    // Reads the device made but the replayed breaker would have skipped
+    uint32_t skipped = 0;
+    // Records whose replayed result differs from the captured one
+    uint32_t mismatches = 0;
+    float minVoltage = 0;
+    float maxVoltage = 0;
+    float maxCurrent = 0;
+    float maxPower = 0;
+    double energy = 0;
+    uint32_t protocolChanges = 0;
+    String protocol;
+};
+
+// Keeps results alive so the optimizer cannot drop the work
+volatile uint32_t sink = 0;
+
+void usage()
+{
+    fprintf(stderr, "usage: capture_replay capture.bin [--csv file] [--repeat n]\n");
+    exit(2);
+}
+
+bool readCapture(const std::string &path, CaptureHeader &header, std::vector<CaptureRecord> &records)
+{
+    FILE *file = fopen(path.c_str(), "rb");
+    if (!file)
+    {
+        fprintf(stderr, "cannot read %s\n", path.c_str());
+        return false;
+    }
+
+    bool ok = fread(&header, sizeof(header), 1, file) == 1 && header.magic == kCaptureMagic;
+    if (!ok || header.version != kCaptureVersion || header.recordSize != sizeof(CaptureRecord))
+    {
+        fprintf(stderr, "%s is not a version %u capture\n", path.c_str(), kCaptureVersion);
+        fclose(file);
+        return false;
+    }
+
+    CaptureRecord record;
+    while (fread(&record, sizeof(record), 1, file) == 1)
+    {
+        records.push_back(record);
+    }
+    fclose(file);
+    return true;
+}
+
+class Replay
+{
+public:
+    Replay(const CaptureHeader &header, FILE *csv) : csv(csv), display(kScreenWidth, kScreenHeight)
+    {
+        hoursPerSample = header.sampleIntervalMs / 3600000.0;
+        page.begin();
+        for (uint8_t i = 0; i < header.portCount && i < kSnapshotPortsMax; i++)
+        {
+            ports.push_back(std::unique_ptr<PortItem>(new PortItem()));
+        }
+        summaries.resize(ports.size());
+    }
+
+    // Same steps as samplePort() in main.cpp, minus the logging and exporters
+    void sample(const CaptureRecord &record)
+    {
+        if (record.port >= ports.size())
+        {
+            return;
+        }
+
+        PortItem &port = *ports[record.port];
+        PortSummary &summary = summaries[record.port];
+        summary.records++;
+        uint8_t result = record.result;
+
+        if (!port.sampleAllowed(record.timeMs))
+        {
+            summary.skipped++;
+        }
+        else
+        {
+            bool present = record.result != kCapturePortAbsent;
+            if (present)
+            {
+                loadRegisters(record);
+                result = port.update();
+            }
+
+            float energy = 0;
+            switch (port.applySample(present, (SW35xx::result_t)result, record.timeMs, hoursPerSample, energy))
+            {
+            case SAMPLE_ABSENT:
+                summary.absent++;
+                break;
+            case SAMPLE_OK:
+                summary.energy += energy;
+                account(port, summary);
+                break;
+            default:
+                summary.failed++;
+                break;
+            }
+            if (present && (result == SW35xx::RESULT_OK) != (record.result == SW35xx::RESULT_OK))
+            {
+                summary.mismatches++;
+            }
+        }
+
+        drawPort(record.port);
+        if (csv)
+        {
+            fprintf(csv, "%u,%u,%u,%u,%u,%.3f,%.3f,%.3f,%.3f,%.6f,%s,%u\n", record.timeMs, record.port + 1, result,
+                    port.valid, port.isActive, port.voltage, port.current, port.inputVoltage, port.getPower(),
+                    summary.energy, port.protocol.c_str(), port.health.state());
+        }
+    }
+
+    const std::vector<PortSummary> &results() const
+    {
+        return summaries;
+    }
+
+    uint32_t trips(uint8_t port) const
+    {
+        return ports[port]->health.stats().trips;
+    }
+
+private:
+    static constexpr uint8_t kSnapshotPortsMax = 4;
+
+    FILE *csv;
+    float hoursPerSample = 0;
+    std::vector<std::unique_ptr<PortItem>> ports;
+    std::vector<PortSummary> summaries;
+    Adafruit_SH1106G display;
+    InfoPage page;
+
+    void loadRegisters(const CaptureRecord &record)
+    {
+        if (record.result != SW35xx::RESULT_OK)
+        {
+            Wire.deviceAddress = kNoDevice;
+            return;
+        }
+        Wire.deviceAddress = kChargerAddress;
+        for (uint8_t i = 0; i < kCaptureRegisterCount; i++)
+        {
+            Wire.registers[kCaptureRegisters[i]] = record.registers[i];
+        }
+    }
+
+    void account(const PortItem &port, PortSummary &summary)
+    {
+        if (summary.valid == 0)
+        {
+            summary.minVoltage = port.voltage;
+            summary.maxVoltage = port.voltage;
+        }
+        summary.valid++;
+        summary.minVoltage = std::min(summary.minVoltage, port.voltage);
+        summary.maxVoltage = std::max(summary.maxVoltage, port.voltage);
+        summary.maxCurrent = std::max(summary.maxCurrent, port.current);
+        summary.maxPower = std::max(summary.maxPower, port.getPower());
+        if (port.protocol != summary.protocol)
+        {
+            summary.protocolChanges++;
+            summary.protocol = port.protocol;
+        }
+    }
+
+    // The port line displayInfo() draws
+    void drawPort(uint8_t index)
+    {
+        FrameBuffer frame = {display.getBuffer(), kScreenWidth, kScreenHeight};
+        int yPos = 18 + (index * 13);
+        display.fillRect(0, yPos, kScreenWidth, 8, SH110X_BLACK);
+        page.drawPort(frame, index, *ports[index]);
+        sink += display.getBuffer()[yPos / 8 * kScreenWidth];
+    }
+};
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    Options options;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        auto value = [&]() -> std::string
+        {
+            if (i + 1 >= argc)
+            {
+                usage();
+            }
+            return argv[++i];
+        };
+
+        if (arg == "--csv")
+        {
+            options.csv = value();
+        }
+        else if (arg == "--repeat")
+        {
+            options.repeat = std::max(1, atoi(value().c_str()));
+        }
+        else if (arg[0] != '-' && options.capture.empty())
+        {
+            options.capture = arg;
+        }
+        else
+        {
+            usage();
+        }
+    }
+    if (options.capture.empty())
+    {
+        usage();
+    }
+
+    CaptureHeader header;
+    std::vector<CaptureRecord> records;
+    if (!readCapture(options.capture, header, records))
+    {
+        return 2;
+    }
+    if (records.empty())
+    {
+        fprintf(stderr, "%s holds no records\n", options.capture.c_str());
+        return 2;
+    }
+
+    FILE *csv = nullptr;
+    if (!options.csv.empty())
+    {
+        csv = fopen(options.csv.c_str(), "w");
+        if (!csv)
+        {
+            fprintf(stderr, "cannot write %s\n", options.csv.c_str());
+            return 2;
+        }
+        fprintf(csv, "timeMs,port,result,valid,active,voltage,current,inputVoltage,power,energy,protocol,breaker\n");
+    }
+
+    // Every repeat starts from fresh ports, only the first one writes the CSV
+    std::unique_ptr<Replay> replay;
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < options.repeat; r++)
+    {
+        replay.reset(new Replay(header, r == 0 ? csv : nullptr));
+        for (const CaptureRecord &record : records)
+        {
+            replay->sample(record);
+        }
+    }
+    double elapsedNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    if (csv)
+    {
+        fclose(csv);
+    }
+
+    uint32_t spanMs = records.back().timeMs - records.front().timeMs;
+    printf("capture   chip %08x, %zu records over %.1fs, sample interval %ums\n", header.chipId, records.size(),
+           spanMs / 1000.0, header.sampleIntervalMs);
+    printf("port  records  valid  failed  absent  skipped  trips  mismatch  volts            max A   max W   energy Wh  protocol\n");
+    uint32_t mismatches = 0;
+    const std::vector<PortSummary> &summaries = replay->results();
+    for (size_t i = 0; i < summaries.size(); i++)
+    {
+        const PortSummary &port = summaries[i];
+        mismatches += port.mismatches;
+        printf("P%-4zu %7u %6u %7u %7u %8u %6u %9u  %6.3f - %6.3f  %6.3f  %6.2f  %10.6f  %s (%u changes)\n", i + 1,
+               port.records, port.valid, port.failed, port.absent, port.skipped, replay->trips(i), port.mismatches,
+               port.minVoltage, port.maxVoltage, port.maxCurrent, port.maxPower, port.energy,
+               port.protocol.length() ? port.protocol.c_str() : "-", port.protocolChanges);
+    }
+
+    double replayed = (double)records.size() * options.repeat;
+    double nsPerRecord = elapsedNs / replayed;
+    printf("replay    %.0f ns/record", nsPerRecord);
+    if (spanMs > 0)
+    {
+        printf(", %.0fx real time", spanMs * 1e6 * options.repeat / elapsedNs);
+    }
+    printf("\n");
+
+    // Failures the device saw that the replay did not reproduce, or the other way round
+    return mismatches > 0 ? 1 : 0;
+}
@@ -0,0 +1,315 @@
+// Bytes per sample and encode/decode throughput of SeriesCodec on charging profiles.
+//
+//   ./series_bench                     built-in profiles, 24 h each
+//   ./series_bench --csv capture.csv   recorded points: time,v1,v2,v3,v4,c1,c2,c3,c4 (mV, mA)
+//   ./series_bench --block 256 --json
+//
+// Points are cut into blocks exactly like HistoryStore does, so the numbers include the
+// per-block restart cost. Every run decodes what it encoded and fails on any mismatch.
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "SeriesCodec.h"
+
+namespace
+{
+
+constexpr uint8_t kChannels = 8; // 4 voltages then 4 currents, as in HistoryStore
+constexpr size_t kRawPointBytes = 4 + kChannels * 2;
+constexpr uint16_t kMaxBlockPoints = 60;
+
+struct Point
+{
+    uint32_t time;
+    uint16_t values[kChannels];
+};
+
+struct Profile
+{
+    std::string name;
+    std::vector<Point> points;
+};
+
+struct Block
+{
+    std::vector<uint8_t> data;
+    uint16_t count;
+};
+
+uint16_t noisy(std::mt19937 &rng, int value, int spread)
+{
+    std::uniform_int_distribution<int> noise(-spread, spread);
+    return value <= 0 ? 0 : std::max(0, value + noise(rng));
+}
+
+Profile makeProfile(const std::string &name, uint32_t interval, uint32_t seconds)
+{
+    Profile profile{name, {}};
+    std::mt19937 rng(42);
+    uint32_t start = 1700000000;
+    // Session state for the mixed profile
+    int rail[4] = {0, 0, 0, 0};
+    int load[4] = {0, 0, 0, 0};
+    uint32_t until[4] = {0, 0, 0, 0};
+
+    for (uint32_t t = 0; t < seconds; t += interval)
+    {
+        Point point = {start + t, {0}};
+        if (name == "pd-fixed" || name == "pd-fixed-1hz")
+        {
+            point.values[0] = noisy(rng, 20000, 8);
+            // Constant-current phase, then taper
+            int current = t < seconds / 2 ? 2500 : 2500 * (seconds - t) / (seconds / 2);
+            point.values[4] = noisy(rng, current, 25);
+        }
+        else if (name == "pps")
+        {
+            // Battery voltage climbing in 20 mV PPS steps
+            int voltage = 6600 + (int)(t * 4000 / seconds) / 20 * 20;
+            point.values[0] = voltage;
+            point.values[4] = noisy(rng, 3000, 15);
+            point.values[1] = 5000;
+            point.values[5] = noisy(rng, 1000, 10);
+        }
+        else if (name == "mixed")
+        {
+            static const int rails[] = {5000, 9000, 12000, 15000, 20000};
+            for (int p = 0; p < 4; p++)
+            {
+                if (t >= until[p])
+                {
+                    bool plugged = rng() % 3 != 0;
+                    rail[p] = plugged ? rails[rng() % 5] : 0;
+                    load[p] = plugged ? 300 + rng() % 2700 : 0;
+                    until[p] = t + 600 + rng() % 7200;
+                }
+                point.values[p] = noisy(rng, rail[p], 10);
+                point.values[4 + p] = noisy(rng, load[p], 20);
+            }
+        }
+        // "idle" keeps every channel at zero
+        profile.points.push_back(point);
+    }
+    return profile;
+}
+
+bool loadCsv(const char *path, Profile &profile)
+{
+    std::ifstream file(path);
+    if (!file)
+    {
+        return false;
+    }
+    profile.name = path;
+    std::string line;
+    while (std::getline(file, line))
+    {
+        if (line.empty() || !isdigit((unsigned char)line[0]))
+        {
+            continue;
+        }
+        std::stringstream fields(line);
+        std::string field;
+        Point point = {0, {0}};
+        std::getline(fields, field, ',');
+        point.time = strtoul(field.c_str(), nullptr, 10);
+        for (int i = 0; i < kChannels && std::getline(fields, field, ','); i++)
+        {
+            point.values[i] = atoi(field.c_str());
+        }
+        profile.points.push_back(point);
+    }
+    return !profile.points.empty();
+}
+
+std::vector<Block> encode(const std::vector<Point> &points, size_t blockBytes)
+{
+    std::vector<Block> blocks;
+    SeriesEncoder encoder;
+    Block current{std::vector<uint8_t>(blockBytes), 0};
+    encoder.reset(current.data.data(), blockBytes, kChannels);
+
+    auto seal = [&]()
+    {
+        current.data.resize(encoder.length());
+        current.count = encoder.count();
+        blocks.push_back(std::move(current));
+        current = Block{std::vector<uint8_t>(blockBytes), 0};
+        encoder.reset(current.data.data(), blockBytes, kChannels);
+    };
+
+    for (const Point &point : points)
+    {
+        if (!encoder.append(point.time, point.values))
+        {
+            seal();
+            encoder.append(point.time, point.values);
+        }
+        if (encoder.count() == kMaxBlockPoints)
+        {
+            seal();
+        }
+    }
+    if (encoder.count() > 0)
+    {
+        seal();
+    }
+    return blocks;
+}
+
+size_t decode(const std::vector<Block> &blocks, std::vector<Point> *out)
+{
+    SeriesDecoder decoder;
+    Point point;
+    size_t decoded = 0;
+    for (const Block &block : blocks)
+    {
+        decoder.reset(block.data.data(), block.data.size(), kChannels, block.count);
+        while (decoder.next(point.time, point.values))
+        {
+            if (out)
+            {
+                out->push_back(point);
+            }
+            decoded++;
+        }
+    }
+    return decoded;
+}
+
+template <typename F>
+double secondsPerRun(F run, int &iterations)
+{
+    using Clock = std::chrono::steady_clock;
+    iterations = 0;
+    auto start = Clock::now();
+    double elapsed = 0;
+    // At least 0.2 s of work so short profiles still give stable numbers
+    while (elapsed < 0.2)
+    {
+        run();
+        iterations++;
+        elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    }
+    return elapsed / iterations;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    size_t blockBytes = 256;
+    bool json = false;
+    std::vector<Profile> profiles;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--block") && i + 1 < argc)
+        {
+            blockBytes = std::max<size_t>(kSeriesMaxPointBytes, atoi(argv[++i]));
+        }
+        else if (!strcmp(argv[i], "--csv") && i + 1 < argc)
+        {
+            Profile profile;
+            if (!loadCsv(argv[++i], profile))
+            {
+                fprintf(stderr, "no points in %s\n", argv[i]);
+                return 1;
+            }
+            profiles.push_back(profile);
+        }
+        else if (!strcmp(argv[i], "--json"))
+        {
+            json = true;
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [--csv FILE]... [--block BYTES] [--json]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    if (profiles.empty())
+    {
+        for (const char *name : {"idle", "pd-fixed", "pps", "mixed"})
+        {
+            profiles.push_back(makeProfile(name, 10, 86400));
+        }
+        profiles.push_back(makeProfile("pd-fixed-1hz", 1, 3600));
+    }
+
+    if (json)
+    {
+        printf("[");
+    }
+    else
+    {
+        printf("%-16s %8s %8s %8s %7s %9s %12s %12s\n", "profile", "points", "blocks", "bytes", "B/pt", "ratio", "enc pt/s", "dec pt/s");
+    }
+
+    int status = 0;
+    for (size_t p = 0; p < profiles.size(); p++)
+    {
+        const Profile &profile = profiles[p];
+        std::vector<Block> blocks = encode(profile.points, blockBytes);
+        size_t bytes = 0;
+        for (const Block &block : blocks)
+        {
+            bytes += block.data.size();
+        }
+
+        std::vector<Point> roundTrip;
+        decode(blocks, &roundTrip);
+        bool exact = roundTrip.size() == profile.points.size();
+        for (size_t i = 0; exact && i < roundTrip.size(); i++)
+        {
+            exact = roundTrip[i].time == profile.points[i].time &&
+                    !memcmp(roundTrip[i].values, profile.points[i].values, sizeof(roundTrip[i].values));
+        }
+        if (!exact)
+        {
+            fprintf(stderr, "%s: decoded points differ from the input\n", profile.name.c_str());
+            status = 1;
+        }
+
+        int encodeRuns;
+        int decodeRuns;
+        size_t sink = 0;
+        double encodeSeconds = secondsPerRun([&]
+                                             { sink += encode(profile.points, blockBytes).size(); }, encodeRuns);
+        double decodeSeconds = secondsPerRun([&]
+                                             { sink += decode(blocks, nullptr); }, decodeRuns);
+
+        size_t count = profile.points.size();
+        double perPoint = (double)bytes / count;
+        double ratio = (double)(count * kRawPointBytes) / bytes;
+        if (json)
+        {
+            printf("%s{\"profile\":\"%s\",\"points\":%zu,\"blocks\":%zu,\"bytes\":%zu,\"bytesPerPoint\":%.3f,"
+                   "\"bytesPerSample\":%.3f,\"ratio\":%.2f,\"encodePointsPerSecond\":%.0f,\"decodePointsPerSecond\":%.0f,"
+                   "\"exact\":%s,\"sink\":%zu}",
+                   p ? "," : "", profile.name.c_str(), count, blocks.size(), bytes, perPoint, perPoint / kChannels, ratio,
+                   count / encodeSeconds, count / decodeSeconds, exact ? "true" : "false", sink);
+        }
+        else
+        {
+            printf("%-16s %8zu %8zu %8zu %7.2f %8.1fx %12.0f %12.0f\n", profile.name.c_str(), count, blocks.size(), bytes, perPoint, ratio,
+                   count / encodeSeconds, count / decodeSeconds);
+        }
+    }
+
+    if (json)
+    {
+        printf("]\n");
+    }
+    return status;
+}
@@ -0,0 +1,211 @@
+// Listens for the SW351x UDP telemetry broadcast and prints one line per sample generation.
+//
+//   ./telemetry_receiver [--port 35180] [--group 239.x.x.x] [--quiet]
+//   ./telemetry_receiver --bench [packets]
+//
+// Lost datagrams are detected per device from gaps in the sequence counter.
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <vector>
+
+#include "TelemetryPacket.h"
+
+namespace
+{
+
+struct DeviceStats
+{
+    uint32_t lastSequence = 0;
+    uint64_t received = 0;
+    uint64_t lost = 0;
+    bool seen = false;
+};
+
+const char *protocolName(uint8_t protocol)
+{
+    static const char *names[] = {"NONE", "QC2.0", "QC3.0", "FCP", "SCP", "PD FIX", "PD PPS", "PE1.1", "PE2.0", "LVDC", "SFCP", "AFC"};
+    return protocol < sizeof(names) / sizeof(names[0]) ? names[protocol] : "?";
+}
+
+void track(std::map<uint32_t, DeviceStats> &devices, const TelemetryPacket &packet)
+{
+    DeviceStats &stats = devices[packet.chipId];
+    if (stats.seen)
+    {
+        uint32_t gap = packet.sequence - stats.lastSequence;
+        // A device reboot restarts the counter, do not count that as loss
+        if (gap > 1 && gap < 0x80000000u)
+        {
+            stats.lost += gap - 1;
+        }
+    }
+    stats.seen = true;
+    stats.lastSequence = packet.sequence;
+    stats.received++;
+}
+
+void print(const TelemetryPacket &packet, const DeviceStats &stats)
+{
+    printf("%08x seq=%u up=%us temp=%.2fC fan=%u state=%u", packet.chipId, packet.sequence, packet.uptimeMs / 1000,
+           packet.temperature / 100.0, packet.fanDuty, packet.state);
+    for (uint8_t i = 0; i < kTelemetryPorts; i++)
+    {
+        const TelemetryPortSample &port = packet.ports[i];
+        if (!(port.flags & TELEMETRY_PORT_ACTIVE))
+        {
+            printf(" | P%u off", i + 1);
+            continue;
+        }
+        printf(" | P%u %.2fV %.2fA %s %.2fWh%s", i + 1, port.voltage_mV / 1000.0, port.current_mA / 1000.0,
+               protocolName(port.protocol), port.energy, (port.flags & TELEMETRY_PORT_INVALID) ? " (stale)" : "");
+    }
+    printf(" | lost=%llu/%llu\n", (unsigned long long)stats.lost, (unsigned long long)(stats.lost + stats.received));
+    fflush(stdout);
+}
+
+// Measures decode + bookkeeping throughput on synthetic packets, no socket involved
+int bench(long count)
+{
+    std::vector<TelemetryPacket> packets(1024);
+    for (size_t i = 0; i < packets.size(); i++)
+    {
+        TelemetryPacket &packet = packets[i];
+        memset(&packet, 0, sizeof(packet));
+        packet.magic = kTelemetryMagic;
+        packet.version = kTelemetryVersion;
+        packet.portCount = kTelemetryPorts;
+        packet.size = sizeof(TelemetryPacket);
+        packet.chipId = 0x100000 + (i & 15);
+        packet.sequence = i / 16;
+        packet.ports[0].voltage_mV = 5000 + i;
+        packet.ports[0].flags = TELEMETRY_PORT_ACTIVE;
+    }
+
+    std::map<uint32_t, DeviceStats> devices;
+    TelemetryPacket decoded;
+    uint64_t checksum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (long i = 0; i < count; i++)
+    {
+        const TelemetryPacket &source = packets[i & 1023];
+        if (decodeTelemetryPacket(reinterpret_cast<const uint8_t *>(&source), sizeof(source), decoded))
+        {
+            track(devices, decoded);
+            checksum += decoded.ports[0].voltage_mV;
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    printf("{\"packets\":%ld,\"seconds\":%.6f,\"packetsPerSecond\":%.0f,\"nsPerPacket\":%.2f,\"checksum\":%llu}\n", count, seconds,
+           count / seconds, seconds * 1e9 / count, (unsigned long long)checksum);
+    return 0;
+}
+
+void usage(const char *name)
+{
+    fprintf(stderr, "usage: %s [--port N] [--group ADDR] [--quiet] | --bench [packets]\n", name);
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    uint16_t port = kTelemetryPort;
+    const char *group = nullptr;
+    bool quiet = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--bench"))
+        {
+            return bench(i + 1 < argc ? atol(argv[i + 1]) : 10000000);
+        }
+        else if (!strcmp(argv[i], "--port") && i + 1 < argc)
+        {
+            port = atoi(argv[++i]);
+        }
+        else if (!strcmp(argv[i], "--group") && i + 1 < argc)
+        {
+            group = argv[++i];
+        }
+        else if (!strcmp(argv[i], "--quiet"))
+        {
+            quiet = true;
+        }
+        else
+        {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0)
+    {
+        perror("socket");
+        return 1;
+    }
+
+    int yes = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0)
+    {
+        perror("bind");
+        return 1;
+    }
+
+    if (group)
+    {
+        ip_mreq membership = {};
+        if (inet_pton(AF_INET, group, &membership.imr_multiaddr) != 1)
+        {
+            fprintf(stderr, "invalid group %s\n", group);
+            return 2;
+        }
+        membership.imr_interface.s_addr = htonl(INADDR_ANY);
+        if (setsockopt(fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &membership, sizeof(membership)) < 0)
+        {
+            perror("IP_ADD_MEMBERSHIP");
+            return 1;
+        }
+    }
+
+    fprintf(stderr, "listening on udp/%u%s%s\n", port, group ? " group " : "", group ? group : "");
+
+    std::map<uint32_t, DeviceStats> devices;
+    uint8_t buffer[1500];
+    TelemetryPacket packet;
+    for (;;)
+    {
+        ssize_t length = recv(fd, buffer, sizeof(buffer), 0);
+        if (length < 0)
+        {
+            perror("recv");
+            return 1;
+        }
+        if (!decodeTelemetryPacket(buffer, length, packet))
+        {
+            continue;
+        }
+
+        track(devices, packet);
+        if (!quiet)
+        {
+            print(packet, devices[packet.chipId]);
+        }
+    }
+}